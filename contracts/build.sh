@@ -14,5 +14,30 @@ fi
 # -L=<string>              - Add directory to library search path
 # -R=<string>              - Add a resource path for inclusion
 
-#eosio.cdt v1.5.0
-eosio-cpp -I="./$contract/include/" -R="./$contract/resources" -o="./build/$contract/$contract.wasm" -contract="drealms" -abigen ./$contract/src/$contract.cpp
\ No newline at end of file
+if [[ "$2" == "native" ]]; then
+    # host build against the in-memory chain in ./native, one binary per ./$contract/bench/*.cpp
+    # CXX        - host compiler (default g++)
+    # CXXFLAGS   - extra compiler flags
+    cxx=${CXX:-g++}
+    out="./build/$contract/native"
+    mkdir -p $out
+
+    flags="-std=c++17 -O2 -Wno-attributes -I./native/include -I./$contract/include $CXXFLAGS"
+    $cxx $flags -c ./$contract/src/$contract.cpp -o $out/$contract.o || exit 1
+
+    for bench in ./$contract/bench/*.cpp; do
+        $cxx $flags -I./$contract/bench $bench $out/$contract.o -o $out/$(basename $bench .cpp) -lpthread || exit 1
+    done
+
+    exit 0
+fi
+
+if [[ "$2" == "profile" ]]; then
+    # wasm with per-action db and allocation counters printed to the console, see ./$contract/include/profile.hpp
+    mkdir -p ./build/$contract/profile
+    cdt-cpp -DDREALMS_PROFILE -I="./$contract/include/" -R="./$contract/resources" -o="./build/$contract/profile/$contract.wasm" -contract="drealms" -abigen ./$contract/src/$contract.cpp
+    exit 0
+fi
+
+#antelope cdt v3.0+ (action return values, read_only actions)
+cdt-cpp -I="./$contract/include/" -R="./$contract/resources" -o="./build/$contract/$contract.wasm" -contract="drealms" -abigen ./$contract/src/$contract.cpp
\ No newline at end of file
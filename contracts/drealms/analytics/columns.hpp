@@ -0,0 +1,747 @@
+// Columnar snapshots of drealms tables for offline analytics.
+//
+// The exporter decodes rows with rows.hpp and stores every field of the
+// schemas, licenses, nfts, currencies, accounts and holdings tables as its own
+// column. Map fields (settings, stats, uris, checksums) become child tables
+// with one row per entry, keyed by the row they belong to, and the stats of
+// v0 and v1 nft rows land in the same child table. Uris keep their stored
+// form, and a compressed uri is expanded with the uriprefixes table, one row
+// per prefix of each license owner (see stored_uri). Names are dictionary
+// encoded: a name column holds 32 bit indexes into the snapshot's sorted
+// name dictionary, so grouping and filtering by schema, owner or issuer
+// compares integers.
+//
+// A snapshot is read by mapping the file. Columns are typed views into the
+// mapping and nothing is decoded or copied until a query reads it. Layout,
+// little endian, every section 8 byte aligned:
+//
+//     header   magic, version, table count, name count, names offset, tables offset
+//     names    sorted uint64 name values
+//     tables   per table: name, row count, column count, then per column: name, type, offset, size
+//     columns  fixed width values, or for strings uint32 offsets[rows + 1] followed by the bytes
+//
+// Header only, no eosio dependency. Needs POSIX mmap.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../client/rows.hpp"
+
+namespace drealms_columns {
+
+    using drealms_client::name;
+    using drealms_client::decode_error;
+
+    constexpr uint32_t snapshot_magic = 0x4c435244; //"DRCL"
+    constexpr uint32_t snapshot_version = 1;
+
+    enum class column_type : uint32_t {
+        u8 = 1,
+        u16 = 2,
+        u32 = 3,
+        u64 = 4,
+        i64 = 5,
+        name_id = 6, //uint32 index into the name dictionary
+        string = 7
+    };
+
+    template<typename T> struct column_traits;
+    template<> struct column_traits<uint8_t> { static constexpr column_type type = column_type::u8; };
+    template<> struct column_traits<uint16_t> { static constexpr column_type type = column_type::u16; };
+    template<> struct column_traits<uint32_t> { static constexpr column_type type = column_type::u32; };
+    template<> struct column_traits<uint64_t> { static constexpr column_type type = column_type::u64; };
+    template<> struct column_traits<int64_t> { static constexpr column_type type = column_type::i64; };
+
+    //bytes per row, 0 for strings
+    inline size_t column_width(column_type type) {
+        switch (type) {
+            case column_type::u8 : return 1;
+            case column_type::u16 : return 2;
+            case column_type::u32 : return 4;
+            case column_type::u64 : return 8;
+            case column_type::i64 : return 8;
+            case column_type::name_id : return 4;
+            case column_type::string : return 0;
+        }
+        throw decode_error("unknown column type");
+    }
+
+    struct file_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t table_count;
+        uint32_t name_count;
+        uint64_t names_offset;
+        uint64_t tables_offset;
+    };
+
+    struct table_header {
+        uint64_t table_name;
+        uint64_t rows;
+        uint32_t column_count;
+        uint32_t reserved;
+    };
+
+    struct column_header {
+        uint64_t column_name;
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size; //bytes
+    };
+
+    //======================== export ========================
+
+    class exporter {
+
+    public:
+
+        exporter() {
+            using t = column_type;
+            declare("schemas", {{"schema", t::name_id}, {"issuer", t::name_id}, {"supply", t::u64}, {"issued", t::u64},
+                {"maxsupply", t::u64}, {"licmodel", t::name_id}, {"minlicense", t::u32}, {"maxlicense", t::u32},
+                {"expsymbol", t::u64}, {"payer", t::name_id}});
+            declare("schemasets", {{"schema", t::name_id}, {"setting", t::name_id}, {"value", t::u8}});
+            declare("schemastats", {{"schema", t::name_id}, {"stat", t::name_id}, {"value", t::u32}});
+
+            declare("licenses", {{"schema", t::name_id}, {"owner", t::name_id}, {"expiration", t::u32},
+                {"algo", t::string}, {"payer", t::name_id}});
+            declare("licenseuris", {{"schema", t::name_id}, {"owner", t::name_id}, {"base", t::u8},
+                {"uriname", t::name_id}, {"uri", t::string}});
+            declare("uriprefixes", {{"schema", t::name_id}, {"owner", t::name_id}, {"index", t::u8}, {"prefix", t::string}});
+
+            declare("nfts", {{"schema", t::name_id}, {"serial", t::u64}, {"owner", t::name_id}, {"level", t::u16},
+                {"exp", t::i64}, {"nextlevel", t::i64}, {"unspent", t::u8}, {"version", t::u8}, {"payer", t::name_id}});
+            declare("nftstats", {{"schema", t::name_id}, {"serial", t::u64}, {"stat", t::name_id}, {"value", t::u32}});
+            declare("nfturis", {{"schema", t::name_id}, {"serial", t::u64}, {"uriname", t::name_id}, {"uri", t::string}});
+            declare("nftchecksums", {{"schema", t::name_id}, {"serial", t::u64}, {"uriname", t::name_id}, {"checksum", t::string}});
+
+            declare("currencies", {{"symbol", t::u64}, {"issuer", t::name_id}, {"retirable", t::u8}, {"transferable", t::u8},
+                {"consumable", t::u8}, {"supply", t::i64}, {"maxsupply", t::i64}, {"payer", t::name_id}});
+            declare("accounts", {{"owner", t::name_id}, {"symbol", t::u64}, {"balance", t::i64}, {"payer", t::name_id}});
+            declare("holdings", {{"owner", t::name_id}, {"schema", t::name_id}, {"count", t::u64}, {"payer", t::name_id}});
+        }
+
+        //decodes one contract row into its table's columns, returns false for tables not exported
+        bool add_row(name table_name, uint64_t scope, name payer, std::string_view data) {
+            using namespace drealms_client;
+
+            if (table_name == name("nfts")) {
+                auto row = nonfungible_row::decode(data);
+                name schema_name(scope);
+                append("nfts").add_name(schema_name).add(row.serial).add_name(row.owner).add(row.level)
+                    .add(row.experience.amount).add(row.next_level.amount).add(row.unspent).add(row.row_version())
+                    .add_name(payer).end();
+
+                auto& stats = table("nftstats");
+                row.for_each_stat([&](name stat_name, uint32_t value) {
+                    row_writer(stats).add_name(schema_name).add(row.serial).add_name(stat_name).add(value).end();
+                });
+                auto& uris = table("nfturis");
+                for (auto& uri : row.relative_uris) {
+                    row_writer(uris).add_name(schema_name).add(row.serial).add_name(uri.first).add_string(uri.second).end();
+                }
+                auto& checksums = table("nftchecksums");
+                for (auto& checksum : row.checksums) {
+                    row_writer(checksums).add_name(schema_name).add(row.serial).add_name(checksum.first).add_string(checksum.second).end();
+                }
+            } else if (table_name == name("licenses")) {
+                auto row = license_row::decode(data);
+                name schema_name(scope);
+                append("licenses").add_name(schema_name).add_name(row.owner).add(row.expiration.utc_seconds)
+                    .add_string(row.checksum_algo).add_name(payer).end();
+
+                auto& uris = table("licenseuris");
+                for (auto& uri : row.full_uris) {
+                    row_writer(uris).add_name(schema_name).add_name(row.owner).add(uint8_t(0)).add_name(uri.first).add_string(uri.second).end();
+                }
+                for (auto& uri : row.base_uris) {
+                    row_writer(uris).add_name(schema_name).add_name(row.owner).add(uint8_t(1)).add_name(uri.first).add_string(uri.second).end();
+                }
+            } else if (table_name == name("uriprefixes")) {
+                auto row = uri_prefixes_row::decode(data);
+                for (uint32_t i = 0; i < row.count; ++i) {
+                    append("uriprefixes").add_name(name(scope)).add_name(row.owner).add(uint8_t(i)).add_string(*row.prefix(i)).end();
+                }
+            } else if (table_name == name("schemas")) {
+                auto row = schema_row::decode(data);
+                append("schemas").add_name(row.schema_name).add_name(row.issuer).add(row.supply).add(row.issued_supply)
+                    .add(row.max_supply).add_name(row.license_model).add(row.min_license_length).add(row.max_license_length)
+                    .add(row.exp_symbol.value).add_name(payer).end();
+
+                auto& settings = table("schemasets");
+                for (auto& setting : row.settings) {
+                    row_writer(settings).add_name(row.schema_name).add_name(setting.first).add(uint8_t(setting.second)).end();
+                }
+                auto& stats = table("schemastats");
+                for (auto& stat : row.default_stats) {
+                    row_writer(stats).add_name(row.schema_name).add_name(stat.first).add(stat.second).end();
+                }
+            } else if (table_name == name("currencies")) {
+                auto row = currency_row::decode(data);
+                append("currencies").add(row.supply.sym.value).add_name(row.issuer).add(uint8_t(row.retirable))
+                    .add(uint8_t(row.transferable)).add(uint8_t(row.consumable)).add(row.supply.amount)
+                    .add(row.max_supply.amount).add_name(payer).end();
+            } else if (table_name == name("accounts")) {
+                auto row = account_row::decode(data);
+                append("accounts").add_name(name(scope)).add(row.balance.sym.value).add(row.balance.amount).add_name(payer).end();
+            } else if (table_name == name("holdings")) {
+                auto row = holding_row::decode(data);
+                append("holdings").add_name(name(scope)).add_name(row.schema_name).add(row.count).add_name(payer).end();
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        //rows exported to a table so far
+        uint64_t rows(std::string_view table_name) { return table(table_name).rows; }
+
+        //writes the snapshot to path, replacing it only once complete
+        void write(const std::string& path) const {
+            //dictionary of every name held by a name column
+            std::vector<uint64_t> names;
+            for (auto& t : tables) {
+                for (auto& c : t.columns) {
+                    if (c.type == column_type::name_id) {
+                        const uint64_t* values = reinterpret_cast<const uint64_t*>(c.bytes.data());
+                        names.insert(names.end(), values, values + t.rows);
+                    }
+                }
+            }
+            std::sort(names.begin(), names.end());
+            names.erase(std::unique(names.begin(), names.end()), names.end());
+            if (names.size() > UINT32_MAX) {
+                throw decode_error("too many distinct names for one snapshot");
+            }
+
+            //layout
+            file_header header{snapshot_magic, snapshot_version, uint32_t(tables.size()), uint32_t(names.size()), 0, 0};
+            uint64_t at = sizeof(file_header);
+            header.names_offset = at;
+            at += names.size() * sizeof(uint64_t);
+            header.tables_offset = at;
+            for (auto& t : tables) {
+                at += sizeof(table_header) + t.columns.size() * sizeof(column_header);
+            }
+            std::vector<std::vector<column_header>> directory;
+            for (auto& t : tables) {
+                directory.emplace_back();
+                for (auto& c : t.columns) {
+                    at = align(at);
+                    uint64_t size = c.type == column_type::string ? c.offsets.size() * sizeof(uint32_t) + c.bytes.size()
+                        : t.rows * column_width(c.type);
+                    directory.back().push_back(column_header{c.column_name.value, uint32_t(c.type), 0, at, size});
+                    at += size;
+                }
+            }
+
+            std::string tmp = path + ".tmp";
+            FILE* f = fopen(tmp.c_str(), "wb");
+            if (!f) {
+                throw decode_error("cannot write snapshot " + tmp);
+            }
+
+            uint64_t written = 0;
+            bool ok = true;
+            auto put = [&](const void* data, size_t size) {
+                ok = ok && fwrite(data, 1, size, f) == size;
+                written += size;
+            };
+            auto pad_to = [&](uint64_t offset) {
+                static const char zeros[8] = {};
+                put(zeros, offset - written);
+            };
+
+            put(&header, sizeof(header));
+            put(names.data(), names.size() * sizeof(uint64_t));
+            for (size_t i = 0; i < tables.size(); ++i) {
+                table_header th{tables[i].table_name.value, tables[i].rows, uint32_t(tables[i].columns.size()), 0};
+                put(&th, sizeof(th));
+                put(directory[i].data(), directory[i].size() * sizeof(column_header));
+            }
+
+            std::vector<uint32_t> ids;
+            for (size_t i = 0; i < tables.size(); ++i) {
+                for (size_t k = 0; k < tables[i].columns.size(); ++k) {
+                    auto& c = tables[i].columns[k];
+                    pad_to(directory[i][k].offset);
+                    if (c.type == column_type::name_id) {
+                        const uint64_t* values = reinterpret_cast<const uint64_t*>(c.bytes.data());
+                        ids.resize(tables[i].rows);
+                        for (size_t row = 0; row < ids.size(); ++row) {
+                            ids[row] = uint32_t(std::lower_bound(names.begin(), names.end(), values[row]) - names.begin());
+                        }
+                        put(ids.data(), ids.size() * sizeof(uint32_t));
+                    } else if (c.type == column_type::string) {
+                        put(c.offsets.data(), c.offsets.size() * sizeof(uint32_t));
+                        put(c.bytes.data(), c.bytes.size());
+                    } else {
+                        put(c.bytes.data(), c.bytes.size());
+                    }
+                }
+            }
+            ok = (fclose(f) == 0) && ok;
+
+            if (!ok) {
+                remove(tmp.c_str());
+                throw decode_error("failed writing snapshot " + tmp);
+            }
+            if (rename(tmp.c_str(), path.c_str()) != 0) {
+                throw decode_error("cannot replace snapshot " + path);
+            }
+        }
+
+    private:
+
+        struct column_builder {
+            name column_name;
+            column_type type;
+            std::vector<char> bytes; //fixed width values, name columns hold name values until written
+            std::vector<uint32_t> offsets{0}; //string ends in bytes
+        };
+
+        struct table_builder {
+            name table_name;
+            uint64_t rows = 0;
+            std::vector<column_builder> columns;
+        };
+
+        //appends the fields of one row in declaration order
+        class row_writer {
+
+        public:
+
+            explicit row_writer(table_builder& table) : t(table) {}
+
+            template<typename T>
+            row_writer& add(T v) {
+                auto& c = next(column_traits<T>::type);
+                size_t at = c.bytes.size();
+                c.bytes.resize(at + sizeof(T));
+                memcpy(c.bytes.data() + at, &v, sizeof(T));
+                return *this;
+            }
+
+            row_writer& add_name(name v) {
+                auto& c = next(column_type::name_id);
+                size_t at = c.bytes.size();
+                c.bytes.resize(at + sizeof(uint64_t));
+                memcpy(c.bytes.data() + at, &v.value, sizeof(uint64_t));
+                return *this;
+            }
+
+            row_writer& add_string(std::string_view v) {
+                auto& c = next(column_type::string);
+                if (c.bytes.size() + v.size() > UINT32_MAX) {
+                    throw decode_error("string column " + c.column_name.to_string() + " is larger than 4 GB");
+                }
+                c.bytes.insert(c.bytes.end(), v.begin(), v.end());
+                c.offsets.push_back(uint32_t(c.bytes.size()));
+                return *this;
+            }
+
+            void end() {
+                if (index != t.columns.size()) {
+                    throw decode_error("row of " + t.table_name.to_string() + " is missing columns");
+                }
+                t.rows += 1;
+            }
+
+        private:
+
+            column_builder& next(column_type type) {
+                if (index >= t.columns.size() || t.columns[index].type != type) {
+                    throw decode_error("row of " + t.table_name.to_string() + " does not match its columns");
+                }
+                return t.columns[index++];
+            }
+
+            table_builder& t;
+            size_t index = 0;
+        };
+
+        void declare(std::string_view table_name, std::initializer_list<std::pair<std::string_view, column_type>> columns) {
+            table_builder t{name(table_name)};
+            for (auto& c : columns) {
+                t.columns.push_back(column_builder{name(c.first), c.second});
+            }
+            tables.push_back(std::move(t));
+        }
+
+        table_builder& table(std::string_view table_name) {
+            name n(table_name);
+            for (auto& t : tables) {
+                if (t.table_name == n) {
+                    return t;
+                }
+            }
+            throw decode_error("no exported table " + std::string(table_name));
+        }
+
+        row_writer append(std::string_view table_name) { return row_writer(table(table_name)); }
+
+        static uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+        std::vector<table_builder> tables;
+    };
+
+    //======================== read ========================
+
+    template<typename T>
+    class column {
+
+    public:
+
+        column() = default;
+
+        column(const T* values, size_t count) : values(values), count(count) {}
+
+        size_t size() const { return count; }
+
+        const T& operator[](size_t row) const { return values[row]; }
+
+        const T* begin() const { return values; }
+
+        const T* end() const { return values + count; }
+
+    private:
+
+        const T* values = nullptr;
+        size_t count = 0;
+    };
+
+    //dictionary encoded names, the dictionary is shared by every name column of a snapshot
+    class name_column {
+
+    public:
+
+        name_column() = default;
+
+        name_column(column<uint32_t> ids, column<uint64_t> dictionary) : ids(ids), dictionary(dictionary) {}
+
+        size_t size() const { return ids.size(); }
+
+        name operator[](size_t row) const { return name(dictionary[ids[row]]); }
+
+        //dictionary index of a row, equal names have equal ids
+        uint32_t id(size_t row) const { return ids[row]; }
+
+        //dictionary index of a name, nullopt if no name column of the snapshot holds it
+        std::optional<uint32_t> find(name n) const {
+            auto itr = std::lower_bound(dictionary.begin(), dictionary.end(), n.value);
+            if (itr == dictionary.end() || *itr != n.value) {
+                return std::nullopt;
+            }
+            return uint32_t(itr - dictionary.begin());
+        }
+
+        name name_of(uint32_t id) const { return name(dictionary[id]); }
+
+        size_t dictionary_size() const { return dictionary.size(); }
+
+    private:
+
+        column<uint32_t> ids;
+        column<uint64_t> dictionary;
+    };
+
+    class string_column {
+
+    public:
+
+        string_column() = default;
+
+        string_column(const uint32_t* offsets, const char* bytes, size_t count) : offsets(offsets), bytes(bytes), count(count) {}
+
+        size_t size() const { return count; }
+
+        std::string_view operator[](size_t row) const {
+            return std::string_view(bytes + offsets[row], offsets[row + 1] - offsets[row]);
+        }
+
+    private:
+
+        const uint32_t* offsets = nullptr;
+        const char* bytes = nullptr;
+        size_t count = 0;
+    };
+
+    class table_view {
+
+    public:
+
+        table_view(const char* base, const table_header* header, const column_header* columns, column<uint64_t> dictionary)
+            : base(base), header(header), columns(columns), dictionary(dictionary) {}
+
+        name table_name() const { return name(header->table_name); }
+
+        size_t size() const { return header->rows; }
+
+        size_t column_count() const { return header->column_count; }
+
+        template<typename T>
+        column<T> values(std::string_view column_name) const {
+            auto& c = find(column_name, column_traits<T>::type);
+            return column<T>(reinterpret_cast<const T*>(base + c.offset), size());
+        }
+
+        //checks every id against the dictionary
+        name_column names(std::string_view column_name) const {
+            auto& c = find(column_name, column_type::name_id);
+            column<uint32_t> ids(reinterpret_cast<const uint32_t*>(base + c.offset), size());
+            for (auto id : ids) {
+                if (id >= dictionary.size()) {
+                    throw decode_error("name id out of range in column " + std::string(column_name));
+                }
+            }
+            return name_column(ids, dictionary);
+        }
+
+        //checks every offset against the column's bytes
+        string_column strings(std::string_view column_name) const {
+            auto& c = find(column_name, column_type::string);
+            uint64_t bytes = c.size - (size() + 1) * sizeof(uint32_t);
+            const uint32_t* offsets = reinterpret_cast<const uint32_t*>(base + c.offset);
+            for (size_t row = 0; row < size(); ++row) {
+                if (offsets[row] > offsets[row + 1]) {
+                    throw decode_error("string offsets out of order in column " + std::string(column_name));
+                }
+            }
+            if (offsets[0] != 0 || offsets[size()] != bytes) {
+                throw decode_error("string offsets out of range in column " + std::string(column_name));
+            }
+            return string_column(offsets, base + c.offset + (size() + 1) * sizeof(uint32_t), size());
+        }
+
+    private:
+
+        const column_header& find(std::string_view column_name, column_type type) const {
+            name n(column_name);
+            for (uint32_t i = 0; i < header->column_count; ++i) {
+                if (columns[i].column_name == n.value) {
+                    if (column_type(columns[i].type) != type) {
+                        throw decode_error("column " + std::string(column_name) + " has another type");
+                    }
+                    return columns[i];
+                }
+            }
+            throw decode_error("no column " + std::string(column_name) + " in " + table_name().to_string());
+        }
+
+        const char* base;
+        const table_header* header;
+        const column_header* columns;
+        column<uint64_t> dictionary;
+    };
+
+    //read only mapping of a snapshot file
+    class snapshot {
+
+    public:
+
+        explicit snapshot(const std::string& path) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw decode_error("cannot open snapshot " + path);
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(file_header)) {
+                close(fd);
+                throw decode_error("not a drealms snapshot: " + path);
+            }
+            length = size_t(st.st_size);
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                throw decode_error("cannot map snapshot " + path);
+            }
+            base = static_cast<const char*>(mapped);
+
+            try {
+                index(path);
+            } catch (...) {
+                munmap(mapped, length);
+                throw;
+            }
+        }
+
+        ~snapshot() {
+            munmap(const_cast<char*>(base), length);
+        }
+
+        snapshot(const snapshot&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+
+        size_t bytes() const { return length; }
+
+        const std::vector<table_view>& tables() const { return views; }
+
+        bool has_table(std::string_view table_name) const {
+            name n(table_name);
+            return std::any_of(views.begin(), views.end(), [&](auto& t) { return t.table_name() == n; });
+        }
+
+        const table_view& table(std::string_view table_name) const {
+            name n(table_name);
+            for (auto& t : views) {
+                if (t.table_name() == n) {
+                    return t;
+                }
+            }
+            throw decode_error("no table " + std::string(table_name) + " in snapshot");
+        }
+
+    private:
+
+        //checks the header and that every column lies inside the file
+        void index(const std::string& path) {
+            auto& header = *reinterpret_cast<const file_header*>(base);
+            if (header.magic != snapshot_magic || header.version != snapshot_version) {
+                throw decode_error("not a drealms snapshot: " + path);
+            }
+            auto require = [&](uint64_t offset, uint64_t size) {
+                if (offset % 8 != 0 || offset > length || size > length - offset) {
+                    throw decode_error("truncated snapshot " + path);
+                }
+            };
+
+            require(header.names_offset, uint64_t(header.name_count) * sizeof(uint64_t));
+            column<uint64_t> dictionary(reinterpret_cast<const uint64_t*>(base + header.names_offset), header.name_count);
+
+            uint64_t at = header.tables_offset;
+            for (uint32_t i = 0; i < header.table_count; ++i) {
+                require(at, sizeof(table_header));
+                auto* th = reinterpret_cast<const table_header*>(base + at);
+                at += sizeof(table_header);
+                require(at, uint64_t(th->column_count) * sizeof(column_header));
+                auto* columns = reinterpret_cast<const column_header*>(base + at);
+                at += th->column_count * sizeof(column_header);
+
+                for (uint32_t k = 0; k < th->column_count; ++k) {
+                    auto& c = columns[k];
+                    require(c.offset, c.size);
+                    size_t width = column_width(column_type(c.type));
+                    bool fits = width > 0 ? c.size == th->rows * width : c.size >= (th->rows + 1) * sizeof(uint32_t);
+                    if (!fits) {
+                        throw decode_error("column size does not match its rows in " + path);
+                    }
+                }
+                views.emplace_back(base, th, columns, dictionary);
+            }
+        }
+
+        const char* base = nullptr;
+        size_t length = 0;
+        std::vector<table_view> views;
+    };
+
+    //======================== aggregates ========================
+
+    struct summary {
+        uint64_t count = 0;
+        double sum = 0;
+        double min = 0;
+        double max = 0;
+
+        void add(double v) {
+            min = count == 0 ? v : std::min(min, v);
+            max = count == 0 ? v : std::max(max, v);
+            sum += v;
+            count += 1;
+        }
+
+        double mean() const { return count ? sum / count : 0; }
+    };
+
+    //default filter, keeps every row
+    inline bool all_rows(size_t) { return true; }
+
+    using row_filter = bool (*)(size_t);
+
+    //summary of values per name, in name order, skipping rows where keep(row) is false
+    template<typename V, typename Keep = row_filter>
+    std::vector<std::pair<name, summary>> group_by(const name_column& keys, const column<V>& values, Keep keep = all_rows) {
+        std::vector<summary> groups(keys.dictionary_size());
+        for (size_t row = 0; row < keys.size(); ++row) {
+            if (keep(row)) {
+                groups[keys.id(row)].add(double(values[row]));
+            }
+        }
+
+        std::vector<std::pair<name, summary>> out;
+        for (uint32_t id = 0; id < groups.size(); ++id) {
+            if (groups[id].count > 0) {
+                out.emplace_back(keys.name_of(id), groups[id]);
+            }
+        }
+        return out;
+    }
+
+    //summary of values per distinct key, in key order
+    template<typename K, typename V, typename Keep = row_filter>
+    std::vector<std::pair<K, summary>> group_by(const column<K>& keys, const column<V>& values, Keep keep = all_rows) {
+        std::unordered_map<K, summary> groups;
+        for (size_t row = 0; row < keys.size(); ++row) {
+            if (keep(row)) {
+                groups[keys[row]].add(double(values[row]));
+            }
+        }
+
+        std::vector<std::pair<K, summary>> out(groups.begin(), groups.end());
+        std::sort(out.begin(), out.end(), [](auto& a, auto& b) { return a.first < b.first; });
+        return out;
+    }
+
+    //distinct values per name, e.g. holders per schema from the schema and owner columns of nfts
+    template<typename Keep = row_filter>
+    std::vector<std::pair<name, uint64_t>> count_distinct(const name_column& keys, const name_column& values, Keep keep = all_rows) {
+        std::vector<uint64_t> pairs;
+        pairs.reserve(keys.size());
+        for (size_t row = 0; row < keys.size(); ++row) {
+            if (keep(row)) {
+                pairs.push_back(uint64_t(keys.id(row)) << 32 | values.id(row));
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        std::vector<std::pair<name, uint64_t>> out;
+        for (auto p : pairs) {
+            name key = keys.name_of(uint32_t(p >> 32));
+            if (out.empty() || out.back().first != key) {
+                out.emplace_back(key, 0);
+            }
+            out.back().second += 1;
+        }
+        return out;
+    }
+
+    //rows per bucket of width, keyed by the lowest value of the bucket
+    template<typename V, typename Keep = row_filter>
+    std::map<V, uint64_t> histogram(const column<V>& values, V width, Keep keep = all_rows) {
+        std::unordered_map<V, uint64_t> buckets;
+        for (size_t row = 0; row < values.size(); ++row) {
+            if (keep(row)) {
+                V v = values[row];
+                V offset = V(v % width);
+                buckets[V(v - (offset < 0 ? offset + width : offset))] += 1;
+            }
+        }
+        return std::map<V, uint64_t>(buckets.begin(), buckets.end());
+    }
+
+}
@@ -0,0 +1,910 @@
+// Compiled Application Token Interface documents.
+//
+// A license points games at an ATI, a JSON document describing the fields of
+// the schema's NFTs. Interpreting that JSON on every load means parsing it,
+// walking the interface tree and turning every key into the row field it
+// names. compile() does that once and writes a flat binary document: every
+// interface leaf becomes a fixed size record holding its dotted path, its
+// declared type and the nonfungible row field it reads (serial, owner, a
+// stat, a relative uri, ...), with stat and uri keys already encoded as
+// names. The sha256 of the compiled bytes is what setati pins on the
+// license, so a game can check the document it fetched is the one the
+// license owner published.
+//
+// A document is read by mapping the file, checking its bounds, and binding
+// its records to rows decoded with client/rows.hpp. Nothing is parsed or
+// allocated while binding. Hashing the file costs more than parsing the
+// json it came from, so the hash is checked once, when a game sees a new
+// pin on the license: pin() verifies the fetched document and stores it
+// under its hex digest, and later loads map the stored copy unhashed. Layout, every integer little endian and
+// every section 8 byte aligned:
+//
+//     header   magic, version, field count, meta count, fields offset, meta offset, strings offset, strings size
+//     fields   per field: path offset, path size, type, source, key
+//     meta     per entry: key offset, key size, value offset, value size (engine.name, license.owner, ...)
+//     strings  path, key and value bytes, not terminated
+//
+// compile() writes the layout byte by byte, so it runs on any host; reading
+// maps the records in place and needs a little endian host. Header only, no
+// eosio dependency. Needs POSIX mmap.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../client/rows.hpp"
+
+namespace drealms_ati {
+
+    using drealms_client::name;
+    using drealms_client::decode_error;
+
+    constexpr uint32_t ati_magic = 0x54415244; //"DRAT"
+    constexpr uint32_t ati_version = 1;
+
+    //declared type of an interface field, integers are widened when bound
+    enum class field_type : uint8_t {
+        other = 0, //types this version does not know, and arrays
+        u8 = 1,
+        u16 = 2,
+        u32 = 3,
+        u64 = 4,
+        i64 = 5,
+        name = 6,
+        string = 7,
+        asset = 8
+    };
+
+    //nonfungible row field an interface field reads
+    enum class field_source : uint8_t {
+        none = 0, //not stored on chain, left to the game
+        serial = 1,
+        owner = 2,
+        level = 3,
+        experience = 4,
+        next_level = 5,
+        unspent = 6,
+        stat = 7, //key is the stat name
+        relative_uri = 8, //key is the uri name
+        checksum = 9 //key is the checksum name
+    };
+
+    struct file_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t field_count;
+        uint32_t meta_count;
+        uint64_t fields_offset;
+        uint64_t meta_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+    };
+
+    struct field_record {
+        uint32_t path_offset; //into strings
+        uint32_t path_size;
+        field_type type;
+        field_source source;
+        uint16_t reserved;
+        uint32_t padding;
+        uint64_t key; //name value for stat, relative_uri and checksum sources
+    };
+
+    struct meta_record {
+        uint32_t key_offset;
+        uint32_t key_size;
+        uint32_t value_offset;
+        uint32_t value_size;
+    };
+
+    static_assert(sizeof(file_header) == 48 && sizeof(field_record) == 24 && sizeof(meta_record) == 16,
+        "ati records are mapped in place");
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "ati records are little endian and mapped in place");
+
+    inline uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+    //======================== sha256 ========================
+
+    using checksum256 = std::array<uint8_t, 32>;
+
+    class sha256 {
+
+    public:
+
+        sha256() : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+        void update(const void* data, size_t size) {
+            auto* bytes = static_cast<const uint8_t*>(data);
+            total += size;
+            if (buffered > 0) {
+                size_t take = std::min(size, sizeof(block) - buffered);
+                memcpy(block + buffered, bytes, take);
+                buffered += take;
+                bytes += take;
+                size -= take;
+                if (buffered < sizeof(block)) {
+                    return;
+                }
+                compress(block);
+                buffered = 0;
+            }
+            for (; size >= sizeof(block); bytes += sizeof(block), size -= sizeof(block)) {
+                compress(bytes);
+            }
+            memcpy(block, bytes, size);
+            buffered = size;
+        }
+
+        checksum256 finish() {
+            uint64_t bits = total * 8;
+            uint8_t pad = 0x80;
+            update(&pad, 1);
+            pad = 0;
+            while (buffered != 56) {
+                update(&pad, 1);
+            }
+            uint8_t length[8];
+            for (int i = 0; i < 8; ++i) {
+                length[i] = uint8_t(bits >> (56 - 8 * i));
+            }
+            update(length, 8);
+
+            checksum256 digest;
+            for (int i = 0; i < 32; ++i) {
+                digest[i] = uint8_t(state[i / 4] >> (24 - 8 * (i % 4)));
+            }
+            return digest;
+        }
+
+        static checksum256 hash(const void* data, size_t size) {
+            sha256 h;
+            h.update(data, size);
+            return h.finish();
+        }
+
+    private:
+
+        static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        void compress(const uint8_t* chunk) {
+            static const uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+            };
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = uint32_t(chunk[4 * i]) << 24 | uint32_t(chunk[4 * i + 1]) << 16 | uint32_t(chunk[4 * i + 2]) << 8 | chunk[4 * i + 3];
+            }
+            for (int i = 16; i < 64; ++i) {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i) {
+                uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+
+        uint32_t state[8];
+        uint8_t block[64];
+        size_t buffered = 0;
+        uint64_t total = 0;
+    };
+
+    inline std::string to_hex(const checksum256& digest) {
+        static const char* digits = "0123456789abcdef";
+        std::string hex;
+        for (auto b : digest) {
+            hex += digits[b >> 4];
+            hex += digits[b & 0x0f];
+        }
+        return hex;
+    }
+
+    inline checksum256 from_hex(std::string_view hex) {
+        auto nibble = [](char c) -> uint8_t {
+            if (c >= '0' && c <= '9') return uint8_t(c - '0');
+            if (c >= 'a' && c <= 'f') return uint8_t(c - 'a' + 10);
+            if (c >= 'A' && c <= 'F') return uint8_t(c - 'A' + 10);
+            throw decode_error("checksum is not hex");
+        };
+        if (hex.size() != 64) {
+            throw decode_error("checksum must be 64 hex characters");
+        }
+        checksum256 digest;
+        for (size_t i = 0; i < 32; ++i) {
+            digest[i] = uint8_t(nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]));
+        }
+        return digest;
+    }
+
+    //======================== json ========================
+
+    //just enough json for ati documents, numbers are kept as their text
+    struct json_value {
+        enum class kind { null, boolean, number, string, array, object };
+
+        kind type = kind::null;
+        std::string text; //string, number or boolean text
+        std::vector<json_value> items; //array elements, or object values
+        std::vector<std::string> keys; //object keys, in document order
+
+        const json_value* find(std::string_view key) const {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (keys[i] == key) {
+                    return &items[i];
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    class json_parser {
+
+    public:
+
+        static json_value parse(std::string_view text) {
+            json_parser p(text);
+            json_value v = p.value();
+            p.space();
+            if (p.at != p.text.size()) {
+                p.fail("unexpected data after document");
+            }
+            return v;
+        }
+
+    private:
+
+        explicit json_parser(std::string_view text) : text(text) {}
+
+        [[noreturn]] void fail(const char* what) const {
+            throw decode_error(std::string("ati json: ") + what + " at offset " + std::to_string(at));
+        }
+
+        void space() {
+            while (at < text.size() && (text[at] == ' ' || text[at] == '\t' || text[at] == '\n' || text[at] == '\r')) {
+                ++at;
+            }
+        }
+
+        bool take(char c) {
+            space();
+            if (at < text.size() && text[at] == c) {
+                ++at;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c) {
+            if (!take(c)) {
+                fail("unexpected character");
+            }
+        }
+
+        json_value value() {
+            space();
+            if (at >= text.size()) {
+                fail("unexpected end of document");
+            }
+            json_value v;
+            char c = text[at];
+            if (c == '{') {
+                ++at;
+                v.type = json_value::kind::object;
+                if (!take('}')) {
+                    do {
+                        space();
+                        v.keys.push_back(string());
+                        expect(':');
+                        v.items.push_back(value());
+                    } while (take(','));
+                    expect('}');
+                }
+            } else if (c == '[') {
+                ++at;
+                v.type = json_value::kind::array;
+                if (!take(']')) {
+                    do {
+                        v.items.push_back(value());
+                    } while (take(','));
+                    expect(']');
+                }
+            } else if (c == '"') {
+                v.type = json_value::kind::string;
+                v.text = string();
+            } else if (literal("true")) {
+                v.type = json_value::kind::boolean;
+                v.text = "true";
+            } else if (literal("false")) {
+                v.type = json_value::kind::boolean;
+                v.text = "false";
+            } else if (literal("null")) {
+                v.type = json_value::kind::null;
+            } else {
+                size_t start = at;
+                while (at < text.size() && (isdigit(uint8_t(text[at])) || strchr("+-.eE", text[at]))) {
+                    ++at;
+                }
+                if (start == at) {
+                    fail("unexpected character");
+                }
+                v.type = json_value::kind::number;
+                v.text = std::string(text.substr(start, at - start));
+            }
+            return v;
+        }
+
+        bool literal(std::string_view word) {
+            if (text.substr(at, word.size()) == word) {
+                at += word.size();
+                return true;
+            }
+            return false;
+        }
+
+        std::string string() {
+            if (at >= text.size() || text[at] != '"') {
+                fail("expected string");
+            }
+            ++at;
+            std::string out;
+            while (true) {
+                if (at >= text.size()) {
+                    fail("unterminated string");
+                }
+                char c = text[at++];
+                if (c == '"') {
+                    return out;
+                }
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (at >= text.size()) {
+                    fail("unterminated string");
+                }
+                char e = text[at++];
+                switch (e) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': {
+                        uint32_t cp = hex4();
+                        //a utf-16 surrogate pair is one code point
+                        if (cp >= 0xd800 && cp < 0xdc00) {
+                            if (!literal("\\u")) {
+                                fail("unpaired surrogate in unicode escape");
+                            }
+                            uint32_t low = hex4();
+                            if (low < 0xdc00 || low >= 0xe000) {
+                                fail("unpaired surrogate in unicode escape");
+                            }
+                            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                        } else if (cp >= 0xdc00 && cp < 0xe000) {
+                            fail("unpaired surrogate in unicode escape");
+                        }
+                        utf8(out, cp);
+                        break;
+                    }
+                    default: out += e; break;
+                }
+            }
+        }
+
+        //the 4 hex digits of a unicode escape
+        uint32_t hex4() {
+            if (at + 4 > text.size()) {
+                fail("short unicode escape");
+            }
+            uint32_t cp = 0;
+            for (size_t end = at + 4; at < end; ++at) {
+                char c = text[at];
+                uint32_t digit;
+                if (c >= '0' && c <= '9') {
+                    digit = uint32_t(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = uint32_t(c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    digit = uint32_t(c - 'A' + 10);
+                } else {
+                    fail("invalid unicode escape");
+                }
+                cp = cp << 4 | digit;
+            }
+            return cp;
+        }
+
+        static void utf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out += char(cp);
+            } else if (cp < 0x800) {
+                out += char(0xc0 | (cp >> 6));
+                out += char(0x80 | (cp & 0x3f));
+            } else if (cp < 0x10000) {
+                out += char(0xe0 | (cp >> 12));
+                out += char(0x80 | ((cp >> 6) & 0x3f));
+                out += char(0x80 | (cp & 0x3f));
+            } else {
+                out += char(0xf0 | (cp >> 18));
+                out += char(0x80 | ((cp >> 12) & 0x3f));
+                out += char(0x80 | ((cp >> 6) & 0x3f));
+                out += char(0x80 | (cp & 0x3f));
+            }
+        }
+
+        std::string_view text;
+        size_t at = 0;
+    };
+
+    //======================== compiler ========================
+
+    //"uint16_t", "uint16" and "u16" are the same type
+    inline field_type parse_type(const json_value& v) {
+        if (v.type != json_value::kind::string) {
+            return field_type::other;
+        }
+        std::string t = v.text;
+        if (t.size() > 2 && t.compare(t.size() - 2, 2, "_t") == 0) {
+            t.resize(t.size() - 2);
+        }
+        if (t == "uint8" || t == "u8" || t == "bool") return field_type::u8;
+        if (t == "uint16" || t == "u16") return field_type::u16;
+        if (t == "uint32" || t == "u32") return field_type::u32;
+        if (t == "uint64" || t == "u64") return field_type::u64;
+        if (t == "int8" || t == "int16" || t == "int32" || t == "int64") return field_type::i64;
+        if (t == "name") return field_type::name;
+        if (t == "string") return field_type::string;
+        if (t == "asset") return field_type::asset;
+        return field_type::other;
+    }
+
+    //top level interface keys read straight off the row
+    inline field_source row_source(std::string_view key) {
+        if (key == "nft_id" || key == "serial") return field_source::serial;
+        if (key == "owner") return field_source::owner;
+        if (key == "level") return field_source::level;
+        if (key == "experience") return field_source::experience;
+        if (key == "next_level") return field_source::next_level;
+        if (key == "unspent") return field_source::unspent;
+        return field_source::none;
+    }
+
+    //top level interface objects whose keys are row map keys
+    inline field_source map_source(std::string_view key) {
+        if (key == "stats") return field_source::stat;
+        if (key == "uris" || key == "relative_uris") return field_source::relative_uri;
+        if (key == "checksums") return field_source::checksum;
+        return field_source::none;
+    }
+
+    class compiler {
+
+    public:
+
+        //compiles an ati json document to the binary layout
+        static std::string compile(std::string_view json) {
+            json_value doc = json_parser::parse(json);
+            if (doc.type != json_value::kind::object) {
+                throw decode_error("ati json: document is not an object");
+            }
+            const json_value* interface = doc.find("interface");
+            if (!interface || interface->type != json_value::kind::object) {
+                throw decode_error("ati json: document has no interface object");
+            }
+
+            compiler c;
+            for (size_t i = 0; i < doc.keys.size(); ++i) {
+                if (doc.keys[i] != "interface") {
+                    c.add_meta(doc.keys[i], doc.items[i]);
+                }
+            }
+            for (size_t i = 0; i < interface->keys.size(); ++i) {
+                auto& key = interface->keys[i];
+                auto& value = interface->items[i];
+                field_source from = map_source(key);
+                if (from != field_source::none && value.type == json_value::kind::object) {
+                    size_t first = c.fields.size();
+                    for (size_t k = 0; k < value.keys.size(); ++k) {
+                        c.add_field(key + "." + value.keys[k], parse_type(value.items[k]), from, name(value.keys[k]).value);
+                    }
+                    //in row map order, so binding walks each row map once
+                    std::stable_sort(c.fields.begin() + first, c.fields.end(), [](auto& a, auto& b) { return a.key < b.key; });
+                } else {
+                    c.add_fields(key, value, row_source(key));
+                }
+            }
+            return c.write();
+        }
+
+    private:
+
+        //objects are flattened to dotted paths, arrays are left to the game as one field
+        void add_fields(const std::string& path, const json_value& v, field_source from) {
+            if (v.type == json_value::kind::object) {
+                for (size_t i = 0; i < v.keys.size(); ++i) {
+                    add_fields(path + "." + v.keys[i], v.items[i], field_source::none);
+                }
+                return;
+            }
+            add_field(path, parse_type(v), from, 0);
+        }
+
+        void add_field(const std::string& path, field_type type, field_source from, uint64_t key) {
+            field_record r{};
+            r.path_offset = add_string(path);
+            r.path_size = uint32_t(path.size());
+            r.type = type;
+            r.source = from;
+            r.key = key;
+            fields.push_back(r);
+        }
+
+        void add_meta(const std::string& path, const json_value& v) {
+            if (v.type == json_value::kind::object || v.type == json_value::kind::array) {
+                for (size_t i = 0; i < v.items.size(); ++i) {
+                    add_meta(path + "." + (v.type == json_value::kind::object ? v.keys[i] : std::to_string(i)), v.items[i]);
+                }
+                return;
+            }
+            meta_record r{};
+            r.key_offset = add_string(path);
+            r.key_size = uint32_t(path.size());
+            r.value_offset = add_string(v.text);
+            r.value_size = uint32_t(v.text.size());
+            meta.push_back(r);
+        }
+
+        uint32_t add_string(const std::string& s) {
+            if (strings.size() + s.size() > UINT32_MAX) {
+                throw decode_error("ati document is too large");
+            }
+            uint32_t offset = uint32_t(strings.size());
+            strings += s;
+            return offset;
+        }
+
+        std::string write() const {
+            file_header header{ati_magic, ati_version, uint32_t(fields.size()), uint32_t(meta.size()), 0, 0, 0, strings.size()};
+            uint64_t at = sizeof(file_header);
+            header.fields_offset = at;
+            at += fields.size() * sizeof(field_record);
+            header.meta_offset = at;
+            at += meta.size() * sizeof(meta_record);
+            header.strings_offset = at;
+            at = align(at + strings.size());
+
+            std::string out(at, '\0');
+            char* w = &out[0];
+            put(w, header.magic, header.version, header.field_count, header.meta_count,
+                header.fields_offset, header.meta_offset, header.strings_offset, header.strings_size);
+            for (auto& f : fields) {
+                put(w, f.path_offset, f.path_size, uint8_t(f.type), uint8_t(f.source), f.reserved, f.padding, f.key);
+            }
+            for (auto& m : meta) {
+                put(w, m.key_offset, m.key_size, m.value_offset, m.value_size);
+            }
+            memcpy(w, strings.data(), strings.size());
+            return out;
+        }
+
+        //writes each integer little endian, whatever the host's byte order
+        template<typename... Ints>
+        static void put(char*& w, Ints... values) {
+            auto one = [&](auto v) {
+                for (size_t i = 0; i < sizeof(v); ++i) {
+                    *w++ = char(uint64_t(v) >> (8 * i));
+                }
+            };
+            (one(values), ...);
+        }
+
+        std::vector<field_record> fields;
+        std::vector<meta_record> meta;
+        std::string strings;
+    };
+
+    inline std::string compile(std::string_view json) {
+        return compiler::compile(json);
+    }
+
+    //======================== reader ========================
+
+    //value of one field bound to a row, present is false for unbound fields and missing map keys
+    struct bound_value {
+        bool present = false;
+        uint64_t number = 0; //integers, and name values
+        std::string_view text; //relative uris and checksums, views into the row buffer
+        std::string_view prefix; //of a compressed relative uri, the uri is prefix then text
+        drealms_client::asset amount;
+    };
+
+    //splits a stored relative uri into the value's prefix and text
+    inline void bind_uri(bound_value& v, std::string_view stored, const drealms_client::uri_prefixes_row* prefixes) {
+        auto uri = drealms_client::stored_uri::parse(stored);
+        v.text = uri.rest;
+        if (uri.prefix_index) {
+            auto prefix = prefixes ? prefixes->prefix(*uri.prefix_index) : std::nullopt;
+            if (!prefix) {
+                throw decode_error("relative uri needs the license owner's uri prefixes");
+            }
+            v.prefix = *prefix;
+        }
+    }
+
+    //reads the source of a record from a decoded row, prefixes are the license owner's uri prefixes if any
+    inline bound_value bind_field(const field_record& f, const drealms_client::nonfungible_row& row,
+        const drealms_client::uri_prefixes_row* prefixes = nullptr) {
+        bound_value v;
+        switch (f.source) {
+            case field_source::none: return v;
+            case field_source::serial: v.number = row.serial; break;
+            case field_source::owner: v.number = row.owner.value; break;
+            case field_source::level: v.number = row.level; break;
+            case field_source::experience: v.amount = row.experience; break;
+            case field_source::next_level: v.amount = row.next_level; break;
+            case field_source::unspent: v.number = row.unspent; break;
+            case field_source::stat: {
+                auto s = row.stat(name(f.key));
+                if (!s) {
+                    return v;
+                }
+                v.number = *s;
+                break;
+            }
+            case field_source::relative_uri:
+            case field_source::checksum: {
+                auto& m = f.source == field_source::relative_uri ? row.relative_uris : row.checksums;
+                auto s = m.find(name(f.key));
+                if (!s) {
+                    return v;
+                }
+                if (f.source == field_source::relative_uri) {
+                    bind_uri(v, *s, prefixes);
+                } else {
+                    v.text = *s;
+                }
+                break;
+            }
+        }
+        v.present = true;
+        return v;
+    }
+
+    //forward walk over a row map for keys asked in ascending order, restarts if a key goes back
+    template<typename Map>
+    class map_cursor {
+
+    public:
+
+        explicit map_cursor(const Map& m) : map(m), at(m.begin()) {}
+
+        std::optional<typename Map::mapped_type> seek(uint64_t key) {
+            if (key < last) {
+                at = map.begin();
+            }
+            last = key;
+            while (at != map.end() && at->first.value < key) {
+                ++at;
+            }
+            if (at != map.end() && at->first.value == key) {
+                return at->second;
+            }
+            return std::nullopt;
+        }
+
+    private:
+
+        const Map& map;
+        typename Map::iterator at;
+        uint64_t last = 0;
+    };
+
+    class document {
+
+    public:
+
+        //maps a compiled document, and fails unless its sha256 is expected_hash when one is given
+        explicit document(const std::string& path, const checksum256* expected_hash = nullptr) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw decode_error("cannot open ati " + path);
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(file_header)) {
+                close(fd);
+                throw decode_error("not a compiled ati: " + path);
+            }
+            length = size_t(st.st_size);
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                throw decode_error("cannot map ati " + path);
+            }
+            base = static_cast<const char*>(mapped);
+
+            try {
+                if (expected_hash && sha256::hash(base, length) != *expected_hash) {
+                    throw decode_error("ati " + path + " does not match the hash pinned on the license");
+                }
+                index(path);
+            } catch (...) {
+                munmap(mapped, length);
+                throw;
+            }
+        }
+
+        ~document() {
+            munmap(const_cast<char*>(base), length);
+        }
+
+        document(const document&) = delete;
+        document& operator=(const document&) = delete;
+
+        size_t bytes() const { return length; }
+
+        std::string_view data() const { return std::string_view(base, length); }
+
+        checksum256 hash() const { return sha256::hash(base, length); }
+
+        uint32_t field_count() const { return header().field_count; }
+
+        const field_record& field(uint32_t i) const { return fields[i]; }
+
+        std::string_view path(const field_record& f) const { return string(f.path_offset, f.path_size); }
+
+        //metadata value, like meta("license.owner"), empty if absent
+        std::string_view meta(std::string_view key) const {
+            for (uint32_t i = 0; i < header().meta_count; ++i) {
+                if (string(metas[i].key_offset, metas[i].key_size) == key) {
+                    return string(metas[i].value_offset, metas[i].value_size);
+                }
+            }
+            return {};
+        }
+
+        //calls f(const field_record&, bound_value) for every interface field in compiled order: document order,
+        //except that the fields of the stats, uris and checksums objects are sorted by name value,
+        //prefixes are the uri prefixes of the license owner the document belongs to, if any
+        template<typename F>
+        void bind(const drealms_client::nonfungible_row& row, F&& f, const drealms_client::uri_prefixes_row* prefixes = nullptr) const {
+            //map fields are sorted by key, so each row map is walked once rather than once per field
+            map_cursor stats(row.stats);
+            std::optional<map_cursor<drealms_client::map_view<name, drealms_client::varuint32>>> packed;
+            if (row.packed_stats) {
+                packed.emplace(*row.packed_stats);
+            }
+            map_cursor uris(row.relative_uris);
+            map_cursor checksums(row.checksums);
+
+            for (uint32_t i = 0; i < header().field_count; ++i) {
+                auto& field = fields[i];
+                bound_value v;
+                if (field.source == field_source::stat) {
+                    auto s = packed ? packed->seek(field.key) : std::nullopt;
+                    if (!s) {
+                        s = stats.seek(field.key);
+                    }
+                    v.present = s.has_value();
+                    v.number = s.value_or(0);
+                } else if (field.source == field_source::relative_uri) {
+                    auto s = uris.seek(field.key);
+                    v.present = s.has_value();
+                    if (s) {
+                        bind_uri(v, *s, prefixes);
+                    }
+                } else if (field.source == field_source::checksum) {
+                    auto s = checksums.seek(field.key);
+                    v.present = s.has_value();
+                    v.text = s.value_or(std::string_view());
+                } else {
+                    v = bind_field(field, row, prefixes);
+                }
+                f(field, v);
+            }
+        }
+
+    private:
+
+        const file_header& header() const { return *reinterpret_cast<const file_header*>(base); }
+
+        std::string_view string(uint32_t offset, uint32_t size) const { return std::string_view(strings + offset, size); }
+
+        //checks the header and that every record and string lies inside the file
+        void index(const std::string& path) {
+            auto& h = header();
+            if (h.magic != ati_magic || h.version != ati_version) {
+                throw decode_error("not a compiled ati: " + path);
+            }
+            auto require = [&](uint64_t offset, uint64_t size, uint64_t alignment) {
+                if (offset % alignment != 0 || offset > length || size > length - offset) {
+                    throw decode_error("truncated ati " + path);
+                }
+            };
+            require(h.fields_offset, uint64_t(h.field_count) * sizeof(field_record), 8);
+            require(h.meta_offset, uint64_t(h.meta_count) * sizeof(meta_record), 4);
+            require(h.strings_offset, h.strings_size, 1);
+            fields = reinterpret_cast<const field_record*>(base + h.fields_offset);
+            metas = reinterpret_cast<const meta_record*>(base + h.meta_offset);
+            strings = base + h.strings_offset;
+
+            auto in_strings = [&](uint32_t offset, uint32_t size) {
+                if (offset > h.strings_size || size > h.strings_size - offset) {
+                    throw decode_error("ati string out of bounds in " + path);
+                }
+            };
+            for (uint32_t i = 0; i < h.field_count; ++i) {
+                in_strings(fields[i].path_offset, fields[i].path_size);
+                if (uint8_t(fields[i].source) > uint8_t(field_source::checksum)) {
+                    throw decode_error("unknown field source in ati " + path);
+                }
+            }
+            for (uint32_t i = 0; i < h.meta_count; ++i) {
+                in_strings(metas[i].key_offset, metas[i].key_size);
+                in_strings(metas[i].value_offset, metas[i].value_size);
+            }
+        }
+
+        const char* base = nullptr;
+        size_t length = 0;
+        const field_record* fields = nullptr;
+        const meta_record* metas = nullptr;
+        const char* strings = nullptr;
+    };
+
+    //where pin() stores the document pinned with hash
+    inline std::string pinned_path(const std::string& store_dir, const checksum256& hash) {
+        return store_dir + "/" + to_hex(hash) + ".ati";
+    }
+
+    //verifies a fetched document against the hash pinned on the license and stores it at pinned_path,
+    //so loads of that pin map the stored copy without hashing it again, returns the stored path
+    inline std::string pin(const std::string& fetched_path, const checksum256& pinned_hash, const std::string& store_dir) {
+        document fetched(fetched_path, &pinned_hash);
+        auto bytes = fetched.data();
+
+        //written next to the final name and renamed, so a load never maps a partial copy
+        std::string path = pinned_path(store_dir, pinned_hash);
+        std::string partial = path + ".partial";
+        FILE* out = fopen(partial.c_str(), "wb");
+        if (!out) {
+            throw decode_error("cannot write " + partial);
+        }
+        bool written = fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+        written = fclose(out) == 0 && written;
+        if (!written || rename(partial.c_str(), path.c_str()) != 0) {
+            remove(partial.c_str());
+            throw decode_error("cannot store ati " + path);
+        }
+        return path;
+    }
+
+}
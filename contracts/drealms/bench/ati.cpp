@@ -0,0 +1,266 @@
+// ATI compiler and binding benchmark.
+//
+// Compiles an ATI json document to the binary layout of ati/ati.hpp and
+// prints the sha256 to pass to setati. Without --compile, issues NFTs to a
+// schema, pins a compiled document on the issuer's license with setati,
+// verifies and stores it once with the hash read off the license row, then
+// maps the stored copy and binds it to every NFT row. Times loads and binds
+// against parsing the json document and resolving its interface keys, and
+// fails if the two bind different values or a tampered document pins.
+//
+// usage: ati --compile=<json> --out=<compiled>
+//        ati [nfts] [--loads=100]
+//
+// @copyright defined in LICENSE.txt
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include "fixture.hpp"
+#include "../ati/ati.hpp"
+
+using namespace bench;
+
+namespace client = drealms_client;
+namespace ati = drealms_ati;
+
+static const symbol exp_sym = symbol("EXP", 0);
+static const name schema_name = name("dragons");
+
+static const char* stat_names[] = {"strength", "dexterity", "constitution", "intelligence", "wisdom", "charisma"};
+
+//the guide's example document, with the stats the bench schema defines
+static std::string example_document() {
+    std::string stats;
+    for (auto s : stat_names) {
+        stats += std::string(stats.empty() ? "" : ",\n") + "            \"" + s + "\": \"uint16_t\"";
+    }
+    return "{\n"
+        "    \"comment\": \"This file was generated with drealms-atigen.\",\n"
+        "    \"version\": \"drealms-atigen/0.1.0\",\n"
+        "    \"engine\": {\"name\": \"unity\", \"version\": \"2019.6.5\"},\n"
+        "    \"license\": {\"contract\": \"drealms\", \"owner\": \"alice\", \"token_family\": \"dragons\"},\n"
+        "    \"realm\": {\"name\": \"fantasy\"},\n"
+        "    \"interface\": {\n"
+        "        \"nft_id\": \"uint64\",\n"
+        "        \"owner\": \"name\",\n"
+        "        \"level\": \"uint8\",\n"
+        "        \"experience\": \"asset\",\n"
+        "        \"stats\": {\n" + stats + "\n        },\n"
+        "        \"uris\": {\"meta\": \"string\"},\n"
+        "        \"appearance\": {\"scale\": \"uint16\", \"color\": \"string\"},\n"
+        "        \"skills\": [{\"name\": \"string\", \"power\": \"uint8\", \"effect\": \"string\"}]\n"
+        "    }\n"
+        "}\n";
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw ati::decode_error("cannot open " + path);
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), std::streamsize(bytes.size()));
+    if (!out) {
+        throw ati::decode_error("cannot write " + path);
+    }
+}
+
+//sums every bound value, must match between the two paths
+static uint64_t fold(const ati::bound_value& v) {
+    if (!v.present) {
+        return 1;
+    }
+    return v.number + uint64_t(v.amount.amount) + v.text.size();
+}
+
+//binds by walking the parsed json, the way a client without the compiled document does
+static uint64_t bind_json(const ati::json_value& doc, const client::nonfungible_row& row) {
+    uint64_t sum = 0;
+    auto& interface = *doc.find("interface");
+    std::function<void(const ati::json_value&, ati::field_source)> leaves = [&](const ati::json_value& v, ati::field_source from) {
+        if (v.type == ati::json_value::kind::object) {
+            for (auto& item : v.items) {
+                leaves(item, ati::field_source::none);
+            }
+            return;
+        }
+        ati::field_record f{};
+        f.source = from;
+        sum += fold(ati::bind_field(f, row));
+    };
+    for (size_t i = 0; i < interface.keys.size(); ++i) {
+        auto& key = interface.keys[i];
+        auto& value = interface.items[i];
+        auto from = ati::map_source(key);
+        if (from != ati::field_source::none && value.type == ati::json_value::kind::object) {
+            for (auto& k : value.keys) {
+                ati::field_record f{};
+                f.source = from;
+                f.key = client::name(k).value;
+                sum += fold(ati::bind_field(f, row));
+            }
+        } else {
+            leaves(value, ati::row_source(key));
+        }
+    }
+    return sum;
+}
+
+static uint64_t bind_compiled(const ati::document& doc, const client::nonfungible_row& row) {
+    uint64_t sum = 0;
+    doc.bind(row, [&](const ati::field_record&, const ati::bound_value& v) {
+        sum += fold(v);
+    });
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    uint64_t n = 10000;
+    uint64_t loads = 100;
+    std::string compile_path, out_path;
+    for (int a = 1; a < argc; ++a) {
+        if (strncmp(argv[a], "--compile=", 10) == 0) {
+            compile_path = argv[a] + 10;
+        } else if (strncmp(argv[a], "--out=", 6) == 0) {
+            out_path = argv[a] + 6;
+        } else if (strncmp(argv[a], "--loads=", 8) == 0) {
+            loads = std::stoull(argv[a] + 8);
+        } else {
+            n = std::stoull(argv[a]);
+        }
+    }
+
+    try {
+        if (!compile_path.empty()) {
+            if (out_path.empty()) {
+                fprintf(stderr, "--compile needs --out\n");
+                return 1;
+            }
+            auto compiled = ati::compile(read_file(compile_path));
+            write_file(out_path, compiled);
+            printf("%s\n", ati::to_hex(ati::sha256::hash(compiled.data(), compiled.size())).c_str());
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    //schema with the example's stats, and its issuer license pinned to the compiled document
+    install();
+    push(name("setrealmdata"), self, string("v0.2.0"), name("fantasy"));
+    push(name("newnftschema"), name("alice"), schema_name, name("alice"), uint64_t(n * 100), exp_sym, true, true, true, true);
+    for (auto s : stat_names) {
+        push(name("addstat"), name("alice"), schema_name, name(s), uint32_t(1));
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        push(name("issuenft"), name("alice"), name("bob"), schema_name, string(""), false);
+    }
+
+    std::string json = example_document();
+    std::string path = "/tmp/drealms.ati";
+    auto compiled = ati::compile(json);
+    write_file(path, compiled);
+    auto digest = ati::sha256::hash(compiled.data(), compiled.size());
+    push(name("setati"), name("alice"), schema_name, name("alice"), string("https://cdn.drealms.io/dragons/ati.bin"),
+        binary_extension<checksum256>(checksum256(digest)));
+
+    auto* licenses = host::get_chain().find_table(self, schema_name.value, name("licenses"));
+    auto& lic_data = licenses->rows.at(name("alice").value).data;
+    auto lic = client::license_row::decode(std::string_view(lic_data.data(), lic_data.size()));
+    if (lic.ati_hash.size() != digest.size() || memcmp(lic.ati_hash.data(), digest.data(), digest.size()) != 0) {
+        fprintf(stderr, "license does not pin the compiled document\n");
+        return 1;
+    }
+    ati::checksum256 pinned;
+    memcpy(pinned.data(), lic.ati_hash.data(), pinned.size());
+
+    std::vector<client::nonfungible_row> rows;
+    auto* nfts = host::get_chain().find_table(self, schema_name.value, name("nfts"));
+    for (auto& r : nfts->rows) {
+        rows.push_back(client::nonfungible_row::decode(std::string_view(r.second.data.data(), r.second.data.size())));
+    }
+
+    //pinning: verify the fetched document once and store it by digest
+    std::string store = "/tmp";
+    double start = now_ns();
+    for (uint64_t i = 0; i < loads; ++i) {
+        ati::pin(path, pinned, store);
+    }
+    double pin_ns = (now_ns() - start) / double(loads);
+    std::string stored = ati::pinned_path(store, pinned);
+
+    //loading from disk: read and parse the json against map the stored copy
+    std::string json_path = path + ".json";
+    write_file(json_path, json);
+    start = now_ns();
+    for (uint64_t i = 0; i < loads; ++i) {
+        auto doc = ati::json_parser::parse(read_file(json_path));
+        if (!doc.find("interface")) {
+            return 1;
+        }
+    }
+    double parse_ns = (now_ns() - start) / double(loads);
+    remove(json_path.c_str());
+
+    start = now_ns();
+    for (uint64_t i = 1; i < loads; ++i) {
+        ati::document doc(stored);
+    }
+    ati::document doc(stored);
+    double map_ns = (now_ns() - start) / double(loads);
+
+    //binding every row
+    auto parsed = ati::json_parser::parse(json);
+    start = now_ns();
+    uint64_t json_sum = 0;
+    for (auto& row : rows) {
+        json_sum += bind_json(parsed, row);
+    }
+    double json_ns = now_ns() - start;
+
+    start = now_ns();
+    uint64_t compiled_sum = 0;
+    for (auto& row : rows) {
+        compiled_sum += bind_compiled(doc, row);
+    }
+    double compiled_ns = now_ns() - start;
+
+    printf("document: %zu json bytes, %zu compiled bytes, %u fields, sha256 %s\n", json.size(), doc.bytes(),
+        doc.field_count(), ati::to_hex(pinned).c_str());
+    for (uint32_t i = 0; i < doc.field_count(); ++i) {
+        auto& f = doc.field(i);
+        printf("  %-20s type %u source %u\n", std::string(doc.path(f)).c_str(), unsigned(f.type), unsigned(f.source));
+    }
+    printf("pin:   %8.0f ns verifying and storing, once per pin on the license\n", pin_ns);
+    printf("load:  %8.0f ns reading and parsing json, %8.0f ns mapping the pinned copy (%.1fx)\n", parse_ns, map_ns, parse_ns / map_ns);
+    printf("bind:  %8.1f ns/row resolving json keys, %8.1f ns/row compiled (%.1fx), %llu rows\n", json_ns / double(rows.size()),
+        compiled_ns / double(rows.size()), json_ns / compiled_ns, (unsigned long long)rows.size());
+
+    bool ok = json_sum == compiled_sum;
+    if (!ok) {
+        fprintf(stderr, "compiled binding differs from json binding\n");
+    }
+
+    //a tampered copy must not pin
+    compiled[compiled.size() - 1] ^= 1;
+    write_file(path, compiled);
+    try {
+        ati::pin(path, pinned, store);
+        fprintf(stderr, "tampered document pinned\n");
+        ok = false;
+    } catch (const ati::decode_error&) {
+    }
+    remove(path.c_str());
+    remove(stored.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,400 @@
+// Microbenchmarks for every drealms ACTION on the native host chain.
+//
+// Each case gets an untimed setup step and a timed push of one action, and
+// reports wall time, database intrinsics and serialized bytes per action.
+//
+// usage: bench_actions [iterations] [--csv]
+//
+// In a profiling build (CXXFLAGS=-DDREALMS_PROFILE) the contract's own
+// counters for the last iteration are printed under each row.
+//
+// @copyright defined in LICENSE.txt
+
+#include <cstring>
+#include <functional>
+
+#include "fixture.hpp"
+
+using namespace bench;
+
+struct bench_case {
+    std::string label;
+    std::function<void(uint64_t i)> setup; //untimed, may be empty
+    std::function<host::action_data(uint64_t i)> make;
+};
+
+struct bench_result {
+    std::string label;
+    uint64_t ops = 0;
+    double ns = 0;
+    host::counters totals;
+    std::string console; //of the last iteration, holds the counters of a profiling build
+};
+
+static const name schema_name = name("dragons");
+static const symbol exp_sym = symbol("EXP", 0);
+static const symbol gold_sym = symbol("GOLD", 2);
+static const vector<name> stat_names = {
+    name("strength"), name("dexterity"), name("constitution"), name("intelligence"), name("wisdom"), name("charisma")
+};
+
+//builds a realm with one schema holding n nfts owned by bob, and a currency held by alice and bob
+static void build_realm(uint64_t n) {
+    install();
+    auto& c = host::get_chain();
+    for (uint64_t i = 0; i < n; ++i) {
+        c.create_account(indexed_name("acct", i));
+    }
+
+    push(name("setrealmdata"), self, string("v0.2.0"), name("fantasy"));
+    push(name("newnftschema"), name("alice"), schema_name, name("alice"), uint64_t(n * 100), exp_sym, true, true, true, true);
+    for (auto stat : stat_names) {
+        push(name("addstat"), name("alice"), schema_name, stat, uint32_t(1));
+    }
+    push(name("newuri"), name("alice"), schema_name, name("alice"), name("base"), name("meta"), string("https://cdn.drealms.io/dragons/"), optional<uint64_t>());
+
+    for (uint64_t i = 0; i < n; ++i) {
+        push(name("issuenft"), name("alice"), name("bob"), schema_name, string(""), false);
+    }
+
+    push(name("create"), name("alice"), name("alice"), true, true, true, asset(asset::max_amount, gold_sym));
+    push(name("issue"), name("alice"), name("alice"), asset(n * 1000, gold_sym), string(""));
+    push(name("issue"), name("alice"), name("bob"), asset(n * 1000, gold_sym), string(""));
+}
+
+//writes n nfts in the v0 layout straight into the host database
+static void build_legacy_nfts(name legacy_schema, uint64_t n) {
+    auto& c = host::get_chain();
+    push(name("newnftschema"), name("alice"), legacy_schema, name("alice"), uint64_t(n), exp_sym, true, true, true, true);
+
+    map<name, uint32_t> stats;
+    for (auto stat : stat_names) {
+        stats[stat] = 1;
+    }
+
+    for (uint64_t serial = 1; serial <= n; ++serial) {
+        host::row r{name("alice"), pack(std::make_tuple(
+            serial, name("bob"), uint16_t(1), asset(0, exp_sym), asset(1000, exp_sym), uint8_t(0), stats,
+            map<name, string>(), map<name, string>()))};
+        c.set_row(self, legacy_schema.value, name("nfts"), serial, &r);
+    }
+}
+
+static uint64_t next_serial() {
+    drealms::schema sch;
+    read_row(name("schemas"), self.value, schema_name.value, sch);
+    return sch.issued_supply + 1;
+}
+
+static vector<bench_case> make_cases(uint64_t n) {
+    const name issuer = name("alice");
+    const name holder = name("bob");
+    auto serial_of = [n](uint64_t i) { return i % n + 1; };
+    auto none = optional<uint64_t>();
+
+    return {
+        //realm
+        {"setrealmdata", {}, [](uint64_t) {
+            return make_action(name("setrealmdata"), self, string("v0.2.0"), name("fantasy"));
+        }},
+
+        //schemas
+        {"newnftschema", {}, [](uint64_t i) {
+            return make_action(name("newnftschema"), name("carol"), indexed_name("sch", i), name("carol"), uint64_t(1000), exp_sym, true, true, true, true);
+        }},
+        {"toggle", {}, [=](uint64_t) {
+            return make_action(name("toggle"), issuer, schema_name, name("activatable"));
+        }},
+        {"addstat", {}, [](uint64_t i) {
+            return make_action(name("addstat"), name("carol"), indexed_name("sch", 0), indexed_name("stat", i), uint32_t(1));
+        }},
+        {"syncstats", {}, [=](uint64_t i) {
+            return make_action(name("syncstats"), issuer, schema_name, serial_of(i));
+        }},
+        {"awardexp", {}, [=](uint64_t i) {
+            return make_action(name("awardexp"), issuer, schema_name, issuer, serial_of(i), asset(10, exp_sym));
+        }},
+
+        //licensing
+        {"setlicmodel", {}, [=](uint64_t i) {
+            return make_action(name("setlicmodel"), issuer, schema_name, i % 2 ? name("open") : name("permissioned"));
+        }},
+        {"newlicense", [=](uint64_t i) {
+            if (i == 0) {
+                push(name("setlicmodel"), issuer, schema_name, name("permissioned"));
+            }
+        }, [=](uint64_t i) {
+            return make_action(name("newlicense"), issuer, schema_name, indexed_name("acct", i), time_point_sec(current_time_point()) + 86400);
+        }},
+        {"eraselicense", [=](uint64_t i) {
+            push(name("newlicense"), issuer, schema_name, indexed_name("acct", i), time_point_sec(current_time_point()) - 1);
+        }, [=](uint64_t i) {
+            return make_action(name("eraselicense"), issuer, schema_name, indexed_name("acct", i));
+        }},
+        {"setlicminmax", {}, [=](uint64_t) {
+            return make_action(name("setlicminmax"), issuer, schema_name, uint32_t(604801), uint32_t(31449599));
+        }},
+        {"setalgo", {}, [=](uint64_t) {
+            return make_action(name("setalgo"), issuer, schema_name, issuer, string("sha256"));
+        }},
+        {"setati", {}, [=](uint64_t) {
+            return make_action(name("setati"), issuer, schema_name, issuer, string("https://cdn.drealms.io/dragons/ati.json"));
+        }},
+        {"newuri(full)", {}, [=](uint64_t i) {
+            return make_action(name("newuri"), issuer, schema_name, issuer, name("full"), indexed_name("uri", i % 8), string("https://cdn.drealms.io/dragons/full"), none);
+        }},
+        {"newuri(relative)", {}, [=](uint64_t i) {
+            return make_action(name("newuri"), issuer, schema_name, issuer, name("relative"), name("meta"), string("dragon/") + std::to_string(serial_of(i)), optional<uint64_t>(serial_of(i)));
+        }},
+        {"newuri(prefixed)", {}, [=](uint64_t i) {
+            return make_action(name("newuri"), issuer, schema_name, issuer, name("relative"), name("meta"),
+                string("https://cdn.drealms.io/dragons/meta/") + std::to_string(serial_of(i)) + ".json", optional<uint64_t>(serial_of(i)));
+        }},
+        {"deleteuri", [=](uint64_t i) {
+            push(name("newuri"), issuer, schema_name, issuer, name("full"), name("temp"), string("https://cdn.drealms.io/temp"), none);
+        }, [=](uint64_t) {
+            return make_action(name("deleteuri"), issuer, schema_name, issuer, name("full"), name("temp"), none);
+        }},
+
+        //nonfungibles owned by bob
+        {"activatenft", {}, [=](uint64_t i) {
+            return make_action(name("activatenft"), holder, schema_name, serial_of(i), string(""));
+        }},
+        {"newchecksum", {}, [=](uint64_t i) {
+            return make_action(name("newchecksum"), issuer, schema_name, issuer, serial_of(i), string("9f86d081884c7d65"));
+        }},
+        {"levelup", {}, [=](uint64_t i) {
+            return make_action(name("levelup"), holder, schema_name, serial_of(i));
+        }},
+        {"spendpoint", {}, [=](uint64_t i) {
+            return make_action(name("spendpoint"), holder, schema_name, serial_of(i), stat_names[i % stat_names.size()]);
+        }},
+        {"viewnfts(10)", {}, [=](uint64_t i) {
+            vector<uint64_t> serials;
+            for (uint64_t k = 0; k < 10; ++k) {
+                serials.push_back(serial_of(i * 10 + k));
+            }
+            return make_action(name("viewnfts"), holder, schema_name, issuer, serials);
+        }},
+        {"countnfts", {}, [=](uint64_t) {
+            return make_action(name("countnfts"), holder, holder, schema_name);
+        }},
+        {"issuenft", {}, [=](uint64_t) {
+            return make_action(name("issuenft"), issuer, holder, schema_name, string("bench"), false);
+        }},
+        {"issuenft(log)", {}, [=](uint64_t) {
+            return make_action(name("issuenft"), issuer, holder, schema_name, string("bench"), true);
+        }},
+        {"transfernft", {}, [=](uint64_t i) {
+            return make_action(name("transfernft"), holder, holder, name("carol"), schema_name, vector<uint64_t>{serial_of(i)}, string(""));
+        }},
+        {"swapnft", {}, [=](uint64_t i) {
+            //carol sells back what transfernft gave her
+            auto act = make_action(name("swapnft"), name("carol"), name("carol"), holder, schema_name, vector<uint64_t>{serial_of(i)},
+                asset(100, gold_sym), string(""));
+            act.authorization.push_back(permission_level{holder, name("active")});
+            return act;
+        }},
+        {"retirenft", [=](uint64_t) {
+            push(name("issuenft"), issuer, issuer, schema_name, string(""), false);
+        }, [=](uint64_t) {
+            return make_action(name("retirenft"), issuer, schema_name, vector<uint64_t>{next_serial() - 1}, string(""));
+        }},
+        {"consumenft", [=](uint64_t) {
+            push(name("issuenft"), issuer, holder, schema_name, string(""), false);
+        }, [=](uint64_t) {
+            return make_action(name("consumenft"), holder, schema_name, next_serial() - 1, string(""));
+        }},
+        {"retirerange(100)", [=](uint64_t) {
+            for (int k = 0; k < 100; ++k) {
+                push(name("issuenft"), issuer, issuer, schema_name, string(""), false);
+            }
+        }, [=](uint64_t) {
+            return make_action(name("retirerange"), issuer, schema_name, next_serial() - 100, next_serial() - 1, uint32_t(100), string(""));
+        }},
+        {"consumerange(100)", [=](uint64_t) {
+            for (int k = 0; k < 100; ++k) {
+                push(name("issuenft"), issuer, holder, schema_name, string(""), false);
+            }
+        }, [=](uint64_t) {
+            return make_action(name("consumerange"), holder, holder, schema_name, next_serial() - 100, next_serial() - 1, uint32_t(100), string(""));
+        }},
+
+        //crafting, two dragons and 1.00 GOLD into a dragon
+        {"newrecipe", {}, [=](uint64_t i) {
+            return make_action(name("newrecipe"), issuer, schema_name, indexed_name("rcp", i), map<name, uint64_t>{{schema_name, 2}},
+                vector<asset>{asset(100, gold_sym)}, map<name, uint32_t>{{name("strength"), 5}});
+        }},
+        {"craft", [=](uint64_t) {
+            push(name("issuenft"), issuer, holder, schema_name, string(""), false);
+            push(name("issuenft"), issuer, holder, schema_name, string(""), false);
+        }, [=](uint64_t) {
+            uint64_t last = next_serial() - 1;
+            return make_action(name("craft"), holder, holder, schema_name, indexed_name("rcp", 0),
+                map<name, vector<uint64_t>>{{schema_name, {last - 1, last}}}, string(""));
+        }},
+        {"eraserecipe", {}, [=](uint64_t i) {
+            return make_action(name("eraserecipe"), issuer, schema_name, indexed_name("rcp", i));
+        }},
+
+        //batch, one tick of the newuri(relative), newchecksum, transfernft and spendpoint cases above
+        {"batch(5)", [=](uint64_t i) {
+            push(name("levelup"), holder, schema_name, serial_of(i));
+        }, [=](uint64_t i) {
+            uint64_t serial = serial_of(i);
+            auto act = make_action(name("batch"), issuer, vector<drealms::batch_op>{
+                drealms::newuri_op{schema_name, issuer, name("relative"), name("meta"), string("dragon/") + std::to_string(serial), serial},
+                drealms::newchecksum_op{schema_name, issuer, serial, string("9f86d081884c7d65")},
+                drealms::transfernft_op{holder, name("carol"), schema_name, {serial}, string("")},
+                drealms::transfernft_op{name("carol"), holder, schema_name, {serial}, string("")},
+                drealms::spendpoint_op{schema_name, serial, stat_names[i % stat_names.size()]},
+            });
+            act.authorization.push_back(permission_level{holder, name("active")});
+            act.authorization.push_back(permission_level{name("carol"), name("active")});
+            return act;
+        }},
+
+        //fungibles
+        {"create", {}, [=](uint64_t i) {
+            return make_action(name("create"), issuer, issuer, true, true, true, asset(1000000, symbol(indexed_code(i), 2)));
+        }},
+        {"issue", {}, [=](uint64_t) {
+            return make_action(name("issue"), issuer, holder, asset(100, gold_sym), string(""));
+        }},
+        {"retire", {}, [=](uint64_t) {
+            return make_action(name("retire"), issuer, asset(100, gold_sym), string(""));
+        }},
+        {"transfer", {}, [=](uint64_t) {
+            return make_action(name("transfer"), holder, holder, name("carol"), asset(100, gold_sym), string(""));
+        }},
+        {"consume", {}, [=](uint64_t) {
+            return make_action(name("consume"), holder, holder, asset(100, gold_sym), string(""));
+        }},
+        {"open", {}, [=](uint64_t i) {
+            return make_action(name("open"), issuer, indexed_name("acct", i), gold_sym, issuer);
+        }},
+        {"close", {}, [=](uint64_t i) {
+            return make_action(name("close"), indexed_name("acct", i), indexed_name("acct", i), gold_sym);
+        }},
+
+        //opt-in notifications, bob and carol have not subscribed
+        {"subscribe", {}, [=](uint64_t i) {
+            return make_action(name("subscribe"), indexed_name("acct", i), indexed_name("acct", i), vector<name>{schema_name}, vector<symbol_code>());
+        }},
+        {"unsubscribe", {}, [=](uint64_t i) {
+            return make_action(name("unsubscribe"), indexed_name("acct", i), indexed_name("acct", i));
+        }},
+        {"issuenft(optin)", [=](uint64_t i) {
+            if (i == 0) {
+                push(name("setnotify"), self, name("subscribed"));
+            }
+        }, [=](uint64_t) {
+            return make_action(name("issuenft"), issuer, holder, schema_name, string("bench"), false);
+        }},
+        {"transfernft(optin)", {}, [=](uint64_t i) {
+            return make_action(name("transfernft"), holder, holder, name("carol"), schema_name, vector<uint64_t>{serial_of(i)}, string(""));
+        }},
+        {"transfer(optin)", {}, [=](uint64_t) {
+            return make_action(name("transfer"), holder, holder, name("carol"), asset(100, gold_sym), string(""));
+        }},
+
+        //migration, 100 v0 rows per call
+        {"migrate(100)", [=](uint64_t i) {
+            if (i == 0) {
+                build_legacy_nfts(name("legacy"), n * 100);
+            }
+        }, [=](uint64_t) {
+            return make_action(name("migrate"), issuer, name("nfts"), name("legacy"), uint32_t(100));
+        }},
+
+        //event log
+        {"logevents(10)", {}, [=](uint64_t i) {
+            vector<drealms::nftevent> events(10, drealms::nftevent{name("transfer"), schema_name, serial_of(i), holder, name("carol"), 0});
+            return make_action(name("logevents"), self, events);
+        }},
+    };
+}
+
+static bench_result run_case(const bench_case& bc, uint64_t iterations) {
+    auto& c = host::get_chain();
+    bench_result result;
+    result.label = bc.label;
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (bc.setup) {
+            bc.setup(i);
+        }
+        auto act = bc.make(i);
+
+        host::stats.reset();
+        double start = now_ns();
+        try {
+            c.push_action(act);
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s failed on iteration %llu: %s\n", bc.label.c_str(), (unsigned long long)i, e.what());
+            exit(1);
+        }
+        result.ns += now_ns() - start;
+        result.console = c.console;
+
+        auto& s = host::stats;
+        auto& t = result.totals;
+        t.db_find += s.db_find;
+        t.db_get += s.db_get;
+        t.db_store += s.db_store;
+        t.db_update += s.db_update;
+        t.db_remove += s.db_remove;
+        t.db_next += s.db_next;
+        t.db_previous += s.db_previous;
+        t.db_lowerbound += s.db_lowerbound;
+        t.db_upperbound += s.db_upperbound;
+        t.db_end += s.db_end;
+        t.bytes_packed += s.bytes_packed;
+        t.bytes_unpacked += s.bytes_unpacked;
+        t.auth_checks += s.auth_checks;
+        t.notifications += s.notifications;
+        t.inline_actions += s.inline_actions;
+        result.ops += 1;
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    uint64_t iterations = 1000;
+    bool csv = false;
+    for (int a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--csv") == 0) {
+            csv = true;
+        } else {
+            iterations = std::stoull(argv[a]);
+        }
+    }
+
+    build_realm(iterations);
+
+    if (csv) {
+        printf("action,ns_per_op,db_ops_per_op,finds,gets,stores,updates,removes,bytes_packed_per_op,bytes_unpacked_per_op,notifications_per_op,inline_per_op\n");
+    } else {
+        printf("%-18s %10s %8s %6s %6s %6s %6s %6s %10s %10s %6s %6s\n",
+            "action", "ns/op", "db/op", "find", "get", "store", "update", "remove", "packB/op", "unpackB/op", "notif", "inline");
+    }
+
+    for (auto& bc : make_cases(iterations)) {
+        auto r = run_case(bc, iterations);
+        double ops = double(r.ops);
+        auto& t = r.totals;
+        printf(csv ? "%s,%.0f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%.2f\n"
+                   : "%-18s %10.0f %8.2f %6.2f %6.2f %6.2f %6.2f %6.2f %10.1f %10.1f %6.2f %6.2f\n",
+            r.label.c_str(), r.ns / ops, t.db_ops() / ops,
+            t.db_find / ops, t.db_get / ops, t.db_store / ops, t.db_update / ops, t.db_remove / ops,
+            t.bytes_packed / ops, t.bytes_unpacked / ops, t.notifications / ops, t.inline_actions / ops);
+#ifdef DREALMS_PROFILE
+        if (!csv) {
+            printf("    %s", r.console.c_str());
+        }
+#endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,318 @@
+// Decode throughput of drealms table rows.
+//
+// Packs representative rows of every table the way the contract stores
+// them, then decodes each one with the contract's own unpack (std::map and
+// std::string per field) and with the zero-copy decoder in client/rows.hpp,
+// touching the same fields in both. Reports rows/s, MB/s and heap
+// allocations per row, and fails if the two decoders disagree.
+//
+// usage: bench_decode [rows] [--stats=6]
+//
+// @copyright defined in LICENSE.txt
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "fixture.hpp"
+#include "../client/rows.hpp"
+
+using namespace bench;
+
+namespace client = drealms_client;
+
+//the profiling build already replaces operator new in the contract
+#ifndef DREALMS_PROFILE
+static uint64_t allocations = 0;
+
+//every replaceable form, so each allocation is freed by the matching delete, kept out of line so
+//callers pair operator new with operator delete rather than with the free inside it
+#define REPLACEMENT __attribute__((noinline))
+
+REPLACEMENT void* operator new(size_t size) {
+    allocations += 1;
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+REPLACEMENT void* operator new(size_t size, std::align_val_t align) {
+    allocations += 1;
+    size_t alignment = static_cast<size_t>(align);
+    if (void* ptr = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+REPLACEMENT void* operator new[](size_t size) { return operator new(size); }
+REPLACEMENT void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+
+REPLACEMENT void operator delete(void* ptr) noexcept { free(ptr); }
+REPLACEMENT void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+REPLACEMENT void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+REPLACEMENT void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+REPLACEMENT void operator delete[](void* ptr) noexcept { free(ptr); }
+REPLACEMENT void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+REPLACEMENT void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+REPLACEMENT void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+
+#undef REPLACEMENT
+#else
+static const uint64_t allocations = 0;
+#endif
+
+struct decode_result {
+    double ns = 0;
+    uint64_t allocs = 0;
+    uint64_t checksum = 0; //sum of touched fields, must match between decoders
+};
+
+static const symbol exp_sym = symbol("EXP", 0);
+static const symbol gold_sym = symbol("GOLD", 2);
+
+//======================== rows ========================
+
+static map<name, uint32_t> make_stats(uint64_t count, uint64_t i) {
+    map<name, uint32_t> stats;
+    for (uint64_t s = 0; s < count; ++s) {
+        stats[indexed_name("stat", s)] = uint32_t(1 + (i + s) % 200);
+    }
+    return stats;
+}
+
+static vector<vector<char>> schema_rows(uint64_t n, uint64_t stats) {
+    vector<vector<char>> rows;
+    for (uint64_t i = 0; i < n; ++i) {
+        drealms::schema sch;
+        sch.schema_name = indexed_name("sch", i);
+        sch.issuer = indexed_name("studio", i % 10);
+        sch.supply = i * 10;
+        sch.issued_supply = i * 11;
+        sch.max_supply = i * 100;
+        sch.license_model = name("permissioned");
+        sch.min_license_length = 604800;
+        sch.max_license_length = 31449600;
+        sch.settings = {
+            {name("retirable"), true}, {name("transferable"), true}, {name("consumable"), i % 2 == 0},
+            {name("activatable"), false}, {name("logevents"), false}
+        };
+        sch.default_stats = make_stats(stats, i);
+        sch.exp_symbol = exp_sym;
+        rows.push_back(pack(sch));
+    }
+    return rows;
+}
+
+static vector<vector<char>> license_rows(uint64_t n) {
+    vector<vector<char>> rows;
+    for (uint64_t i = 0; i < n; ++i) {
+        drealms::license lic;
+        lic.owner = indexed_name("lic", i);
+        lic.expiration = time_point_sec(1609459200 + uint32_t(i));
+        lic.checksum_algo = "sha256";
+        lic.full_uris = {{name("ati"), "https://cdn.studio.io/ati/" + std::to_string(i) + ".json"}};
+        lic.base_uris = {{name("meta"), "https://cdn.studio.io/meta/"}, {name("image"), "https://cdn.studio.io/image/"}};
+        rows.push_back(pack(lic));
+    }
+    return rows;
+}
+
+//v1 rows from the contract's own serializer, v0 rows in the legacy layout
+static vector<vector<char>> nft_rows(uint64_t n, uint64_t stats, bool legacy) {
+    vector<vector<char>> rows;
+    for (uint64_t i = 0; i < n; ++i) {
+        auto row_stats = make_stats(stats, i);
+        map<name, string> relative_uris = {{name("studio.a"), std::to_string(i) + ".json"}};
+        map<name, string> checksums = {{name("studio.a"), "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"}};
+
+        if (legacy) {
+            rows.push_back(pack(std::make_tuple(i + 1, indexed_name("p", i % 1000), uint16_t(1 + i % 50),
+                asset(int64_t(i), exp_sym), asset(1000, exp_sym), uint8_t(i % 3), row_stats, relative_uris, checksums)));
+            continue;
+        }
+
+        drealms::nonfungible nft;
+        nft.serial = i + 1;
+        nft.owner = indexed_name("p", i % 1000);
+        nft.level = uint16_t(1 + i % 50);
+        nft.experience = asset(int64_t(i), exp_sym);
+        nft.next_level = asset(1000, exp_sym);
+        nft.unspent = uint8_t(i % 3);
+        nft.stats = row_stats;
+        nft.relative_uris = relative_uris;
+        nft.checksums = checksums;
+        rows.push_back(pack(nft));
+    }
+    return rows;
+}
+
+static vector<vector<char>> currency_rows(uint64_t n) {
+    vector<vector<char>> rows;
+    for (uint64_t i = 0; i < n; ++i) {
+        symbol sym(indexed_code(i), 2);
+        rows.push_back(pack(drealms::currency{indexed_name("studio", i % 10), true, true, false,
+            asset(int64_t(i) * 100, sym), asset(int64_t(i + 1) * 1000, sym)}));
+    }
+    return rows;
+}
+
+static vector<vector<char>> account_rows(uint64_t n) {
+    vector<vector<char>> rows;
+    for (uint64_t i = 0; i < n; ++i) {
+        rows.push_back(pack(drealms::account{asset(int64_t(i), gold_sym)}));
+    }
+    return rows;
+}
+
+//======================== decoders ========================
+
+//decodes every row with f(data, size) and returns the sum of what it touched
+template<typename F>
+static decode_result run(const vector<vector<char>>& rows, F&& f) {
+    decode_result result;
+    uint64_t allocs_before = allocations;
+    double start = now_ns();
+    for (auto& r : rows) {
+        result.checksum += f(r.data(), r.size());
+    }
+    result.ns = now_ns() - start;
+    result.allocs = allocations - allocs_before;
+    return result;
+}
+
+static uint64_t touch(const drealms::schema& s) {
+    uint64_t sum = s.schema_name.value + s.issued_supply + s.settings.size();
+    for (auto& st : s.default_stats) {
+        sum += st.first.value + st.second;
+    }
+    return sum;
+}
+
+static uint64_t touch(const client::schema_row& s) {
+    uint64_t sum = s.schema_name.value + s.issued_supply + s.settings.size();
+    for (auto& st : s.default_stats) {
+        sum += st.first.value + st.second;
+    }
+    return sum;
+}
+
+static uint64_t touch(const drealms::license& l) {
+    uint64_t sum = l.owner.value + l.expiration.sec_since_epoch() + l.checksum_algo.size();
+    for (auto& u : l.full_uris) {
+        sum += u.first.value + u.second.size();
+    }
+    for (auto& u : l.base_uris) {
+        sum += u.first.value + u.second.size();
+    }
+    return sum;
+}
+
+static uint64_t touch(const client::license_row& l) {
+    uint64_t sum = l.owner.value + l.expiration.utc_seconds + l.checksum_algo.size();
+    for (auto& u : l.full_uris) {
+        sum += u.first.value + u.second.size();
+    }
+    for (auto& u : l.base_uris) {
+        sum += u.first.value + u.second.size();
+    }
+    return sum;
+}
+
+static uint64_t touch(const drealms::nonfungible& n) {
+    uint64_t sum = n.serial + n.owner.value + n.level + uint64_t(n.experience.amount);
+    for (auto& s : n.stats) {
+        sum += s.first.value + s.second;
+    }
+    for (auto& u : n.relative_uris) {
+        sum += u.second.size();
+    }
+    return sum;
+}
+
+static uint64_t touch(const client::nonfungible_row& n) {
+    uint64_t sum = n.serial + n.owner.value + n.level + uint64_t(n.experience.amount);
+    n.for_each_stat([&](client::name stat, uint32_t value) {
+        sum += stat.value + value;
+    });
+    for (auto& u : n.relative_uris) {
+        sum += u.second.size();
+    }
+    return sum;
+}
+
+static uint64_t touch(const drealms::currency& c) {
+    return c.issuer.value + uint64_t(c.supply.amount) + c.supply.symbol.raw() + c.consumable;
+}
+
+static uint64_t touch(const client::currency_row& c) {
+    return c.issuer.value + uint64_t(c.supply.amount) + c.supply.sym.value + c.consumable;
+}
+
+static uint64_t touch(const drealms::account& a) {
+    return uint64_t(a.balance.amount) + a.balance.symbol.raw();
+}
+
+static uint64_t touch(const client::account_row& a) {
+    return uint64_t(a.balance.amount) + a.balance.sym.value;
+}
+
+template<typename Row, typename ClientRow>
+static bool compare(const std::string& label, const vector<vector<char>>& rows, bool csv) {
+    uint64_t bytes = 0;
+    for (auto& r : rows) {
+        bytes += r.size();
+    }
+
+    auto unpacked = run(rows, [](const char* data, size_t size) {
+        return touch(unpack<Row>(data, size));
+    });
+    auto zero_copy = run(rows, [](const char* data, size_t size) {
+        return touch(ClientRow::decode(std::string_view(data, size)));
+    });
+
+    double n = double(rows.size());
+    for (auto* r : {&unpacked, &zero_copy}) {
+        const char* decoder = r == &unpacked ? "unpack" : "client";
+        printf(csv ? "%s,%s,%.0f,%.1f,%.0f,%.2f\n" : "%-16s %-8s %14.0f %10.1f %10.0f %10.2f\n",
+            label.c_str(), decoder, n / (r->ns / 1e9), (bytes / 1e6) / (r->ns / 1e9), r->ns / n, r->allocs / n);
+    }
+
+    if (unpacked.checksum != zero_copy.checksum) {
+        fprintf(stderr, "%s: decoders disagree\n", label.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint64_t n = 100000;
+    uint64_t stats = 6;
+    bool csv = false;
+    for (int a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--csv") == 0) {
+            csv = true;
+        } else if (strncmp(argv[a], "--stats=", 8) == 0) {
+            stats = std::stoull(argv[a] + 8);
+        } else {
+            n = std::stoull(argv[a]);
+        }
+    }
+
+    if (csv) {
+        printf("row,decoder,rows_per_s,mb_per_s,ns_per_row,allocs_per_row\n");
+    } else {
+        printf("%-16s %-8s %14s %10s %10s %10s\n", "row", "decoder", "rows/s", "MB/s", "ns/row", "allocs/row");
+    }
+
+    bool ok = true;
+    ok &= compare<drealms::schema, client::schema_row>("schema", schema_rows(n, stats), csv);
+    ok &= compare<drealms::license, client::license_row>("license", license_rows(n), csv);
+    ok &= compare<drealms::nonfungible, client::nonfungible_row>("nonfungible(v1)", nft_rows(n, stats, false), csv);
+    ok &= compare<drealms::nonfungible, client::nonfungible_row>("nonfungible(v0)", nft_rows(n, stats, true), csv);
+    ok &= compare<drealms::currency, client::currency_row>("currency", currency_rows(n), csv);
+    ok &= compare<drealms::account, client::account_row>("account", account_rows(n), csv);
+
+    return ok ? 0 : 1;
+}
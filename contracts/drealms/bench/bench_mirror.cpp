@@ -0,0 +1,146 @@
+// Catch up and restart times of the drealms state mirror.
+//
+// Runs the synthetic workload from workload.hpp on the host chain and
+// records every action that succeeded as a trace. A mirror then replays the
+// whole trace from empty state, and a second mirror is checkpointed part way
+// and restarted from the checkpoint, applying only the tail. Both must end
+// with exactly the rows of the source chain and with owner and holder
+// indexes that match a full scan.
+//
+// usage: bench_mirror [--checkpoint-at=0.9] [--trace=path] [--checkpoint=path] [workload flags...]
+//
+// @copyright defined in LICENSE.txt
+
+#include <fstream>
+
+#include "trace.hpp"
+
+using namespace bench;
+
+//true if the mirror's indexes match a scan of its nfts tables
+static bool indexes_match(drealms_mirror::mirror& m) {
+    map<uint64_t, std::set<drealms_mirror::nft_key>> owners;
+    map<uint64_t, map<uint64_t, uint64_t>> holders;
+    m.chain().for_each_scope(self, name("nfts"), [&](uint64_t scope, host::table& t) {
+        for (auto& r : t.rows) {
+            auto row = drealms_client::nonfungible_row::decode(std::string_view(r.second.data.data(), r.second.data.size()));
+            owners[row.owner.value].insert({name(scope), row.serial});
+            holders[scope][row.owner.value] += 1;
+        }
+    });
+
+    for (auto& o : owners) {
+        if (m.owned_by(name(o.first)) != o.second) {
+            return false;
+        }
+    }
+    for (auto& h : holders) {
+        if (m.holders(name(h.first)) != h.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    workload_config cfg;
+    cfg.operations = 200000;
+    double checkpoint_at = 0.9;
+    std::string trace_path = "/tmp/drealms_mirror.trace";
+    std::string checkpoint_path = "/tmp/drealms_mirror.checkpoint";
+    for (int a = 1; a < argc; ++a) {
+        std::string flag = argv[a];
+        if (flag.rfind("--checkpoint-at=", 0) == 0) {
+            checkpoint_at = std::stod(flag.substr(16));
+        } else if (flag.rfind("--trace=", 0) == 0) {
+            trace_path = flag.substr(8);
+        } else if (flag.rfind("--checkpoint=", 0) == 0) {
+            checkpoint_path = flag.substr(13);
+        } else if (!cfg.parse_flag(flag)) {
+            fprintf(stderr, "unknown flag %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    //source chain, recording every action that succeeds
+    auto records = record_workload(cfg);
+    auto& c = host::get_chain();
+    uint64_t sequence = records.size();
+    {
+        std::ofstream trace(trace_path);
+        for (auto& rec : records) {
+            drealms_mirror::write_trace(trace, rec);
+            trace << '\n';
+        }
+    }
+    uint64_t cut = uint64_t(double(sequence) * checkpoint_at);
+
+    //full replay from empty state
+    drealms_mirror::mirror full(self, apply);
+    double start = now_ns();
+    {
+        std::ifstream trace(trace_path);
+        full.apply_stream(trace);
+    }
+    double full_ns = now_ns() - start;
+
+    //partial replay and checkpoint
+    double checkpoint_ns = 0;
+    {
+        drealms_mirror::mirror partial(self, apply);
+        std::ifstream trace(trace_path);
+        drealms_mirror::trace_record rec;
+        while (rec.sequence < cut && drealms_mirror::read_trace(trace, self, rec)) {
+            partial.apply(rec);
+        }
+        start = now_ns();
+        partial.checkpoint(checkpoint_path);
+        checkpoint_ns = now_ns() - start;
+    }
+
+    //restart from the checkpoint and catch up on the tail
+    drealms_mirror::mirror restarted(self, apply);
+    start = now_ns();
+    restarted.load(checkpoint_path);
+    double load_ns = now_ns() - start;
+
+    uint64_t tail = 0;
+    start = now_ns();
+    {
+        std::ifstream trace(trace_path);
+        tail = restarted.apply_stream(trace);
+    }
+    double tail_ns = now_ns() - start;
+
+    FILE* f = fopen(checkpoint_path.c_str(), "rb");
+    fseek(f, 0, SEEK_END);
+    long checkpoint_bytes = ftell(f);
+    fclose(f);
+
+    printf("trace:      %llu actions\n", (unsigned long long)sequence);
+    printf("full:       %.3f s (%.0f actions/s)\n", full_ns / 1e9, sequence / (full_ns / 1e9));
+    printf("checkpoint: at %llu, %.1f MB written in %.3f s\n", (unsigned long long)cut, checkpoint_bytes / 1e6, checkpoint_ns / 1e9);
+    printf("restart:    load %.3f s, %llu tail actions in %.3f s, %.3f s total\n",
+        load_ns / 1e9, (unsigned long long)tail, tail_ns / 1e9, (load_ns + tail_ns) / 1e9);
+
+    bool ok = true;
+    for (auto* m : {&full, &restarted}) {
+        const char* label = m == &full ? "full" : "restarted";
+        if (m->position() != sequence) {
+            fprintf(stderr, "%s mirror stopped at %llu\n", label, (unsigned long long)m->position());
+            ok = false;
+        }
+        if (!same_rows(m->chain(), c)) {
+            fprintf(stderr, "%s mirror rows differ from the chain\n", label);
+            ok = false;
+        }
+        if (!indexes_match(*m)) {
+            fprintf(stderr, "%s mirror indexes differ from a scan\n", label);
+            ok = false;
+        }
+    }
+
+    remove(trace_path.c_str());
+    remove(checkpoint_path.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Parallel replay throughput against a serial replay.
+//
+// Records the synthetic workload from workload.hpp as a trace, replays it
+// serially into a state mirror, then replays it with the parallel engine
+// at each thread count. Every replay must end with exactly the rows of the
+// source chain, and every table access the native host records during an
+// untimed serial replay must be one access.hpp predicted for the action.
+// The schedule must also leave at least --min-parallelism actions in
+// parallel on average (actions over critical path), so a table access
+// that serializes the trace fails even on a machine with one core.
+//
+// usage: bench_replay [--threads=1,2,4,8] [--min-parallelism=20] [workload flags...]
+//
+// @copyright defined in LICENSE.txt
+
+#include "trace.hpp"
+#include "../replay/replay.hpp"
+
+using namespace bench;
+
+int main(int argc, char** argv) {
+    workload_config cfg;
+    cfg.operations = 200000;
+    vector<unsigned> thread_counts = {1, 2, 4, 8};
+    double min_parallelism = 20; //0 to skip, e.g. for tiny workloads
+    for (int a = 1; a < argc; ++a) {
+        std::string flag = argv[a];
+        if (flag.rfind("--threads=", 0) == 0) {
+            thread_counts.clear();
+            std::stringstream ss(flag.substr(10));
+            std::string count;
+            while (std::getline(ss, count, ',')) {
+                thread_counts.push_back(std::stoul(count));
+            }
+        } else if (flag.rfind("--min-parallelism=", 0) == 0) {
+            min_parallelism = std::stod(flag.substr(18));
+        } else if (!cfg.parse_flag(flag)) {
+            fprintf(stderr, "unknown flag %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    auto records = record_workload(cfg);
+    auto& c = host::get_chain();
+
+    drealms_replay::access_map accesses(self);
+    auto s = drealms_replay::build_schedule(records, accesses);
+    double parallelism = double(records.size()) / std::max(s.critical_path, 1u);
+    printf("trace:    %zu actions, %llu dependencies, %llu barriers, critical path %u (%.1f actions in parallel on average)\n\n",
+        records.size(), (unsigned long long)s.edges, (unsigned long long)s.barriers, s.critical_path, parallelism);
+
+    bool ok = true;
+
+    if (parallelism < min_parallelism) {
+        fprintf(stderr, "schedule leaves %.1f actions in parallel on average, below --min-parallelism=%g\n", parallelism, min_parallelism);
+        ok = false;
+    }
+
+    //predicted accesses against the ones actually made
+    {
+        drealms_mirror::mirror m(self, apply);
+        drealms_replay::access_map predictions(self);
+        vector<drealms_replay::access> predicted;
+        vector<host::table_access> actual;
+        uint64_t checked = 0, missed = 0;
+
+        host::current_accesses = &actual;
+        for (auto& rec : records) {
+            bool known = predictions.accesses(rec.act, predicted);
+            actual.clear();
+            m.apply(rec);
+            if (!known) {
+                continue;
+            }
+            checked += 1;
+            for (auto& a : actual) {
+                if (a.code != self || drealms_replay::covers(predicted, a)) {
+                    continue;
+                }
+                if (missed++ < 10) {
+                    fprintf(stderr, "%s at %llu %s %s scope %s key %llu, not in access.hpp\n", rec.act.name.to_string().c_str(),
+                        (unsigned long long)rec.sequence, a.write ? "writes" : a.seek ? "seeks" : "reads", a.table_name.to_string().c_str(),
+                        name(a.scope).to_string().c_str(), (unsigned long long)a.primary_key);
+                }
+            }
+        }
+        host::current_accesses = nullptr;
+
+        printf("accesses: %llu actions checked, %llu unpredicted accesses\n\n", (unsigned long long)checked, (unsigned long long)missed);
+        ok = ok && missed == 0;
+    }
+
+    //serial baseline
+    double serial_ns = 0;
+    {
+        drealms_mirror::mirror m(self, apply);
+        double start = now_ns();
+        for (auto& rec : records) {
+            m.apply(rec);
+        }
+        serial_ns = now_ns() - start;
+        if (!same_rows(m.chain(), c)) {
+            fprintf(stderr, "serial replay differs from the chain\n");
+            ok = false;
+        }
+    }
+
+    printf("%-8s %10s %14s %8s\n", "threads", "seconds", "actions/s", "speedup");
+    printf("%-8s %10.3f %14.0f %8.2f\n", "serial", serial_ns / 1e9, records.size() / (serial_ns / 1e9), 1.0);
+
+    for (auto threads : thread_counts) {
+        drealms_mirror::mirror m(self, apply);
+        drealms_replay::replay_engine engine(threads);
+
+        double start = now_ns();
+        try {
+            engine.run(m, self, records);
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%u threads: %s\n", threads, e.what());
+            ok = false;
+            continue;
+        }
+        double ns = now_ns() - start;
+
+        printf("%-8u %10.3f %14.0f %8.2f\n", threads, ns / 1e9, records.size() / (ns / 1e9), serial_ns / ns);
+
+        if (m.position() != records.size() || !same_rows(m.chain(), c)) {
+            fprintf(stderr, "%u threads: replay differs from the chain\n", threads);
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
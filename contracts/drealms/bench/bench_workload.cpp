@@ -0,0 +1,116 @@
+// Throughput benchmark replaying a synthetic realm workload.
+//
+// Builds a realm from workload.hpp, replays a stream of gameplay operations
+// and reports throughput, latency percentiles per action and how much each
+// table grew.
+//
+// usage: bench_workload [--schemas=100] [--nfts=1000] [--licenses=10] [--players=10000] [--funded=1000]
+//                       [--ops=100000] [--mix=issuenft=20,transfernft=40,...] [--seed=1]
+//                       [--uri-prefix=https://cdn.example.io/meta/] ...
+//
+// @copyright defined in LICENSE.txt
+
+#include <algorithm>
+
+#include "workload.hpp"
+
+using namespace bench;
+
+static const vector<name> tables = {
+    name("schemas"), name("licenses"), name("nfts"), name("currencies"), name("accounts"), name("holdings"),
+    name("migrations"), name("uriprefixes")
+};
+
+struct latency {
+    vector<double> samples;
+    uint64_t failures = 0;
+
+    double percentile(double p) {
+        if (samples.empty()) {
+            return 0;
+        }
+        size_t i = std::min(samples.size() - 1, size_t(p * double(samples.size())));
+        std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+        return samples[i];
+    }
+};
+
+int main(int argc, char** argv) {
+    workload_config cfg;
+    for (int a = 1; a < argc; ++a) {
+        if (!cfg.parse_flag(argv[a])) {
+            fprintf(stderr, "unknown flag %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    install();
+    auto& c = host::get_chain();
+
+    workload wl(cfg);
+    for (auto account : wl.accounts()) {
+        c.create_account(account);
+    }
+
+    //build
+    uint64_t build_actions = 0;
+    double build_start = now_ns();
+    wl.build_realm([&](const host::action_data& act) {
+        c.push_action(act);
+        build_actions += 1;
+    });
+    double build_ns = now_ns() - build_start;
+
+    map<name, table_usage> before;
+    for (auto t : tables) {
+        before[t] = measure_table(t);
+    }
+
+    //replay
+    map<name, latency> latencies;
+    double replay_start = now_ns();
+    for (uint64_t i = 0; i < cfg.operations; ++i) {
+        auto act = wl.next_op();
+        auto& lat = latencies[act.name];
+
+        double start = now_ns();
+        try {
+            c.push_action(act);
+        } catch (const std::exception& e) {
+            lat.failures += 1;
+            continue;
+        }
+        lat.samples.push_back(now_ns() - start);
+    }
+    double replay_ns = now_ns() - replay_start;
+
+    //report
+    printf("build:  %llu actions in %.2f s (%.0f actions/s)\n",
+        (unsigned long long)build_actions, build_ns / 1e9, build_actions / (build_ns / 1e9));
+    printf("replay: %llu operations in %.2f s (%.0f ops/s)\n\n",
+        (unsigned long long)cfg.operations, replay_ns / 1e9, cfg.operations / (replay_ns / 1e9));
+
+    printf("%-14s %9s %8s %10s %10s %10s %10s %10s\n", "action", "count", "failed", "mean ns", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    for (auto& l : latencies) {
+        auto& s = l.second.samples;
+        double mean = 0;
+        for (auto v : s) {
+            mean += v;
+        }
+        mean = s.empty() ? 0 : mean / s.size();
+        printf("%-14s %9zu %8llu %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+            l.first.to_string().c_str(), s.size(), (unsigned long long)l.second.failures, mean,
+            l.second.percentile(0.5), l.second.percentile(0.99), l.second.percentile(0.999), l.second.percentile(1.0));
+    }
+
+    printf("\n%-12s %10s %10s %12s %12s %12s\n", "table", "scopes", "rows", "rows grown", "billed B", "B grown");
+    for (auto t : tables) {
+        auto after = measure_table(t);
+        printf("%-12s %10llu %10llu %12lld %12lld %12lld\n", t.to_string().c_str(),
+            (unsigned long long)after.scopes, (unsigned long long)after.rows,
+            (long long)(after.rows - before[t].rows), (long long)after.billed(), (long long)(after.billed() - before[t].billed()));
+    }
+    printf("\ntotal billed ram: %lld bytes\n", (long long)c.total_ram_usage());
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+// Columnar snapshot export and analytics queries.
+//
+// Exports drealms tables to the columnar format of analytics/columns.hpp
+// and runs a handful of economy queries on it: experience per schema, the
+// level distribution, holders per schema and per currency, and stat totals.
+// Without --export or --query, records the synthetic workload from
+// workload.hpp (with checksums and a shared uri prefix, so every exported
+// table gets rows), exports the resulting chain and times the queries on
+// the mapped snapshot against decoding every row with client/rows.hpp,
+// failing if a table is empty or the two disagree.
+//
+// usage: columns --export=<mirror checkpoint> --out=<snapshot>
+//        columns --query=<snapshot>
+//        columns [--out=path] [workload flags...]
+//
+// @copyright defined in LICENSE.txt
+
+#include "trace.hpp"
+#include "../analytics/columns.hpp"
+
+using namespace bench;
+
+namespace client = drealms_client;
+namespace columns = drealms_columns;
+
+struct realm_report {
+    std::vector<std::pair<client::name, columns::summary>> exp_per_schema;
+    std::map<uint16_t, uint64_t> levels;
+    std::vector<std::pair<client::name, uint64_t>> holders_per_schema;
+    std::vector<std::pair<uint64_t, columns::summary>> holders_per_currency; //accounts with a positive balance
+    std::vector<std::pair<client::name, columns::summary>> stats;
+};
+
+static std::string_view view(const host::row& r) {
+    return std::string_view(r.data.data(), r.data.size());
+}
+
+//exports every row of the contract, returns the rows exported
+static uint64_t export_chain(host::chain& c, const std::string& path) {
+    columns::exporter out;
+    uint64_t rows = 0;
+    c.for_each_table(self, [&](uint64_t scope, name table_name, host::table& t) {
+        for (auto& r : t.rows) {
+            rows += out.add_row(client::name(table_name.value), scope, client::name(r.second.payer.value), view(r.second)) ? 1 : 0;
+        }
+    });
+    out.write(path);
+    return rows;
+}
+
+static realm_report query_snapshot(const columns::snapshot& snap) {
+    realm_report report;
+
+    auto& nfts = snap.table("nfts");
+    auto schema = nfts.names("schema");
+    report.exp_per_schema = columns::group_by(schema, nfts.values<int64_t>("exp"));
+    report.levels = columns::histogram(nfts.values<uint16_t>("level"), uint16_t(1));
+    report.holders_per_schema = columns::count_distinct(schema, nfts.names("owner"));
+
+    auto& accounts = snap.table("accounts");
+    auto balance = accounts.values<int64_t>("balance");
+    report.holders_per_currency = columns::group_by(accounts.values<uint64_t>("symbol"), balance,
+        [&](size_t row) { return balance[row] > 0; });
+
+    auto& stats = snap.table("nftstats");
+    report.stats = columns::group_by(stats.names("stat"), stats.values<uint32_t>("value"));
+    return report;
+}
+
+//the same queries by decoding every row
+static realm_report query_rows(host::chain& c) {
+    realm_report report;
+
+    std::map<uint64_t, columns::summary> exp, stats;
+    std::map<uint64_t, std::set<uint64_t>> holders;
+    c.for_each_scope(self, name("nfts"), [&](uint64_t scope, host::table& t) {
+        for (auto& r : t.rows) {
+            auto nft = client::nonfungible_row::decode(view(r.second));
+            exp[scope].add(double(nft.experience.amount));
+            report.levels[nft.level] += 1;
+            holders[scope].insert(nft.owner.value);
+            nft.for_each_stat([&](client::name stat_name, uint32_t value) {
+                stats[stat_name.value].add(double(value));
+            });
+        }
+    });
+    for (auto& e : exp) {
+        report.exp_per_schema.emplace_back(client::name(e.first), e.second);
+    }
+    for (auto& h : holders) {
+        report.holders_per_schema.emplace_back(client::name(h.first), h.second.size());
+    }
+    for (auto& s : stats) {
+        report.stats.emplace_back(client::name(s.first), s.second);
+    }
+
+    std::map<uint64_t, columns::summary> currencies;
+    c.for_each_scope(self, name("accounts"), [&](uint64_t, host::table& t) {
+        for (auto& r : t.rows) {
+            auto acct = client::account_row::decode(view(r.second));
+            if (acct.balance.amount > 0) {
+                currencies[acct.balance.sym.value].add(double(acct.balance.amount));
+            }
+        }
+    });
+    report.holders_per_currency.assign(currencies.begin(), currencies.end());
+    return report;
+}
+
+static std::string format(const realm_report& report, size_t limit) {
+    std::string out;
+    char line[256];
+    auto more = [&](size_t n) {
+        if (n > limit) {
+            snprintf(line, sizeof(line), "  ... %zu more\n", n - limit);
+            out += line;
+        }
+    };
+
+    out += "experience per schema: nfts, mean, max\n";
+    for (size_t i = 0; i < report.exp_per_schema.size() && i < limit; ++i) {
+        auto& e = report.exp_per_schema[i];
+        snprintf(line, sizeof(line), "  %-13s %10llu %12.1f %12.0f\n", e.first.to_string().c_str(),
+            (unsigned long long)e.second.count, e.second.mean(), e.second.max);
+        out += line;
+    }
+    more(report.exp_per_schema.size());
+
+    out += "level distribution: level, nfts\n";
+    size_t shown = 0;
+    for (auto& l : report.levels) {
+        if (shown++ == limit) {
+            break;
+        }
+        snprintf(line, sizeof(line), "  %-13u %10llu\n", unsigned(l.first), (unsigned long long)l.second);
+        out += line;
+    }
+    more(report.levels.size());
+
+    out += "holders per schema\n";
+    for (size_t i = 0; i < report.holders_per_schema.size() && i < limit; ++i) {
+        auto& h = report.holders_per_schema[i];
+        snprintf(line, sizeof(line), "  %-13s %10llu\n", h.first.to_string().c_str(), (unsigned long long)h.second);
+        out += line;
+    }
+    more(report.holders_per_schema.size());
+
+    out += "holders per currency: holders, mean balance\n";
+    for (size_t i = 0; i < report.holders_per_currency.size() && i < limit; ++i) {
+        auto& h = report.holders_per_currency[i];
+        client::symbol sym{h.first};
+        snprintf(line, sizeof(line), "  %-13s %10llu %12.1f\n", sym.code().c_str(), (unsigned long long)h.second.count, h.second.mean());
+        out += line;
+    }
+    more(report.holders_per_currency.size());
+
+    out += "stats: nfts, mean, max\n";
+    for (size_t i = 0; i < report.stats.size() && i < limit; ++i) {
+        auto& s = report.stats[i];
+        snprintf(line, sizeof(line), "  %-13s %10llu %12.2f %12.0f\n", s.first.to_string().c_str(),
+            (unsigned long long)s.second.count, s.second.mean(), s.second.max);
+        out += line;
+    }
+    more(report.stats.size());
+    return out;
+}
+
+static void print_tables(const columns::snapshot& snap) {
+    printf("%-13s %12s %8s\n", "table", "rows", "columns");
+    for (auto& t : snap.tables()) {
+        printf("%-13s %12zu %8zu\n", t.table_name().to_string().c_str(), t.size(), t.column_count());
+    }
+    printf("%-13s %12.1f MB\n\n", "file", snap.bytes() / 1e6);
+}
+
+int main(int argc, char** argv) {
+    workload_config cfg;
+    cfg.operations = 20000;
+    cfg.mix[name("newchecksum")] = 10;
+    cfg.uri_prefix = "https://cdn.goodblockgames.io/dragons/metadata/";
+    std::string export_path, query_path;
+    std::string out_path = "/tmp/drealms.columns";
+    bool keep_output = false;
+    for (int a = 1; a < argc; ++a) {
+        std::string flag = argv[a];
+        if (flag.rfind("--export=", 0) == 0) {
+            export_path = flag.substr(9);
+        } else if (flag.rfind("--query=", 0) == 0) {
+            query_path = flag.substr(8);
+        } else if (flag.rfind("--out=", 0) == 0) {
+            out_path = flag.substr(6);
+            keep_output = true;
+        } else if (!cfg.parse_flag(flag)) {
+            fprintf(stderr, "unknown flag %s\n", argv[a]);
+            return 1;
+        }
+    }
+
+    try {
+        if (!export_path.empty()) {
+            drealms_mirror::mirror m(self, apply);
+            m.load(export_path);
+            double start = now_ns();
+            uint64_t rows = export_chain(m.chain(), out_path);
+            printf("exported %llu rows at sequence %llu to %s in %.3f s\n", (unsigned long long)rows,
+                (unsigned long long)m.position(), out_path.c_str(), (now_ns() - start) / 1e9);
+            return 0;
+        }
+
+        if (!query_path.empty()) {
+            columns::snapshot snap(query_path);
+            print_tables(snap);
+            double start = now_ns();
+            auto report = query_snapshot(snap);
+            double ns = now_ns() - start;
+            printf("%s\nqueries: %.3f s\n", format(report, 10).c_str(), ns / 1e9);
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    //benchmark on the synthetic workload
+    record_workload(cfg);
+    auto& c = host::get_chain();
+
+    double start = now_ns();
+    uint64_t rows = export_chain(c, out_path);
+    double export_ns = now_ns() - start;
+
+    start = now_ns();
+    columns::snapshot snap(out_path);
+    double open_ns = now_ns() - start;
+
+    start = now_ns();
+    auto from_columns = query_snapshot(snap);
+    double columns_ns = now_ns() - start;
+
+    start = now_ns();
+    auto from_rows = query_rows(c);
+    double rows_ns = now_ns() - start;
+
+    print_tables(snap);
+    printf("%s\n", format(from_columns, 5).c_str());
+    printf("export:   %llu rows in %.3f s\n", (unsigned long long)rows, export_ns / 1e9);
+    printf("open:     %.6f s\n", open_ns / 1e9);
+    printf("queries:  %.4f s on columns, %.4f s decoding rows (%.1fx)\n", columns_ns / 1e9, rows_ns / 1e9, rows_ns / columns_ns);
+
+    bool ok = true;
+    for (auto& t : snap.tables()) {
+        if (t.size() == 0) {
+            fprintf(stderr, "%s exported no rows\n", t.table_name().to_string().c_str());
+            ok = false;
+        }
+    }
+    if (format(from_columns, SIZE_MAX) != format(from_rows, SIZE_MAX)) {
+        fprintf(stderr, "column queries differ from decoded rows\n");
+        ok = false;
+    }
+    if (!keep_output) {
+        remove(out_path.c_str());
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+// Native dispatcher for the drealms contract.
+//
+// eosio-cpp generates the wasm dispatcher from the ACTION declarations; the
+// host build lists them here instead. Include from exactly one translation
+// unit per program, and add every new ACTION.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <drealms.hpp>
+
+EOSIO_DISPATCH(drealms, (setrealmdata)(setnotify)
+    (subscribe)(unsubscribe)
+    (newnftschema)(toggle)(addstat)(syncstats)(awardexp)
+    (setlicmodel)(newlicense)(eraselicense)(setlicminmax)(setalgo)(setati)(newuri)(deleteuri)
+    (issuenft)(retirenft)(transfernft)(swapnft)(consumenft)(retirerange)(consumerange)(activatenft)(newchecksum)(levelup)(spendpoint)(viewnfts)(countnfts)
+    (newrecipe)(eraserecipe)(craft)
+    (batch)
+    (create)(issue)(retire)(transfer)(consume)(open)(close)
+    (migrate)
+    (logevents))
@@ -0,0 +1,93 @@
+// Shared setup for native drealms benchmarks.
+//
+// Registers the contract on the host chain and provides helpers to build
+// accounts, names and actions, and to read rows straight from the host
+// database without touching the action counters.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "dispatch.hpp"
+
+namespace bench {
+
+    using namespace eosio;
+
+    inline const name self = name("drealms");
+
+    //base32 name from a prefix and an index, e.g. ("acct", 28) => "acct.ab"
+    inline name indexed_name(const std::string& prefix, uint64_t i) {
+        std::string suffix;
+        do {
+            suffix = char('a' + i % 26) + suffix;
+            i /= 26;
+        } while (i > 0);
+        return name(prefix + "." + suffix);
+    }
+
+    //uppercase symbol code from an index, e.g. 28 => "BAC"
+    inline symbol_code indexed_code(uint64_t i) {
+        std::string code = "B";
+        do {
+            code += char('A' + i % 26);
+            i /= 26;
+        } while (i > 0);
+        return symbol_code(code);
+    }
+
+    inline std::vector<permission_level> auths(name actor) {
+        return {permission_level{actor, name("active")}};
+    }
+
+    template<typename... Args>
+    host::action_data make_action(name action_name, name actor, const Args&... args) {
+        return host::action_data{self, action_name, auths(actor), pack(std::make_tuple(args...))};
+    }
+
+    //pushes an action, reporting and rethrowing failures
+    template<typename... Args>
+    void push(name action_name, name actor, const Args&... args) {
+        try {
+            host::get_chain().push_action(make_action(action_name, actor, args...));
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s failed: %s\n", action_name.to_string().c_str(), e.what());
+            throw;
+        }
+    }
+
+    //reads a row without counting it as contract work
+    template<typename T>
+    bool read_row(name table_name, uint64_t scope, uint64_t primary_key, T& out) {
+        auto* t = host::get_chain().find_table(self, scope, table_name);
+        if (!t) {
+            return false;
+        }
+        auto itr = t->rows.find(primary_key);
+        if (itr == t->rows.end()) {
+            return false;
+        }
+        out = unpack<T>(itr->second.data);
+        return true;
+    }
+
+    //installs the contract and a set of funded test accounts
+    inline void install() {
+        auto& c = host::get_chain();
+        c.set_contract(self, apply);
+        for (auto n : {"alice", "bob", "carol"}) {
+            c.create_account(name(n));
+        }
+    }
+
+    inline double now_ns() {
+        using namespace std::chrono;
+        return double(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+}
@@ -0,0 +1,235 @@
+// Exact RAM cost of drealms table rows.
+//
+// Serializes representative rows of every table with the contract's own
+// EOSLIB_SERIALIZE layouts and adds the nodeos billing overhead of 108 bytes
+// per row and 108 bytes per table scope. Fails if a row is billed more than
+// its budget, and projects the cost of a realm of a given size. Also prints
+// what one relative uri entry costs stored whole and compressed against a
+// uri prefix, and what compressing one per nft saves in the projection.
+//
+// usage: ramcalc [--stats=6] [--uri-length=48] [--schemas=1] [--nfts=1000000]
+//                [--licenses=100] [--holders=100000] [--currencies=1]
+//
+// @copyright defined in LICENSE.txt
+
+#include <cstring>
+
+#include "fixture.hpp"
+
+using namespace bench;
+
+struct ram_config {
+    uint64_t stats = 6; //stats per schema and nft
+    uint64_t uri_length = 48; //characters per uri and checksum
+
+    //projection
+    uint64_t schemas = 1;
+    uint64_t nfts = 1000000; //per schema
+    uint64_t licenses = 100; //per schema
+    uint64_t holders = 100000; //accounts holding each currency and nfts of each schema
+    uint64_t currencies = 1;
+};
+
+//billed bytes per row, including the per-row overhead, for the default config
+static const map<name, int64_t> budgets = {
+    {name("realmdata"), 140},
+    {name("schemas"), 320},
+    {name("licenses"), 290},
+    {name("nfts"), 330},
+    {name("currencies"), 170},
+    {name("accounts"), 130},
+    {name("holdings"), 130},
+    {name("recipes"), 200},
+    {name("subscribers"), 140},
+    {name("cleanups"), 160},
+    {name("migrations"), 140},
+    {name("uriprefixes"), 170},
+};
+
+struct row_cost {
+    name table_name;
+    size_t packed;
+
+    int64_t billed() const { return int64_t(packed) + host::billable_row_overhead; }
+};
+
+static string filler(char c, uint64_t length) {
+    return string(length, c);
+}
+
+static vector<row_cost> representative_rows(const ram_config& cfg) {
+    const symbol exp_sym = symbol("EXP", 0);
+    const symbol gold_sym = symbol("GOLD", 2);
+
+    map<name, uint32_t> stats;
+    for (uint64_t i = 0; i < cfg.stats; ++i) {
+        stats[indexed_name("stat", i)] = 10;
+    }
+
+    drealms::realmdata realm{"v0.2.0", name("fantasy"), {}, {}, name("subscribed")};
+
+    drealms::schema sch;
+    sch.schema_name = name("dragons");
+    sch.issuer = name("goodblocktls");
+    sch.supply = 1000000;
+    sch.issued_supply = 1000000;
+    sch.max_supply = 10000000;
+    sch.license_model = name("permissioned");
+    sch.min_license_length = 604800;
+    sch.max_license_length = 31449600;
+    sch.settings = {
+        {name("retirable"), true}, {name("transferable"), true}, {name("consumable"), false},
+        {name("activatable"), false}, {name("logevents"), false}, {name("holdings"), true}
+    };
+    sch.default_stats = stats;
+    sch.exp_symbol = exp_sym;
+
+    drealms::license lic;
+    lic.owner = name("goodblocktls");
+    lic.expiration = time_point_sec(1609459200);
+    lic.checksum_algo = "sha256";
+    lic.full_uris = {{name("ati"), filler('a', cfg.uri_length)}};
+    lic.base_uris = {{name("meta"), filler('b', cfg.uri_length)}};
+    lic.ati_hash.emplace();
+
+    drealms::nonfungible nft;
+    nft.serial = 1000000;
+    nft.owner = name("readyplayer1");
+    nft.level = 10;
+    nft.experience = asset(123456, exp_sym);
+    nft.next_level = asset(200000, exp_sym);
+    nft.unspent = 2;
+    nft.stats = stats;
+    nft.relative_uris = {{name("goodblocktls"), filler('r', cfg.uri_length / 4)}};
+    nft.checksums = {{name("goodblocktls"), filler('c', 64)}};
+
+    drealms::currency curr{name("goodblocktls"), true, true, true, asset(1000000, gold_sym), asset(100000000, gold_sym)};
+
+    drealms::account acct{asset(5000, gold_sym)};
+
+    drealms::holding hold{name("dragons"), 12};
+
+    drealms::subscriber sub{name("readyplayer1"), {name("dragons")}, {}};
+
+    drealms::recipe rec{name("forge"), {{name("dragons"), 2}, {name("eggs"), 1}}, {asset(500, gold_sym)},
+        {{indexed_name("stat", 0), 12}, {indexed_name("stat", 1), 12}}};
+
+    drealms::cleanup cln{name("goodblocktls"), name("retire"), 1, 1000000, 250001, 250000};
+
+    drealms::migration mig{name("dragons"), 500000, 500000, false, uint8_t(1)};
+
+    drealms::uriprefix pre{name("goodblocktls"), {filler('p', cfg.uri_length * 5 / 6)}};
+
+    //singletons store their value wrapped in a one field row
+    return {
+        {name("realmdata"), pack_size(realm)},
+        {name("schemas"), pack_size(sch)},
+        {name("licenses"), pack_size(lic)},
+        {name("nfts"), pack_size(nft)},
+        {name("currencies"), pack_size(curr)},
+        {name("accounts"), pack_size(acct)},
+        {name("holdings"), pack_size(hold)},
+        {name("recipes"), pack_size(rec)},
+        {name("subscribers"), pack_size(sub)},
+        {name("cleanups"), pack_size(cln)},
+        {name("migrations"), pack_size(mig)},
+        {name("uriprefixes"), pack_size(pre)},
+    };
+}
+
+//packed bytes of one relative uri entry of an nft, stored whole and compressed with the uri prefix of representative_rows
+static std::pair<size_t, size_t> uri_entry(const ram_config& cfg) {
+    size_t prefix = cfg.uri_length * 5 / 6;
+    string uri = filler('p', prefix) + filler('r', cfg.uri_length - prefix);
+    string compressed = "{0}" + uri.substr(prefix);
+    map<name, string> whole_entry = {{name("goodblocktls"), uri}};
+    map<name, string> compressed_entry = {{name("goodblocktls"), prefix >= drealms::uriprefix::min_length ? compressed : uri}};
+
+    //both maps hold one entry, so the entry count prefix cancels out
+    return {pack_size(whole_entry) - 1, pack_size(compressed_entry) - 1};
+}
+
+static bool parse_flag(ram_config& cfg, const string& flag) {
+    auto eq = flag.find('=');
+    if (flag.rfind("--", 0) != 0 || eq == string::npos) {
+        return false;
+    }
+    auto key = flag.substr(2, eq - 2);
+    uint64_t value = std::stoull(flag.substr(eq + 1));
+
+    if (key == "stats") cfg.stats = value;
+    else if (key == "uri-length") cfg.uri_length = value;
+    else if (key == "schemas") cfg.schemas = value;
+    else if (key == "nfts") cfg.nfts = value;
+    else if (key == "licenses") cfg.licenses = value;
+    else if (key == "holders") cfg.holders = value;
+    else if (key == "currencies") cfg.currencies = value;
+    else return false;
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ram_config cfg;
+    bool row_config_changed = false;
+    for (int a = 1; a < argc; ++a) {
+        if (!parse_flag(cfg, argv[a])) {
+            fprintf(stderr, "unknown flag %s\n", argv[a]);
+            return 1;
+        }
+        row_config_changed |= strncmp(argv[a], "--stats=", 8) == 0 || strncmp(argv[a], "--uri-length=", 13) == 0;
+    }
+
+    auto rows = representative_rows(cfg);
+    map<name, int64_t> billed;
+
+    //rows
+    bool over_budget = false;
+    printf("%-12s %8s %8s %8s\n", "table", "packed", "billed", "budget");
+    for (auto& r : rows) {
+        int64_t budget = budgets.at(r.table_name);
+        bool over = r.billed() > budget;
+        billed[r.table_name] = r.billed();
+        printf("%-12s %8zu %8lld %8lld%s\n", r.table_name.to_string().c_str(), r.packed, (long long)r.billed(), (long long)budget,
+            over ? "  OVER BUDGET" : "");
+        over_budget |= over;
+    }
+
+    //projection, every schema has its own licenses and nfts scope, every holder its own accounts and holdings scope
+    int64_t scope = host::billable_table_overhead;
+    int64_t schemas = cfg.schemas * billed[name("schemas")] + scope;
+    int64_t licenses = cfg.schemas * (cfg.licenses * billed[name("licenses")] + scope);
+    int64_t nfts = cfg.schemas * (cfg.nfts * billed[name("nfts")] + scope);
+    int64_t currencies = cfg.currencies * billed[name("currencies")] + scope;
+    int64_t accounts = cfg.holders * (cfg.currencies * billed[name("accounts")] + scope);
+    int64_t holdings = cfg.holders * (cfg.schemas * billed[name("holdings")] + scope);
+    int64_t total = billed[name("realmdata")] + scope + schemas + licenses + nfts + currencies + accounts + holdings;
+
+    printf("\nprojection: %llu schemas, %llu nfts and %llu licenses each, %llu stats, %llu currencies over %llu holders\n",
+        (unsigned long long)cfg.schemas, (unsigned long long)cfg.nfts, (unsigned long long)cfg.licenses,
+        (unsigned long long)cfg.stats, (unsigned long long)cfg.currencies, (unsigned long long)cfg.holders);
+    printf("%-12s %16s\n", "table", "billed bytes");
+    printf("%-12s %16lld\n", "schemas", (long long)schemas);
+    printf("%-12s %16lld\n", "licenses", (long long)licenses);
+    printf("%-12s %16lld\n", "nfts", (long long)nfts);
+    printf("%-12s %16lld\n", "currencies", (long long)currencies);
+    printf("%-12s %16lld\n", "accounts", (long long)accounts);
+    printf("%-12s %16lld\n", "holdings", (long long)holdings);
+    printf("%-12s %16lld (%.2f MiB)\n", "total", (long long)total, total / (1024.0 * 1024.0));
+
+    //relative uris sharing one prefix per license, one entry per nft
+    auto [whole, compressed] = uri_entry(cfg);
+    int64_t saved = int64_t(cfg.schemas * cfg.nfts * (whole - compressed)) - int64_t(cfg.schemas) * (cfg.licenses * billed[name("uriprefixes")] + scope);
+    printf("\nrelative uri of %llu characters: %zu bytes whole, %zu bytes compressed\n", (unsigned long long)cfg.uri_length, whole, compressed);
+    printf("with one per nft, compressing saves %lld bytes (%.2f MiB) after every license's uriprefixes row\n",
+        (long long)saved, saved / (1024.0 * 1024.0));
+
+    //budgets only apply to the default row shapes
+    if (over_budget && !row_config_changed) {
+        fflush(stdout);
+        fprintf(stderr, "\nrow size over budget\n");
+        return 1;
+    }
+
+    return 0;
+}
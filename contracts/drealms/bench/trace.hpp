@@ -0,0 +1,79 @@
+// Recorded workloads for native benchmarks of the mirror and replay.
+//
+// Runs the synthetic workload on the host chain, half a second of block
+// time per action, and keeps every action that succeeded as a trace
+// record, the same way a node's action history would hold them.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <set>
+
+#include "workload.hpp"
+#include "../mirror/mirror.hpp"
+
+namespace bench {
+
+    //builds and plays the workload on the default chain, returns the actions that succeeded
+    inline vector<drealms_mirror::trace_record> record_workload(const workload_config& cfg) {
+        install();
+        auto& c = host::get_chain();
+        workload wl(cfg);
+        for (auto account : wl.accounts()) {
+            c.create_account(account);
+        }
+
+        vector<drealms_mirror::trace_record> records;
+        auto record = [&](const host::action_data& act) {
+            c.now += microseconds(500000); //one action per block
+            try {
+                c.push_action(act);
+            } catch (const std::exception&) {
+                return;
+            }
+            records.push_back(drealms_mirror::trace_record{records.size() + 1, c.now.time_since_epoch().count() / 1000, act});
+        };
+
+        wl.build_realm(record);
+        for (uint64_t i = 0; i < cfg.operations; ++i) {
+            record(wl.next_op());
+        }
+        return records;
+    }
+
+    //true if both chains hold the same rows of the contract, billed to the same payers for each row and table scope
+    inline bool same_rows(host::chain& a, host::chain& b) {
+        uint64_t rows_a = 0;
+        bool same = true;
+        std::set<uint64_t> payers;
+        a.for_each_table(self, [&](uint64_t scope, name table_name, host::table& t) {
+            auto* other = b.find_table(self, scope, table_name);
+            if (!t.rows.empty()) {
+                payers.insert(t.payer.value);
+                same = same && other && other->payer == t.payer;
+            }
+            for (auto& r : t.rows) {
+                rows_a += 1;
+                payers.insert(r.second.payer.value);
+                if (!other) {
+                    same = false;
+                    continue;
+                }
+                auto itr = other->rows.find(r.first);
+                same = same && itr != other->rows.end() && itr->second.data == r.second.data && itr->second.payer == r.second.payer;
+            }
+        });
+
+        uint64_t rows_b = 0;
+        b.for_each_table(self, [&](uint64_t, name, host::table& t) {
+            rows_b += t.rows.size();
+        });
+
+        for (auto payer : payers) {
+            same = same && a.ram_usage(name(payer)) == b.ram_usage(name(payer));
+        }
+        return same && rows_a == rows_b && a.total_ram_usage() == b.total_ram_usage();
+    }
+
+}
@@ -0,0 +1,286 @@
+// Synthetic realm workload for native drealms benchmarks.
+//
+// Generates the actions that build a production shaped realm (studios
+// issuing many schemas, each with licenses and NFTs spread over a player
+// base, and one currency each funding some of the players) and then a stream of gameplay operations drawn from a configurable
+// mix. Owners, schemas and serials are drawn from skewed distributions so a
+// few hot players and items get most of the traffic.
+//
+// The generator tracks ownership itself, so every operation it emits is
+// valid as long as the ones before it succeeded.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <sstream>
+
+#include "fixture.hpp"
+
+namespace bench {
+
+    struct workload_config {
+        uint64_t studios = 10; //schema issuers
+        uint64_t schemas = 100;
+        uint64_t nfts_per_schema = 1000;
+        uint64_t licenses_per_schema = 10;
+        uint64_t stats_per_schema = 6;
+        uint64_t players = 10000;
+        uint64_t funded_players = 1000; //players given a balance of their studio's currency
+        uint64_t operations = 100000;
+
+        //1.0 is uniform, higher values concentrate traffic on low indices
+        double schema_skew = 1.5;
+        double owner_skew = 2.0;
+        double serial_skew = 2.0;
+
+        uint64_t seed = 1;
+
+        //prepended to the relative uris newuri sets, e.g. a cdn host and path shared by every nft
+        std::string uri_prefix;
+
+        //relative weight of each gameplay action
+        map<name, uint32_t> mix = {
+            {name("issuenft"), 20},
+            {name("transfernft"), 40},
+            {name("awardexp"), 20},
+            {name("levelup"), 10},
+            {name("newuri"), 10},
+        };
+
+        //parses "issuenft=20,transfernft=40"
+        void parse_mix(const std::string& spec) {
+            mix.clear();
+            std::stringstream ss(spec);
+            std::string entry;
+            while (std::getline(ss, entry, ',')) {
+                auto eq = entry.find('=');
+                check(eq != std::string::npos, "mix entries must look like action=weight");
+                mix[name(entry.substr(0, eq))] = std::stoul(entry.substr(eq + 1));
+            }
+        }
+
+        //parses --key=value flags, returns false on an unknown flag
+        bool parse_flag(const std::string& flag) {
+            auto eq = flag.find('=');
+            if (flag.rfind("--", 0) != 0 || eq == std::string::npos) {
+                return false;
+            }
+            auto key = flag.substr(2, eq - 2);
+            auto value = flag.substr(eq + 1);
+
+            if (key == "studios") studios = std::stoull(value);
+            else if (key == "schemas") schemas = std::stoull(value);
+            else if (key == "nfts") nfts_per_schema = std::stoull(value);
+            else if (key == "licenses") licenses_per_schema = std::stoull(value);
+            else if (key == "stats") stats_per_schema = std::stoull(value);
+            else if (key == "players") players = std::stoull(value);
+            else if (key == "funded") funded_players = std::stoull(value);
+            else if (key == "ops") operations = std::stoull(value);
+            else if (key == "schema-skew") schema_skew = std::stod(value);
+            else if (key == "owner-skew") owner_skew = std::stod(value);
+            else if (key == "serial-skew") serial_skew = std::stod(value);
+            else if (key == "seed") seed = std::stoull(value);
+            else if (key == "uri-prefix") uri_prefix = value;
+            else if (key == "mix") parse_mix(value);
+            else return false;
+
+            return true;
+        }
+    };
+
+    class workload {
+
+    public:
+
+        using sink = std::function<void(const host::action_data&)>;
+
+        static inline const symbol exp_symbol = symbol("EXP", 0);
+
+        explicit workload(const workload_config& config) : cfg(config), rng(config.seed) {
+            for (auto& m : cfg.mix) {
+                mix_names.push_back(m.first);
+                mix_weights.push_back(m.second);
+            }
+            mix_dist = std::discrete_distribution<size_t>(mix_weights.begin(), mix_weights.end());
+        }
+
+        name studio(uint64_t i) const { return indexed_name("studio", i); }
+
+        name player(uint64_t i) const { return indexed_name("p", i); }
+
+        name licensee(uint64_t i) const { return indexed_name("lic", i); }
+
+        name schema_name(uint64_t i) const { return indexed_name("sch", i); }
+
+        name stat_name(uint64_t i) const { return indexed_name("stat", i); }
+
+        name issuer_of(uint64_t schema) const { return studio(schema % cfg.studios); }
+
+        symbol currency(uint64_t studio) const { return symbol(indexed_code(studio), 2); }
+
+        //every account the workload signs with or sends to
+        vector<name> accounts() const {
+            vector<name> result;
+            for (uint64_t i = 0; i < cfg.studios; ++i) {
+                result.push_back(studio(i));
+            }
+            for (uint64_t i = 0; i < cfg.licenses_per_schema; ++i) {
+                result.push_back(licensee(i));
+            }
+            for (uint64_t i = 0; i < cfg.players; ++i) {
+                result.push_back(player(i));
+            }
+            return result;
+        }
+
+        //emits schemas, stats, licenses, the initial nft supply and currency balances
+        void build_realm(const sink& emit) {
+            owners.assign(cfg.schemas, {});
+
+            emit(make_action(name("setrealmdata"), self, string("v0.2.0"), name("bench")));
+
+            //each studio funds every studios-th player
+            for (uint64_t st = 0; st < cfg.studios; ++st) {
+                emit(make_action(name("create"), studio(st), studio(st), true, true, true, asset(int64_t(1) << 60, currency(st))));
+            }
+            for (uint64_t p = 0; p < std::min(cfg.funded_players, cfg.players); ++p) {
+                uint64_t st = p % cfg.studios;
+                emit(make_action(name("issue"), studio(st), player(p), asset(100000, currency(st)), string("")));
+            }
+
+            for (uint64_t s = 0; s < cfg.schemas; ++s) {
+                name sch = schema_name(s);
+                name issuer = issuer_of(s);
+
+                emit(make_action(name("newnftschema"), issuer, sch, issuer, uint64_t(-1) / 2, exp_symbol, true, true, true, true));
+                for (uint64_t st = 0; st < cfg.stats_per_schema; ++st) {
+                    emit(make_action(name("addstat"), issuer, sch, stat_name(st), uint32_t(1)));
+                }
+
+                emit(make_action(name("setlicmodel"), issuer, sch, name("permissioned")));
+                for (uint64_t l = 0; l < cfg.licenses_per_schema; ++l) {
+                    emit(make_action(name("newlicense"), issuer, sch, licensee(l), time_point_sec(current_time_point()) + 31449600 / 2));
+                    emit(make_action(name("newuri"), licensee(l), sch, licensee(l), name("base"), name("meta"),
+                        string("https://cdn.") + licensee(l).to_string() + ".io/" + sch.to_string() + "/", optional<uint64_t>()));
+                }
+
+                for (uint64_t n = 0; n < cfg.nfts_per_schema; ++n) {
+                    emit(mint(s));
+                }
+            }
+        }
+
+        //next gameplay operation from the mix
+        host::action_data next_op() {
+            name op = mix_names[mix_dist(rng)];
+            uint64_t s = skewed(cfg.schemas, cfg.schema_skew);
+
+            //operations on existing nfts fall back to a mint on an empty schema
+            if (op == name("issuenft") || owners[s].empty()) {
+                return mint(s);
+            }
+
+            uint64_t serial = skewed(owners[s].size(), cfg.serial_skew) + 1;
+            name sch = schema_name(s);
+            name owner = owners[s][serial - 1];
+
+            switch (op.value) {
+                case name("transfernft").value : {
+                    name to = pick_player();
+                    if (to == owner) {
+                        to = player((index_of_player(owner) + 1) % cfg.players);
+                    }
+                    owners[s][serial - 1] = to;
+                    return make_action(name("transfernft"), owner, owner, to, sch, vector<uint64_t>{serial}, string(""));
+                }
+                case name("awardexp").value : {
+                    name lic = licensee(rng() % std::max<uint64_t>(cfg.licenses_per_schema, 1));
+                    return make_action(name("awardexp"), lic, sch, lic, serial, asset(1 + rng() % 100, exp_symbol));
+                }
+                case name("levelup").value :
+                    return make_action(name("levelup"), owner, sch, serial);
+                case name("newuri").value : {
+                    name lic = licensee(rng() % std::max<uint64_t>(cfg.licenses_per_schema, 1));
+                    return make_action(name("newuri"), lic, sch, lic, name("relative"), name("meta"),
+                        cfg.uri_prefix + std::to_string(serial) + ".json?v=" + std::to_string(rng() % 1000), optional<uint64_t>(serial));
+                }
+                case name("newchecksum").value : {
+                    name lic = licensee(rng() % std::max<uint64_t>(cfg.licenses_per_schema, 1));
+                    return make_action(name("newchecksum"), lic, sch, lic, serial, std::to_string(rng()));
+                }
+                default:
+                    check(false, "workload mix has unsupported action " + op.to_string());
+                    return {};
+            }
+        }
+
+    private:
+
+        host::action_data mint(uint64_t s) {
+            name to = pick_player();
+            owners[s].push_back(to);
+            return make_action(name("issuenft"), issuer_of(s), to, schema_name(s), string(""), false);
+        }
+
+        name pick_player() {
+            return player(skewed(cfg.players, cfg.owner_skew));
+        }
+
+        uint64_t index_of_player(name p) const {
+            //player names are "p." followed by base26 digits, most significant first
+            auto str = p.to_string().substr(2);
+            uint64_t i = 0;
+            for (char c : str) {
+                i = i * 26 + (c - 'a');
+            }
+            return i;
+        }
+
+        //index in [0, n) from a power law, skew 1.0 is uniform
+        uint64_t skewed(uint64_t n, double skew) {
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            uint64_t i = uint64_t(double(n) * std::pow(u, skew));
+            return std::min(i, n - 1);
+        }
+
+        workload_config cfg;
+        std::mt19937_64 rng;
+
+        vector<name> mix_names;
+        vector<uint32_t> mix_weights;
+        std::discrete_distribution<size_t> mix_dist;
+
+        vector<vector<name>> owners; //owners[schema][serial - 1]
+    };
+
+    //row count and billed bytes of one contract table across all scopes
+    struct table_usage {
+        uint64_t scopes = 0;
+        uint64_t rows = 0;
+        uint64_t bytes = 0;
+
+        int64_t billed() const {
+            return int64_t(bytes) + int64_t(rows) * host::billable_row_overhead + int64_t(scopes) * host::billable_table_overhead;
+        }
+    };
+
+    inline table_usage measure_table(name table_name) {
+        table_usage usage;
+        host::get_chain().for_each_scope(self, table_name, [&](uint64_t, host::table& t) {
+            if (t.rows.empty()) {
+                return;
+            }
+            usage.scopes += 1;
+            usage.rows += t.rows.size();
+            for (auto& r : t.rows) {
+                usage.bytes += r.second.data.size();
+            }
+        });
+        return usage;
+    }
+
+}
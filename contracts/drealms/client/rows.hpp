@@ -0,0 +1,647 @@
+// Zero-copy decoder for drealms table rows.
+//
+// Decodes schema, license, nonfungible, currency, account, holding, cleanup and uri prefix rows in place
+// from their binary layout (the EOSLIB_SERIALIZE field order of
+// drealms.hpp), as returned by get_table_rows with "json": false. Strings
+// are string_views into the row buffer and maps are walked lazily, so
+// nothing is allocated while decoding and the buffer must outlive the rows
+// decoded from it.
+//
+// Header only, no eosio dependency. Assumes a little endian host.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace drealms_client {
+
+    struct decode_error : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    //======================== primitives ========================
+
+    struct name {
+        uint64_t value = 0;
+
+        constexpr name() = default;
+
+        constexpr explicit name(uint64_t v) : value(v) {}
+
+        //same encoding as eosio::name, invalid characters throw
+        constexpr explicit name(std::string_view str) {
+            if (str.size() > 13) {
+                throw decode_error("name is longer than 13 characters");
+            }
+            for (size_t i = 0; i < str.size() && i < 12; ++i) {
+                value |= (uint64_t(char_to_value(str[i])) & 0x1f) << (64 - 5 * (i + 1));
+            }
+            if (str.size() == 13) {
+                uint64_t v = char_to_value(str[12]);
+                if (v > 0x0f) {
+                    throw decode_error("thirteenth character of a name cannot be a letter after j");
+                }
+                value |= v;
+            }
+        }
+
+        std::string to_string() const {
+            static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+            std::string str(13, '.');
+            uint64_t tmp = value;
+            for (uint32_t i = 0; i <= 12; ++i) {
+                char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+                str[12 - i] = c;
+                tmp >>= (i == 0 ? 4 : 5);
+            }
+            size_t last = str.find_last_not_of('.');
+            str.resize(last == std::string::npos ? 0 : last + 1);
+            return str;
+        }
+
+        constexpr bool operator==(name other) const { return value == other.value; }
+        constexpr bool operator!=(name other) const { return value != other.value; }
+        constexpr bool operator<(name other) const { return value < other.value; }
+
+    private:
+
+        static constexpr uint8_t char_to_value(char c) {
+            if (c == '.') return 0;
+            if (c >= '1' && c <= '5') return (c - '1') + 1;
+            if (c >= 'a' && c <= 'z') return (c - 'a') + 6;
+            throw decode_error("character is not in allowed character set for names");
+        }
+    };
+
+    struct symbol {
+        uint64_t value = 0; //precision in the low byte, code above it
+
+        uint8_t precision() const { return uint8_t(value & 0xff); }
+
+        std::string code() const {
+            std::string str;
+            for (uint64_t v = value >> 8; v > 0; v >>= 8) {
+                str += char(v & 0xff);
+            }
+            return str;
+        }
+
+        bool operator==(symbol other) const { return value == other.value; }
+        bool operator!=(symbol other) const { return value != other.value; }
+    };
+
+    struct asset {
+        int64_t amount = 0;
+        symbol sym;
+    };
+
+    struct time_point_sec {
+        uint32_t utc_seconds = 0;
+    };
+
+    //tag for eosio::unsigned_int, decodes to uint32_t
+    struct varuint32 {};
+
+    //======================== reader ========================
+
+    class reader {
+
+    public:
+
+        reader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+        explicit reader(std::string_view data) : reader(data.data(), data.size()) {}
+
+        template<typename T>
+        T read_fixed() {
+            require(sizeof(T));
+            T v;
+            memcpy(&v, pos, sizeof(T));
+            pos += sizeof(T);
+            return v;
+        }
+
+        uint32_t read_varuint32() {
+            uint64_t v = 0;
+            uint8_t b = 0;
+            uint8_t by = 0;
+            do {
+                require(1);
+                b = uint8_t(*pos++);
+                v |= uint64_t(b & 0x7f) << by;
+                by += 7;
+            } while ((b & 0x80) && by < 32);
+            if (b & 0x80) {
+                throw decode_error("varuint32 is too long");
+            }
+            return uint32_t(v);
+        }
+
+        std::string_view read_string() {
+            uint32_t size = read_varuint32();
+            require(size);
+            std::string_view str(pos, size);
+            pos += size;
+            return str;
+        }
+
+        void skip(size_t size) {
+            require(size);
+            pos += size;
+        }
+
+        const char* position() const { return pos; }
+
+        size_t remaining() const { return size_t(end - pos); }
+
+        bool empty() const { return pos == end; }
+
+    private:
+
+        void require(size_t size) const {
+            if (size_t(end - pos) < size) {
+                throw decode_error("row data ends early");
+            }
+        }
+
+        const char* pos;
+        const char* end;
+    };
+
+    //======================== fields ========================
+
+    //read and skip one serialized value, fixed_size is 0 for variable length values
+    template<typename T>
+    struct field {
+        static_assert(std::is_arithmetic_v<T>, "no decoder for this field type");
+        using type = T;
+        static constexpr size_t fixed_size = sizeof(T);
+        static type read(reader& r) { return r.read_fixed<T>(); }
+        static void skip(reader& r) { r.skip(sizeof(T)); }
+    };
+
+    template<>
+    struct field<bool> {
+        using type = bool;
+        static constexpr size_t fixed_size = 1;
+        static type read(reader& r) { return r.read_fixed<uint8_t>() != 0; }
+        static void skip(reader& r) { r.skip(1); }
+    };
+
+    template<>
+    struct field<name> {
+        using type = name;
+        static constexpr size_t fixed_size = 8;
+        static type read(reader& r) { return name(r.read_fixed<uint64_t>()); }
+        static void skip(reader& r) { r.skip(8); }
+    };
+
+    template<>
+    struct field<symbol> {
+        using type = symbol;
+        static constexpr size_t fixed_size = 8;
+        static type read(reader& r) { return symbol{r.read_fixed<uint64_t>()}; }
+        static void skip(reader& r) { r.skip(8); }
+    };
+
+    template<>
+    struct field<asset> {
+        using type = asset;
+        static constexpr size_t fixed_size = 16;
+        static type read(reader& r) {
+            int64_t amount = r.read_fixed<int64_t>();
+            return asset{amount, symbol{r.read_fixed<uint64_t>()}};
+        }
+        static void skip(reader& r) { r.skip(16); }
+    };
+
+    template<>
+    struct field<time_point_sec> {
+        using type = time_point_sec;
+        static constexpr size_t fixed_size = 4;
+        static type read(reader& r) { return time_point_sec{r.read_fixed<uint32_t>()}; }
+        static void skip(reader& r) { r.skip(4); }
+    };
+
+    template<>
+    struct field<std::string_view> {
+        using type = std::string_view;
+        static constexpr size_t fixed_size = 0;
+        static type read(reader& r) { return r.read_string(); }
+        static void skip(reader& r) { r.skip(r.read_varuint32()); }
+    };
+
+    template<>
+    struct field<varuint32> {
+        using type = uint32_t;
+        static constexpr size_t fixed_size = 0;
+        static type read(reader& r) { return r.read_varuint32(); }
+        static void skip(reader& r) { r.read_varuint32(); }
+    };
+
+    //======================== maps ========================
+
+    //serialized std::map<K, V>, entries are decoded while iterating
+    template<typename K, typename V>
+    class map_view {
+
+    public:
+
+        using key_type = typename field<K>::type;
+        using mapped_type = typename field<V>::type;
+        using value_type = std::pair<key_type, mapped_type>;
+
+        class iterator {
+
+        public:
+
+            const value_type& operator*() const { return current; }
+
+            const value_type* operator->() const { return &current; }
+
+            iterator& operator++() {
+                left -= 1;
+                load();
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const { return left == other.left; }
+
+            bool operator!=(const iterator& other) const { return left != other.left; }
+
+        private:
+
+            friend class map_view;
+
+            iterator(reader entries, uint32_t count) : r(entries), left(count) {
+                load();
+            }
+
+            void load() {
+                if (left > 0) {
+                    current.first = field<K>::read(r);
+                    current.second = field<V>::read(r);
+                }
+            }
+
+            reader r;
+            uint32_t left;
+            value_type current;
+        };
+
+        map_view() : entries(nullptr, 0) {}
+
+        //reads the entry count and steps over the entries
+        static map_view read(reader& r) {
+            map_view view;
+            view.count = r.read_varuint32();
+            const char* start = r.position();
+            if constexpr (field<K>::fixed_size > 0 && field<V>::fixed_size > 0) {
+                r.skip(size_t(view.count) * (field<K>::fixed_size + field<V>::fixed_size));
+            } else {
+                for (uint32_t i = 0; i < view.count; ++i) {
+                    field<K>::skip(r);
+                    field<V>::skip(r);
+                }
+            }
+            view.entries = reader(start, size_t(r.position() - start));
+            return view;
+        }
+
+        uint32_t size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        iterator begin() const { return iterator(entries, count); }
+
+        iterator end() const { return iterator(reader(nullptr, 0), 0); }
+
+        //linear walk, stops early since entries are sorted by key
+        std::optional<mapped_type> find(const key_type& key) const {
+            for (auto& entry : *this) {
+                if (entry.first == key) {
+                    return entry.second;
+                }
+                if (key < entry.first) {
+                    break;
+                }
+            }
+            return std::nullopt;
+        }
+
+    private:
+
+        reader entries;
+        uint32_t count = 0;
+    };
+
+    //======================== rows ========================
+
+    inline void require_consumed(const reader& r) {
+        if (!r.empty()) {
+            throw decode_error("unexpected data after row");
+        }
+    }
+
+    //scope: contract
+    struct schema_row {
+        name schema_name;
+        name issuer;
+
+        uint64_t supply;
+        uint64_t issued_supply;
+        uint64_t max_supply;
+
+        name license_model;
+        uint32_t min_license_length;
+        uint32_t max_license_length;
+
+        map_view<name, bool> settings;
+        map_view<name, uint32_t> default_stats;
+        symbol exp_symbol;
+
+        static schema_row decode(std::string_view data) {
+            reader r(data);
+            schema_row row;
+            row.schema_name = field<name>::read(r);
+            row.issuer = field<name>::read(r);
+            row.supply = field<uint64_t>::read(r);
+            row.issued_supply = field<uint64_t>::read(r);
+            row.max_supply = field<uint64_t>::read(r);
+            row.license_model = field<name>::read(r);
+            row.min_license_length = field<uint32_t>::read(r);
+            row.max_license_length = field<uint32_t>::read(r);
+            row.settings = map_view<name, bool>::read(r);
+            row.default_stats = map_view<name, uint32_t>::read(r);
+            row.exp_symbol = field<symbol>::read(r);
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: schema_name
+    struct license_row {
+        name owner;
+        time_point_sec expiration;
+        std::string_view checksum_algo;
+        map_view<name, std::string_view> full_uris;
+        map_view<name, std::string_view> base_uris;
+        std::string_view ati_hash; //32 raw sha256 bytes of the compiled ati, empty if not pinned
+
+        static license_row decode(std::string_view data) {
+            reader r(data);
+            license_row row;
+            row.owner = field<name>::read(r);
+            row.expiration = field<time_point_sec>::read(r);
+            row.checksum_algo = field<std::string_view>::read(r);
+            row.full_uris = map_view<name, std::string_view>::read(r);
+            row.base_uris = map_view<name, std::string_view>::read(r);
+            if (!r.empty()) {
+                const char* hash = r.position();
+                r.skip(32);
+                row.ati_hash = std::string_view(hash, 32);
+            }
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: schema_name
+    //v0 rows keep stats in stats, v1 rows leave it empty and append packed_stats
+    struct nonfungible_row {
+        uint64_t serial;
+        name owner;
+
+        uint16_t level;
+        asset experience;
+        asset next_level;
+        uint8_t unspent;
+        map_view<name, uint32_t> stats;
+
+        map_view<name, std::string_view> relative_uris;
+        map_view<name, std::string_view> checksums;
+
+        std::optional<map_view<name, varuint32>> packed_stats;
+
+        uint8_t row_version() const { return packed_stats ? 1 : 0; }
+
+        //stat value of either layout
+        std::optional<uint32_t> stat(name stat_name) const {
+            if (packed_stats) {
+                if (auto v = packed_stats->find(stat_name)) {
+                    return v;
+                }
+            }
+            return stats.find(stat_name);
+        }
+
+        //calls f(name, uint32_t) for every stat of either layout
+        template<typename F>
+        void for_each_stat(F&& f) const {
+            for (auto& s : stats) {
+                f(s.first, s.second);
+            }
+            if (packed_stats) {
+                for (auto& s : *packed_stats) {
+                    f(s.first, s.second);
+                }
+            }
+        }
+
+        static nonfungible_row decode(std::string_view data) {
+            reader r(data);
+            nonfungible_row row;
+            row.serial = field<uint64_t>::read(r);
+            row.owner = field<name>::read(r);
+            row.level = field<uint16_t>::read(r);
+            row.experience = field<asset>::read(r);
+            row.next_level = field<asset>::read(r);
+            row.unspent = field<uint8_t>::read(r);
+            row.stats = map_view<name, uint32_t>::read(r);
+            row.relative_uris = map_view<name, std::string_view>::read(r);
+            row.checksums = map_view<name, std::string_view>::read(r);
+            if (!r.empty()) {
+                row.packed_stats = map_view<name, varuint32>::read(r);
+            }
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: contract
+    struct currency_row {
+        name issuer;
+        bool retirable;
+        bool transferable;
+        bool consumable;
+        asset supply;
+        asset max_supply;
+
+        static currency_row decode(std::string_view data) {
+            reader r(data);
+            currency_row row;
+            row.issuer = field<name>::read(r);
+            row.retirable = field<bool>::read(r);
+            row.transferable = field<bool>::read(r);
+            row.consumable = field<bool>::read(r);
+            row.supply = field<asset>::read(r);
+            row.max_supply = field<asset>::read(r);
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: owner
+    struct account_row {
+        asset balance;
+
+        static account_row decode(std::string_view data) {
+            reader r(data);
+            account_row row;
+            row.balance = field<asset>::read(r);
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: owner
+    struct holding_row {
+        name schema_name;
+        uint64_t count;
+
+        static holding_row decode(std::string_view data) {
+            reader r(data);
+            holding_row row;
+            row.schema_name = field<name>::read(r);
+            row.count = field<uint64_t>::read(r);
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    struct cleanup_row {
+        name owner;
+        name kind;
+        uint64_t first_serial;
+        uint64_t last_serial;
+        uint64_t cursor;
+        uint64_t removed;
+
+        static cleanup_row decode(std::string_view data) {
+            reader r(data);
+            cleanup_row row;
+            row.owner = field<name>::read(r);
+            row.kind = field<name>::read(r);
+            row.first_serial = field<uint64_t>::read(r);
+            row.last_serial = field<uint64_t>::read(r);
+            row.cursor = field<uint64_t>::read(r);
+            row.removed = field<uint64_t>::read(r);
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //scope: schema_name
+    struct uri_prefixes_row {
+        name owner;
+        uint32_t count = 0;
+        reader entries = reader(nullptr, 0);
+
+        //prefix at an index, walks the prefixes before it
+        std::optional<std::string_view> prefix(uint32_t index) const {
+            if (index >= count) {
+                return std::nullopt;
+            }
+            reader r = entries;
+            for (uint32_t i = 0; i < index; ++i) {
+                field<std::string_view>::skip(r);
+            }
+            return field<std::string_view>::read(r);
+        }
+
+        static uri_prefixes_row decode(std::string_view data) {
+            reader r(data);
+            uri_prefixes_row row;
+            row.owner = field<name>::read(r);
+            row.count = r.read_varuint32();
+            const char* start = r.position();
+            for (uint32_t i = 0; i < row.count; ++i) {
+                field<std::string_view>::skip(r);
+            }
+            row.entries = reader(start, size_t(r.position() - start));
+            require_consumed(r);
+            return row;
+        }
+    };
+
+    //======================== uris ========================
+
+    //a license or relative uri as stored: the whole uri, or a prefix index of the license owner's uri prefixes and the rest
+    struct stored_uri {
+        std::optional<uint8_t> prefix_index;
+        std::string_view rest;
+
+        //a compressed uri starts with the prefix index in decimal between braces, "{3}dragon.json"
+        static stored_uri parse(std::string_view stored) {
+            uint32_t index = 0;
+            for (size_t i = 1; i < stored.size() && i <= 4 && stored[0] == '{'; ++i) {
+                if (stored[i] == '}') {
+                    if (i == 1 || index > 0xff) {
+                        break;
+                    }
+                    return stored_uri{uint8_t(index), stored.substr(i + 1)};
+                }
+                if (stored[i] < '0' || stored[i] > '9') {
+                    break;
+                }
+                index = index * 10 + uint32_t(stored[i] - '0');
+            }
+            return stored_uri{std::nullopt, stored};
+        }
+    };
+
+    //full uri of a stored uri, prefixes may be null if the license owner has none
+    inline std::string expand_uri(std::string_view stored, const uri_prefixes_row* prefixes) {
+        auto uri = stored_uri::parse(stored);
+        if (!uri.prefix_index) {
+            return std::string(uri.rest);
+        }
+        auto prefix = prefixes ? prefixes->prefix(*uri.prefix_index) : std::nullopt;
+        if (!prefix) {
+            throw decode_error("uri prefix not found");
+        }
+        std::string out;
+        out.reserve(prefix->size() + uri.rest.size());
+        out.append(*prefix).append(uri.rest);
+        return out;
+    }
+
+    //======================== responses ========================
+
+    //decodes the hex string of a get_table_rows row into out, which needs hex.size() / 2 bytes, returns the row
+    inline std::string_view from_hex(std::string_view hex, char* out) {
+        auto nibble = [](char c) -> uint8_t {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            throw decode_error("invalid hex character");
+        };
+        if (hex.size() % 2) {
+            throw decode_error("hex row has an odd length");
+        }
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            out[i / 2] = char((nibble(hex[i]) << 4) | nibble(hex[i + 1]));
+        }
+        return std::string_view(out, hex.size() / 2);
+    }
+
+}
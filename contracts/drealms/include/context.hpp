@@ -0,0 +1,126 @@
+// Table handles shared by everything one action runs.
+//
+// Each (table, scope) is opened once per action, on first use, so a row
+// read by the action or any of its helpers is decoded once and served from
+// the multi_index object cache after that. Rows changed with update() are
+// changed in their cached object and written by flush() once, however many
+// times the action changed them. Pending writes keep a pointer to the
+// cached object, so flush() writes it without looking the row up again;
+// rows are erased through erase(), which drops their pending write first.
+// The contract flushes as the last step of
+// each action body rather than in its destructor, so a failed write aborts
+// the action like any other check; anything that must see a written row
+// earlier, like a payer change, uses the table's own modify. Like modify,
+// update() changes the cached object before the row is written. If the
+// action aborts, the cache goes away with the action and the chain rolls
+// back its writes, so nothing reads the unwritten change.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+
+namespace drealms_context {
+
+    template<typename... Tables>
+    class action_tables {
+
+    public:
+
+        explicit action_tables(eosio::name code) : code(code) {}
+
+        action_tables(const action_tables&) = delete;
+
+        //opens a table scope on first use
+        template<typename Table>
+        Table& open(uint64_t scope) {
+            auto& table = std::get<opened<Table>>(tables)[scope];
+            if (!table) {
+                table = std::make_unique<Table>(code, scope);
+            }
+            return *table;
+        }
+
+        //changes a row, or the row an iterator points to, in its cached object, the row is written by the next flush
+        template<typename Table, typename Row, typename Lambda>
+        void update(Table& table, const Row& row, Lambda&& updater) {
+            if constexpr (std::is_same_v<Row, typename Table::const_iterator>) {
+                eosio::check(row != table.end(), "cannot pass end iterator to update");
+                update(table, *row, std::forward<Lambda>(updater));
+            } else {
+                uint64_t pk = row.primary_key();
+                updater(const_cast<Row&>(row));
+                eosio::check(pk == row.primary_key(), "updater cannot change primary key when modifying an object");
+
+                for (auto& w : writes) {
+                    if (w.table == &table && w.primary_key == pk) {
+                        return;
+                    }
+                }
+                writes.push_back(pending_write{&table, &row, pk, &write_row<Table, Row>});
+            }
+        }
+
+        //erases a row, or the row an iterator points to, dropping its pending write
+        template<typename Table, typename Row>
+        auto erase(Table& table, const Row& row) {
+            if constexpr (std::is_same_v<Row, typename Table::const_iterator>) {
+                eosio::check(row != table.end(), "cannot pass end iterator to erase");
+                forget(&table, row->primary_key());
+                return table.erase(row);
+            } else {
+                forget(&table, row.primary_key());
+                table.erase(row);
+            }
+        }
+
+        //writes every updated row once, in the order they were first updated
+        void flush() {
+            auto pending = std::move(writes);
+            writes.clear();
+            for (auto& w : pending) {
+                w.write(w.table, w.row);
+            }
+        }
+
+    private:
+
+        template<typename Table>
+        using opened = std::map<uint64_t, std::unique_ptr<Table>>;
+
+        struct pending_write {
+            void* table;
+            const void* row; //cached object, stays put until the row is erased
+            uint64_t primary_key;
+            void (*write)(void* table, const void* row);
+        };
+
+        //serializes the cached row
+        template<typename Table, typename Row>
+        static void write_row(void* table, const void* row) {
+            static_cast<Table*>(table)->modify(*static_cast<const Row*>(row), eosio::same_payer, [](auto&) {});
+        }
+
+        void forget(const void* table, uint64_t primary_key) {
+            for (auto w = writes.begin(); w != writes.end(); ++w) {
+                if (w->table == table && w->primary_key == primary_key) {
+                    writes.erase(w);
+                    return;
+                }
+            }
+        }
+
+        eosio::name code;
+        std::tuple<opened<Tables>...> tables;
+        std::vector<pending_write> writes; //few rows per action, searched in order
+    };
+
+}
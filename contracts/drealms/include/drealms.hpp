@@ -13,6 +13,15 @@
 #include <eosio/transaction.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/ignore.hpp>
+#include <eosio/binary_extension.hpp>
+#include <eosio/crypto.hpp>
+
+#include <memory>
+#include <set>
+#include <variant>
+
+#include "profile.hpp"
+#include "context.hpp"
 
 // #include <map>
 
@@ -21,7 +30,6 @@ using namespace eosio;
 
 //TODO: update fungibles and nonfungibles vectors when creating new schema or fts
 //TODO: design next_level formulae
-//TODO: refactor table opens
 //TODO: remove next_level from nft, instead set level-up formula in schema and calculate next_level from current level
 
 //TODO?: rename issuenft() to mintnft()
@@ -41,6 +49,17 @@ public:
     //sets realmdata singleton
     ACTION setrealmdata(string drealms_version, name realm_name);
 
+    //sets who the realm notifies: every party (all) or only subscribed accounts (subscribed)
+    ACTION setnotify(name notify_mode);
+
+    //======================== notification actions ========================
+
+    //subscribes an account to notifications of the listed schemas and currencies, or to all if both are empty
+    ACTION subscribe(name account, vector<name> schemas, vector<symbol_code> currencies);
+
+    //removes an account's subscription
+    ACTION unsubscribe(name account);
+
     //======================== schema actions ========================
 
     //creates a new nft schema, initially sets licensing to disabled
@@ -79,7 +98,7 @@ public:
     ACTION setalgo(name schema_name, name license_owner, string new_checksum_algo);
 
     //updates a license's ATI
-    ACTION setati(name schema_name, name license_owner, string new_ati_uri);
+    ACTION setati(name schema_name, name license_owner, string new_ati_uri, binary_extension<checksum256> ati_hash);
 
     //updates a uri if found, inserts if not found
     ACTION newuri(name schema_name, name license_owner, name uri_group, name uri_name, string new_uri, optional<uint64_t> serial);
@@ -98,24 +117,119 @@ public:
     //transfers nft(s) of a single token name to recipient account, if transferable
     ACTION transfernft(name from, name to, name schema_name, vector<uint64_t> serials, string memo);
 
+    //trades nft(s) from seller to buyer for a fungible price from buyer to seller, atomically
+    ACTION swapnft(name seller, name buyer, name schema_name, vector<uint64_t> serials, asset price, string memo);
+
     //consumes an nft, if consumable
     ACTION consumenft(name schema_name, uint64_t serial, string memo);
 
+    //progress of a bounded retirerange or consumerange call
+    struct cleanupview {
+        uint64_t removed; //nfts removed by this call
+        uint64_t total_removed; //nfts removed since the cleanup started
+        uint64_t next_serial; //serial the next call resumes from, 0 once complete
+        bool complete;
+
+        EOSLIB_SERIALIZE(cleanupview, (removed)(total_removed)(next_serial)(complete))
+    };
+
+    //retires the issuer's nfts in a serial range, visiting up to max_rows nfts from the saved cursor
+    [[eosio::action]] cleanupview retirerange(name schema_name, uint64_t first_serial, uint64_t last_serial, uint32_t max_rows, string memo);
+
+    //consumes the owner's nfts in a serial range, visiting up to max_rows nfts from the saved cursor
+    [[eosio::action]] cleanupview consumerange(name owner, name schema_name, uint64_t first_serial, uint64_t last_serial, uint32_t max_rows, string memo);
+
     //activate and nft, if activatable
     ACTION activatenft(name schema_name, uint64_t serial, string memo);
 
     //updates a checksum if found, inserts if not found
     ACTION newchecksum(name schema_name, name license_owner, uint64_t serial, string new_checksum);
 
-    //logs an nfts data
-    ACTION lognft(name to, name schema_name, uint64_t serial);
-
     //spends earned experience to level up
     ACTION levelup(name schema_name, uint64_t serial);
 
     //spends an available point on a stat to upgrade it
     ACTION spendpoint(name schema_name, uint64_t serial, name stat_name);
 
+    //nft as seen through one license, returned by viewnfts
+    struct nftview {
+        uint64_t serial;
+        name owner;
+        uint16_t level;
+        asset experience;
+        asset next_level;
+        uint8_t unspent;
+        map<name, uint32_t> stats; //includes schema defaults for stats added after minting
+        map<name, string> uris; //license full uris, and license base uris joined with the nft's relative uri
+        string checksum; //set by the license owner, empty if none
+
+        EOSLIB_SERIALIZE(nftview, (serial)(owner)(level)(experience)(next_level)(unspent)(stats)(uris)(checksum))
+    };
+
+    //returns the resolved view of each serial for a license, in request order
+    [[eosio::action, eosio::read_only]] vector<nftview> viewnfts(name schema_name, name license_owner, vector<uint64_t> serials);
+
+    //returns how many nfts of a schema an account holds
+    [[eosio::action, eosio::read_only]] uint64_t countnfts(name owner, name schema_name);
+
+    //======================== crafting actions ========================
+
+    //adds or replaces a recipe crafting an nft of the schema
+    ACTION newrecipe(name schema_name, name recipe_name, map<name, uint64_t> inputs, vector<asset> materials,
+        map<name, uint32_t> stats);
+
+    //erases a recipe
+    ACTION eraserecipe(name schema_name, name recipe_name);
+
+    //consumes the recipe's inputs and materials from crafter and mints the crafted nft to crafter
+    ACTION craft(name crafter, name schema_name, name recipe_name, map<name, vector<uint64_t>> inputs, string memo);
+
+    //======================== batch actions ========================
+
+    //batch operations, each takes the arguments of the action of the same name
+    struct newuri_op {
+        name schema_name;
+        name license_owner;
+        name uri_group;
+        name uri_name;
+        string new_uri;
+        optional<uint64_t> serial;
+
+        EOSLIB_SERIALIZE(newuri_op, (schema_name)(license_owner)(uri_group)(uri_name)(new_uri)(serial))
+    };
+
+    struct newchecksum_op {
+        name schema_name;
+        name license_owner;
+        uint64_t serial;
+        string new_checksum;
+
+        EOSLIB_SERIALIZE(newchecksum_op, (schema_name)(license_owner)(serial)(new_checksum))
+    };
+
+    struct transfernft_op {
+        name from;
+        name to;
+        name schema_name;
+        vector<uint64_t> serials;
+        string memo;
+
+        EOSLIB_SERIALIZE(transfernft_op, (from)(to)(schema_name)(serials)(memo))
+    };
+
+    struct spendpoint_op {
+        name schema_name;
+        uint64_t serial;
+        name stat_name;
+
+        EOSLIB_SERIALIZE(spendpoint_op, (schema_name)(serial)(stat_name))
+    };
+
+    typedef std::variant<newuri_op, newchecksum_op, transfernft_op, spendpoint_op> batch_op;
+
+    //runs operations in order on shared table handles, all or nothing
+    ACTION batch(vector<batch_op> ops);
+
     //======================== fungible actions ========================
 
     //creates a fungible token
@@ -146,30 +260,96 @@ public:
     // [[eosio::on_notify("eosio.token::transfer")]]
     // void deposit(name from, name to, asset quantity, string memo);
 
+    //======================== migration actions ========================
+
+    //converts up to max_rows rows of a table scope to the current row layout, resuming from the saved cursor
+    ACTION migrate(name table_name, name scope, uint32_t max_rows);
+
+    //======================== event log ========================
+
+    //compact nft event, batched into a single logevents action per dispatch
+    struct nftevent {
+        name event_name; //mint, transfer, retire, consume, level, award
+        name schema_name;
+        uint64_t serial;
+        name from;
+        name to;
+        int64_t value; //new level, experience awarded, etc
+
+        EOSLIB_SERIALIZE(nftevent, (event_name)(schema_name)(serial)(from)(to)(value))
+    };
+
+    //logs all events collected during an action
+    ACTION logevents(vector<nftevent> events);
+
     //========== helper functions ==========
 
     bool validate_license_model(name license_model);
 
+    bool get_setting(name setting_name, const map<name, bool>& settings);
+
+    void log_event(name event_name, name schema_name, uint64_t serial, name from, name to, int64_t value);
+
     bool validate_uri_group(name uri_group);
 
     void add_balance(name to, asset quantity, name ram_payer);
 
+    void move_nfts(name from, name to, name schema_name, const vector<uint64_t>& serials, name ram_payer);
+
+    void add_holding(name owner, name schema_name, uint64_t count, name ram_payer);
+
+    void sub_holding(name owner, name schema_name, uint64_t count);
+
+    uint64_t holdings_bound(name schema_name, const map<name, bool>& settings);
+
+    uint32_t count_holdings(name schema_name, name ram_payer, uint64_t cursor, uint32_t max_rows, uint64_t& next_cursor);
+
     void sub_balance(name from, asset quantity);
 
+    uint32_t migrate_nfts(name schema_name, uint64_t cursor, uint32_t max_rows, uint64_t& next_cursor);
+
+    void notify(name account, name schema_name, symbol_code currency);
+
+    void require_auth_once(name account);
+
+    //writes the rows updated by the action and sends its events, the last statement of every action that may write
+    void finish_action();
+
+    //stores a uri as a prefix of the license owner's dictionary and the rest, if it has a long enough prefix
+    string compress_uri(name schema_name, name owner, const string& uri, bool add_prefix);
+
+    //full uri of a stored uri, compressed or not
+    string expand_uri(name schema_name, name owner, const string& stored);
+
+    //events collected during the current action, sent by finish_action
+    vector<nftevent> pending_events;
+
+    //notify mode of the realm, read on the first notification of the current action
+    name realm_notify_mode;
+
+    //accounts whose authorization the current action already required
+    set<name> authorized_accounts;
+
     //======================== tables ========================
 
+    //ram figures are billed bytes of a representative row, including row overhead (see bench/ramcalc.cpp)
+
     //scope: singleton
-    //ram: ~40 bytes
+    //ram: 133 bytes (empty lists)
     TABLE realmdata {
         string drealms_version;
         name realm_name;
         vector<name> nonfungibles; //TODO?: rename to schemas
         vector<symbol> fungibles; //TODO?: rename to currencies
+
+        binary_extension<name> notify_mode; //all or subscribed, all if not set
+
+        EOSLIB_SERIALIZE(realmdata, (drealms_version)(realm_name)(nonfungibles)(fungibles)(notify_mode))
     };
     typedef singleton<name("realmdata"), realmdata> realmdata_singleton;
 
     //scope: get_self().value
-    //ram: ~507 bytes
+    //ram: 300 bytes (6 stats)
     TABLE schema {
         name schema_name;
         name issuer;
@@ -182,7 +362,7 @@ public:
         uint32_t min_license_length;
         uint32_t max_license_length;
 
-        map<name, bool> settings; //retirable, transferable, consumable, activatable
+        map<name, bool> settings; //retirable, transferable, consumable, activatable, logevents, holdings
         map<name, uint32_t> default_stats; //defaults used when minting a new nft
         symbol exp_symbol;
 
@@ -193,24 +373,28 @@ public:
             (license_model)(min_license_length)(max_license_length)
             (settings)(default_stats)(exp_symbol))
     };
-    typedef multi_index<name("schemas"), schema> schemas_table;
+    typedef drealms_profile::profiled<multi_index<name("schemas"), schema>> schemas_table;
 
     //scope: schema_name.value
-    //ram: ~303 bytes
+    //ram: 275 bytes (one 48 character full and base uri, ati hash)
     TABLE license {
         name owner;
         time_point_sec expiration;
         string checksum_algo;
         map<name, string> full_uris;
         map<name, string> base_uris;
+
+        binary_extension<checksum256> ati_hash; //sha256 of the compiled ati document at full_uris["ati"], if pinned
         
         uint64_t primary_key() const { return owner.value; }
-        EOSLIB_SERIALIZE(license, (owner)(expiration)(checksum_algo)(full_uris)(base_uris))
+        EOSLIB_SERIALIZE(license, (owner)(expiration)(checksum_algo)(full_uris)(base_uris)(ati_hash))
     };
-    typedef multi_index<name("licenses"), license> licenses_table;
+    typedef drealms_profile::profiled<multi_index<name("licenses"), license>> licenses_table;
 
     //scope: schema_name.value
-    //ram: ~198 bytes
+    //ram: 328 bytes (v0), 311 bytes (v1) (6 stats, one relative uri and sha256 checksum)
+    //layout: v0 rows store stats as map<name, uint32_t>, v1 rows leave stats empty and append packed_stats
+    //the version is the number of trailing extensions present, a v2 layout appends another after packed_stats
     TABLE nonfungible {
         uint64_t serial;
         name owner;
@@ -224,16 +408,47 @@ public:
         map<name, string> relative_uris;
         map<name, string> checksums;
 
+        binary_extension<map<name, unsigned_int>> packed_stats; //v1 stats, decoded into stats on read
+
+        static constexpr uint8_t current_version = 1;
+
         uint64_t primary_key() const { return serial; }
-        EOSLIB_SERIALIZE(nonfungible, 
-            (serial)(owner)
-            (level)(experience)(next_level)(unspent)(stats)
-            (relative_uris)(checksums))
+        uint8_t row_version() const { return packed_stats.has_value() ? 1 : 0; }
+
+        //reads v0 and v1 rows, always writes the current layout
+        template<typename DataStream>
+        friend DataStream& operator<<(DataStream& ds, const nonfungible& t) {
+            map<name, unsigned_int> new_packed_stats;
+            for (auto& s : t.stats) {
+                new_packed_stats[s.first] = s.second;
+            }
+
+            return ds << t.serial << t.owner
+                << t.level << t.experience << t.next_level << t.unspent << map<name, uint32_t>()
+                << t.relative_uris << t.checksums
+                << new_packed_stats;
+        }
+
+        template<typename DataStream>
+        friend DataStream& operator>>(DataStream& ds, nonfungible& t) {
+            ds >> t.serial >> t.owner
+                >> t.level >> t.experience >> t.next_level >> t.unspent >> t.stats
+                >> t.relative_uris >> t.checksums
+                >> t.packed_stats;
+
+            if (t.packed_stats.has_value()) {
+                for (auto& s : t.packed_stats.value()) {
+                    t.stats[s.first] = s.second;
+                }
+            }
+
+            return ds;
+        }
     };
-    typedef multi_index<name("nfts"), nonfungible> nfts_table;
+    typedef drealms_profile::profiled<multi_index<name("nfts"), nonfungible>> nfts_table;
 
     //scope: get_self().value
-    //ram: ~354 bytes
+    //ram: 151 bytes
     TABLE currency {
         name issuer;
         bool retirable;
@@ -245,16 +460,152 @@ public:
         uint64_t primary_key() const { return supply.symbol.code().raw(); }
         EOSLIB_SERIALIZE(currency, (issuer)(retirable)(transferable)(consumable)(supply)(max_supply))
     };
-    typedef multi_index<name("currencies"), currency> currencies_table;
+    typedef drealms_profile::profiled<multi_index<name("currencies"), currency>> currencies_table;
 
     //scope: owner.value
-    //ram: ~144 bytes
+    //ram: 124 bytes
     TABLE account {
         asset balance;
         
         uint64_t primary_key() const { return balance.symbol.code().raw(); }
         EOSLIB_SERIALIZE(account, (balance))
     };
-    typedef multi_index<name("accounts"), account> accounts_table;
+    typedef drealms_profile::profiled<multi_index<name("accounts"), account>> accounts_table;
+
+    //scope: owner.value
+    //ram: 124 bytes
+    TABLE holding {
+        name schema_name;
+        uint64_t count; //nfts of the schema held by the scope owner
+
+        uint64_t primary_key() const { return schema_name.value; }
+        EOSLIB_SERIALIZE(holding, (schema_name)(count))
+    };
+    typedef drealms_profile::profiled<multi_index<name("holdings"), holding>> holdings_table;
+
+    //scope: schema_name.value (crafted schema)
+    //ram: 191 bytes (two input schemas, one material, two stats)
+    TABLE recipe {
+        name recipe_name;
+        map<name, uint64_t> inputs; //input schema => nfts consumed
+        vector<asset> materials; //fungible tokens consumed
+        map<name, uint32_t> stats; //stats of the crafted nft, replacing the schema defaults
+
+        uint64_t primary_key() const { return recipe_name.value; }
+        EOSLIB_SERIALIZE(recipe, (recipe_name)(inputs)(materials)(stats))
+    };
+    typedef drealms_profile::profiled<multi_index<name("recipes"), recipe>> recipes_table;
+
+    //scope: get_self().value
+    //ram: 126 bytes (one schema)
+    TABLE subscriber {
+        name account;
+        vector<name> schemas; //nft notifications wanted
+        vector<symbol_code> currencies; //fungible notifications wanted
+
+        uint64_t primary_key() const { return account.value; }
+        EOSLIB_SERIALIZE(subscriber, (account)(schemas)(currencies))
+    };
+    typedef drealms_profile::profiled<multi_index<name("subscribers"), subscriber>> subscribers_table;
+
+    //scope: schema_name.value
+    //ram: 156 bytes
+    TABLE cleanup {
+        name owner; //owner of the nfts removed
+        name kind; //retire or consume
+        uint64_t first_serial;
+        uint64_t last_serial;
+        uint64_t cursor; //serial of the next nft to visit
+        uint64_t removed; //nfts removed so far
+
+        uint64_t primary_key() const { return owner.value; }
+        EOSLIB_SERIALIZE(cleanup, (owner)(kind)(first_serial)(last_serial)(cursor)(removed))
+    };
+    typedef drealms_profile::profiled<multi_index<name("cleanups"), cleanup>> cleanups_table;
+
+    //scope: table_name.value
+    //ram: 134 bytes
+    TABLE migration {
+        name scope;
+        uint64_t cursor; //primary key of the next row to migrate
+        uint64_t migrated; //rows converted so far
+        bool complete;
+
+        binary_extension<uint8_t> target_version; //row version the cursor converts to, rows without it target v1
+
+        uint64_t primary_key() const { return scope.value; }
+        uint8_t target() const { return target_version.value_or(1); }
+        EOSLIB_SERIALIZE(migration, (scope)(cursor)(migrated)(complete)(target_version))
+    };
+    typedef drealms_profile::profiled<multi_index<name("migrations"), migration>> migrations_table;
+
+    //scope: schema_name.value
+    //ram: 158 bytes (one 40 character prefix)
+    TABLE uriprefix {
+        name owner; //license owner
+        vector<string> prefixes; //never reordered or removed, compressed uris refer to them by index
+
+        //a compressed uri is the prefix index in decimal between braces, then the rest of the uri: "{3}dragon.json"
+        static constexpr char open = '{';
+        static constexpr char close = '}';
+        static constexpr size_t min_length = 16; //shorter prefixes are stored inline
+        static constexpr size_t max_prefixes = 255;
+
+        //length of the "{index}" a stored uri starts with, 0 if it is stored whole
+        static size_t reference(const string& stored, size_t& index) {
+            index = 0;
+            for (size_t i = 1; i < stored.size() && i <= 4 && stored[0] == open; ++i) {
+                if (stored[i] == close) {
+                    return i > 1 ? i + 1 : 0;
+                }
+                if (stored[i] < '0' || stored[i] > '9') {
+                    return 0;
+                }
+                index = index * 10 + size_t(stored[i] - '0');
+            }
+            return 0;
+        }
+
+        uint64_t primary_key() const { return owner.value; }
+        EOSLIB_SERIALIZE(uriprefix, (owner)(prefixes))
+    };
+    typedef drealms_profile::profiled<multi_index<name("uriprefixes"), uriprefix>> uriprefixes_table;
+
+    //========== table helpers ==========
+
+    //helpers below work on table handles the calling action already opened, so rows it read stay cached
+
+    //mints the next serial of a schema, returns the new serial
+    uint64_t mint_nft(schemas_table& schemas, const schema& sch, name to, const map<name, uint32_t>& stats, name ram_payer, bool log);
+
+    //erases an nft and removes it from the schema supply and its owner's holdings
+    void consume_nft(schemas_table& schemas, const schema& sch, nfts_table& nfts, const nonfungible& nft);
+
+    //removes a fungible quantity from a currency supply and the owner's balance
+    void consume_tokens(currencies_table& currencies, const currency& curr, name owner, asset quantity);
+
+    //removes owner's nfts in a serial range, visiting up to max_rows nfts from the saved cursor of the same cleanup
+    cleanupview remove_range(schemas_table& schemas, const schema& sch, name kind, name owner,
+        uint64_t first_serial, uint64_t last_serial, uint32_t max_rows);
+
+    //changes the owner of nfts and moves them between holdings
+    void move_nfts(const schema& sch, nfts_table& nfts, name from, name to, const vector<uint64_t>& serials, name ram_payer);
+
+    //sets a full or base uri of a license, or a relative uri of an nft
+    void set_uri(licenses_table& licenses, const license& lic, nfts_table& nfts, name uri_group, name uri_name,
+        const string& new_uri, optional<uint64_t> serial);
+
+    //spends one of an nft's unspent points on a stat
+    void spend_point(nfts_table& nfts, const nonfungible& nft, name stat_name);
+
+    //runs one batch operation
+    void run_op(const newuri_op& op);
+    void run_op(const newchecksum_op& op);
+    void run_op(const transfernft_op& op);
+    void run_op(const spendpoint_op& op);
+
+    //tables opened by the current action, updated rows are written by finish_action
+    drealms_context::action_tables<schemas_table, licenses_table, nfts_table, currencies_table, accounts_table,
+        holdings_table, recipes_table, subscribers_table, cleanups_table, migrations_table, uriprefixes_table> tables;
 
 };
\ No newline at end of file
@@ -0,0 +1,188 @@
+// Per-action instrumentation for profiling builds of dRealms.
+//
+// Building with -DDREALMS_PROFILE wraps every multi_index table of the
+// contract in profiled_table, which counts table opens, db lookups and
+// writes, and the bytes of every row read or written. The contract also
+// counts heap allocations and prints the totals to the debug console when
+// the action finishes. Without the flag profiled<T> is T and nothing here
+// is compiled into the contract.
+//
+// Byte counts are the packed size of rows stored by the table, and of
+// rows deserialized the first time the table loads them. Lookups served
+// from the multi_index object cache cost no db call and are counted as
+// cache_hits instead; seeks always reach the db but only count the bytes
+// of rows not loaded before.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <eosio/eosio.hpp>
+
+#include <set>
+
+namespace drealms_profile {
+
+#ifdef DREALMS_PROFILE
+
+    struct counters {
+        uint32_t table_opens = 0;
+        uint32_t finds = 0; //find, require_find, lower_bound, upper_bound
+        uint32_t gets = 0;
+        uint32_t cache_hits = 0; //find, require_find and get of a row already loaded
+        uint32_t emplaces = 0;
+        uint32_t modifies = 0;
+        uint32_t erases = 0;
+        uint64_t bytes_serialized = 0;
+        uint64_t bytes_deserialized = 0;
+        uint32_t allocations = 0;
+        uint64_t bytes_allocated = 0;
+        bool active = false; //allocations are only counted while the contract is alive
+    };
+
+    inline counters stats;
+
+    inline void begin() {
+        stats = counters();
+        stats.active = true;
+    }
+
+    inline void end() {
+        stats.active = false;
+        eosio::print("profile: table_opens=", stats.table_opens, " finds=", stats.finds, " gets=", stats.gets, " cache_hits=", stats.cache_hits,
+            " emplaces=", stats.emplaces, " modifies=", stats.modifies, " erases=", stats.erases,
+            " bytes_serialized=", stats.bytes_serialized, " bytes_deserialized=", stats.bytes_deserialized,
+            " allocations=", stats.allocations, " bytes_allocated=", stats.bytes_allocated, "\n");
+    }
+
+    inline void count_allocation(size_t size) {
+        if (stats.active) {
+            stats.allocations += 1;
+            stats.bytes_allocated += size;
+        }
+    }
+
+    //counting multi_index, same interface as the table it wraps
+    template<typename MultiIndex>
+    class profiled_table : public MultiIndex {
+
+    public:
+
+        using const_iterator = typename MultiIndex::const_iterator;
+
+        profiled_table(eosio::name code, uint64_t scope) : MultiIndex(code, scope) {
+            stats.table_opens += 1;
+        }
+
+        const_iterator find(uint64_t primary) const {
+            if (cached(primary)) {
+                return MultiIndex::find(primary);
+            }
+            stats.finds += 1;
+            return count_read(MultiIndex::find(primary));
+        }
+
+        const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const {
+            if (cached(primary)) {
+                return MultiIndex::require_find(primary, error_msg);
+            }
+            stats.finds += 1;
+            return count_read(MultiIndex::require_find(primary, error_msg));
+        }
+
+        const_iterator lower_bound(uint64_t primary) const {
+            stats.finds += 1;
+            return count_read(MultiIndex::lower_bound(primary));
+        }
+
+        const_iterator upper_bound(uint64_t primary) const {
+            stats.finds += 1;
+            return count_read(MultiIndex::upper_bound(primary));
+        }
+
+        const_iterator begin() const {
+            return lower_bound(std::numeric_limits<uint64_t>::lowest());
+        }
+
+        const auto& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+            if (cached(primary)) {
+                return MultiIndex::get(primary, error_msg);
+            }
+            stats.gets += 1;
+            const auto& obj = MultiIndex::get(primary, error_msg);
+            loaded.insert(primary);
+            stats.bytes_deserialized += eosio::pack_size(obj);
+            return obj;
+        }
+
+        template<typename Lambda>
+        const_iterator emplace(eosio::name payer, Lambda&& constructor) {
+            stats.emplaces += 1;
+            auto itr = MultiIndex::emplace(payer, std::forward<Lambda>(constructor));
+            loaded.insert(itr->primary_key());
+            stats.bytes_serialized += eosio::pack_size(*itr);
+            return itr;
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, eosio::name payer, Lambda&& updater) {
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template<typename Obj, typename Lambda>
+        void modify(const Obj& obj, eosio::name payer, Lambda&& updater) {
+            stats.modifies += 1;
+            MultiIndex::modify(obj, payer, std::forward<Lambda>(updater));
+            stats.bytes_serialized += eosio::pack_size(obj);
+        }
+
+        const_iterator erase(const_iterator itr) {
+            stats.erases += 1;
+            loaded.erase(itr->primary_key());
+            return MultiIndex::erase(itr);
+        }
+
+        template<typename Obj>
+        void erase(const Obj& obj) {
+            stats.erases += 1;
+            loaded.erase(obj.primary_key());
+            MultiIndex::erase(obj);
+        }
+
+    private:
+
+        //primary keys of rows in the multi_index object cache
+        mutable std::set<uint64_t> loaded;
+
+        bool cached(uint64_t primary) const {
+            if (loaded.count(primary)) {
+                stats.cache_hits += 1;
+                return true;
+            }
+            return false;
+        }
+
+        const_iterator count_read(const_iterator itr) const {
+            if (itr != MultiIndex::end() && loaded.insert(itr->primary_key()).second) {
+                stats.bytes_deserialized += eosio::pack_size(*itr);
+            }
+            return itr;
+        }
+
+    };
+
+    template<typename MultiIndex>
+    using profiled = profiled_table<MultiIndex>;
+
+#else
+
+    inline void begin() {}
+
+    inline void end() {}
+
+    template<typename MultiIndex>
+    using profiled = MultiIndex;
+
+#endif
+
+}
@@ -0,0 +1,363 @@
+// Incremental in-memory mirror of drealms contract state.
+//
+// Keeps every table of the contract on a native host chain and advances it
+// by executing the contract's own action handlers on recorded actions, so
+// the mirror applies exactly the writes the chain made. Row writes update
+// an owner index and a per schema holder index as they happen, and the
+// whole state can be checkpointed to disk and loaded back on restart, after
+// which only the actions past the checkpoint need to be applied.
+//
+// Traces are text, one successfully executed top level action per line:
+//
+//     <sequence> <block time, ms since epoch> <action> <actor@permission>[,<actor@permission>...] <hex action data>
+//
+// Inline actions and notifications are produced by the contract while
+// applying and must not appear in the trace. Needs the contract's native
+// build (see build.sh) and its apply handler.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+
+#include <eosio/eosio.hpp>
+
+#include "../client/rows.hpp"
+
+namespace drealms_mirror {
+
+    using namespace eosio;
+
+    namespace client = drealms_client;
+
+    struct trace_record {
+        uint64_t sequence = 0; //global action sequence, increasing
+        int64_t block_time_ms = 0;
+        host::action_data act;
+    };
+
+    //one trace line without the trailing newline
+    inline void write_trace(std::ostream& out, const trace_record& rec) {
+        static const char* digits = "0123456789abcdef";
+        out << rec.sequence << ' ' << rec.block_time_ms << ' ' << rec.act.name.to_string() << ' ';
+        for (size_t i = 0; i < rec.act.authorization.size(); ++i) {
+            auto& auth = rec.act.authorization[i];
+            out << (i ? "," : "") << auth.actor.to_string() << '@' << auth.permission.to_string();
+        }
+        out << ' ';
+        for (unsigned char c : rec.act.data) {
+            out << digits[c >> 4] << digits[c & 0x0f];
+        }
+    }
+
+    //reads the next trace line past skip_through, returns false at the end of the stream
+    inline bool read_trace(std::istream& in, name contract, trace_record& rec, uint64_t skip_through = 0) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            if (skip_through > 0 && strtoull(line.c_str(), nullptr, 10) <= skip_through) {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            std::string action_name, auths, hex;
+            fields >> rec.sequence >> rec.block_time_ms >> action_name >> auths >> hex;
+            check(!fields.fail(), "malformed trace line: " + line);
+
+            rec.act.account = contract;
+            rec.act.name = name(action_name);
+            rec.act.authorization.clear();
+            std::istringstream auth_list(auths);
+            std::string auth;
+            while (std::getline(auth_list, auth, ',')) {
+                auto at = auth.find('@');
+                rec.act.authorization.push_back(permission_level{
+                    name(auth.substr(0, at)), name(at == std::string::npos ? "active" : auth.substr(at + 1))});
+            }
+
+            rec.act.data.resize(hex.size() / 2);
+            client::from_hex(hex, rec.act.data.data());
+            return true;
+        }
+        return false;
+    }
+
+    //nft identity, serials are only unique within a schema
+    struct nft_key {
+        name schema_name;
+        uint64_t serial;
+
+        bool operator<(const nft_key& other) const {
+            return std::tie(schema_name.value, serial) < std::tie(other.schema_name.value, other.serial);
+        }
+
+        bool operator==(const nft_key& other) const {
+            return schema_name == other.schema_name && serial == other.serial;
+        }
+    };
+
+    class mirror {
+
+    public:
+
+        static constexpr uint32_t checkpoint_magic = 0x4d4c5244; //"DRLM"
+        static constexpr uint32_t checkpoint_version = 2;
+
+        mirror(name contract, host::apply_handler apply) : self(contract) {
+            state.set_contract(contract, apply);
+            state.any_account = true;
+            state.row_observer = [this](name code, uint64_t scope, name table_name, uint64_t, const host::row* old_row, const host::row* new_row) {
+                if (code == self && table_name == name("nfts")) {
+                    std::lock_guard<std::mutex> lock(index_mutex);
+                    index_nft(name(scope), old_row, new_row);
+                }
+            };
+        }
+
+        mirror(const mirror&) = delete;
+
+        //sequence of the last applied action, 0 if none
+        uint64_t position() const { return last_sequence; }
+
+        //seeds one row, e.g. from a binary get_table_rows response, for building the first snapshot
+        void load_row(name table_name, uint64_t scope, uint64_t primary_key, name payer, std::vector<char> data) {
+            host::row r{payer, std::move(data)};
+            state.set_row(self, scope, table_name, primary_key, &r);
+        }
+
+        //seeds who pays for a table scope once its rows are loaded, e.g. from a get_table_by_scope response,
+        //otherwise the payer of the first row loaded is billed
+        void load_scope_payer(name table_name, uint64_t scope, name payer) {
+            state.set_table_payer(self, scope, table_name, payer);
+        }
+
+        //applies a recorded action, skipping it if the mirror is already past it
+        bool apply(const trace_record& rec) {
+            if (rec.sequence != 0 && rec.sequence <= last_sequence) {
+                return false;
+            }
+            execute(rec);
+            last_sequence = rec.sequence;
+            return true;
+        }
+
+        //executes a recorded action without moving the position, callable from several threads
+        //as long as concurrent actions never depend on each other's writes (see replay/access.hpp)
+        void execute(const trace_record& rec) {
+            state.push_action(rec.act, time_point(microseconds(rec.block_time_ms * 1000)));
+        }
+
+        //marks every action up to sequence as applied, after executing them out of band
+        void advance_to(uint64_t sequence) {
+            last_sequence = std::max(last_sequence, sequence);
+        }
+
+        //applies every record of a trace stream, returns how many were applied
+        uint64_t apply_stream(std::istream& in) {
+            uint64_t applied = 0;
+            trace_record rec;
+            while (read_trace(in, self, rec, last_sequence)) {
+                applied += apply(rec) ? 1 : 0;
+            }
+            return applied;
+        }
+
+        //======================== checkpoints ========================
+
+        //writes every table scope with its payer and rows, and the position to path, replacing it only once complete
+        void checkpoint(const std::string& path) {
+            std::string tmp = path + ".tmp";
+            FILE* f = fopen(tmp.c_str(), "wb");
+            check(f != nullptr, "cannot write checkpoint " + tmp);
+
+            bool ok = write_value(f, checkpoint_magic) && write_value(f, checkpoint_version) && write_value(f, last_sequence);
+            state.for_each_table(self, [&](uint64_t scope, name table_name, host::table& t) {
+                if (t.rows.empty()) {
+                    return;
+                }
+                ok = ok && write_value(f, table_name.value) && write_value(f, scope) && write_value(f, t.payer.value)
+                    && write_value(f, uint32_t(t.rows.size()));
+                for (auto& r : t.rows) {
+                    ok = ok && write_value(f, r.first) && write_value(f, r.second.payer.value) && write_value(f, uint32_t(r.second.data.size()))
+                        && fwrite(r.second.data.data(), 1, r.second.data.size(), f) == r.second.data.size();
+                }
+            });
+            ok = (fclose(f) == 0) && ok;
+
+            check(ok, "failed writing checkpoint " + tmp);
+            check(rename(tmp.c_str(), path.c_str()) == 0, "cannot replace checkpoint " + path);
+        }
+
+        //loads a checkpoint or snapshot into an empty mirror
+        void load(const std::string& path) {
+            check(last_sequence == 0 && owners.empty(), "mirror must be empty to load a checkpoint");
+
+            FILE* f = fopen(path.c_str(), "rb");
+            check(f != nullptr, "cannot open checkpoint " + path);
+
+            uint32_t magic = 0, version = 0;
+            uint64_t sequence = 0;
+            bool ok = read_value(f, magic) && read_value(f, version) && read_value(f, sequence);
+            if (!ok || magic != checkpoint_magic || version != checkpoint_version) {
+                fclose(f);
+                check(false, "not a drealms checkpoint: " + path);
+            }
+
+            uint64_t table_name, scope, scope_payer, primary_key, payer;
+            uint32_t rows, size;
+            std::vector<char> data;
+            while (read_value(f, table_name)) {
+                ok = read_value(f, scope) && read_value(f, scope_payer) && read_value(f, rows) && rows > 0;
+                for (uint32_t i = 0; ok && i < rows; ++i) {
+                    ok = read_value(f, primary_key) && read_value(f, payer) && read_value(f, size);
+                    if (ok) {
+                        data.resize(size);
+                        ok = fread(data.data(), 1, size, f) == size;
+                    }
+                    if (ok) {
+                        load_row(name(table_name), scope, primary_key, name(payer), data);
+                    }
+                }
+                if (!ok) {
+                    fclose(f);
+                    check(false, "truncated checkpoint " + path);
+                }
+                load_scope_payer(name(table_name), scope, name(scope_payer));
+            }
+            fclose(f);
+
+            last_sequence = sequence;
+        }
+
+        //======================== queries ========================
+
+        //every nft held by an account
+        const std::set<nft_key>& owned_by(name owner) const {
+            static const std::set<nft_key> none;
+            auto itr = owners.find(owner.value);
+            return itr == owners.end() ? none : itr->second;
+        }
+
+        //accounts holding a schema and how many nfts each holds
+        const std::map<uint64_t, uint64_t>& holders(name schema_name) const {
+            static const std::map<uint64_t, uint64_t> none;
+            auto itr = schema_holders.find(schema_name.value);
+            return itr == schema_holders.end() ? none : itr->second;
+        }
+
+        //decoded rows point into the mirror and are valid until the next apply or load
+        std::optional<client::nonfungible_row> nft(name schema_name, uint64_t serial) {
+            auto* r = find_row(name("nfts"), schema_name.value, serial);
+            return r ? std::optional(client::nonfungible_row::decode(view(*r))) : std::nullopt;
+        }
+
+        std::optional<client::schema_row> schema(name schema_name) {
+            auto* r = find_row(name("schemas"), self.value, schema_name.value);
+            return r ? std::optional(client::schema_row::decode(view(*r))) : std::nullopt;
+        }
+
+        std::optional<client::license_row> license(name schema_name, name owner) {
+            auto* r = find_row(name("licenses"), schema_name.value, owner.value);
+            return r ? std::optional(client::license_row::decode(view(*r))) : std::nullopt;
+        }
+
+        std::optional<client::uri_prefixes_row> uri_prefixes(name schema_name, name owner) {
+            auto* r = find_row(name("uriprefixes"), schema_name.value, owner.value);
+            return r ? std::optional(client::uri_prefixes_row::decode(view(*r))) : std::nullopt;
+        }
+
+        std::optional<client::currency_row> currency(symbol_code code) {
+            auto* r = find_row(name("currencies"), self.value, code.raw());
+            return r ? std::optional(client::currency_row::decode(view(*r))) : std::nullopt;
+        }
+
+        std::optional<client::account_row> balance(name owner, symbol_code code) {
+            auto* r = find_row(name("accounts"), owner.value, code.raw());
+            return r ? std::optional(client::account_row::decode(view(*r))) : std::nullopt;
+        }
+
+        //underlying tables, e.g. for comparing two mirrors
+        host::chain& chain() { return state; }
+
+    private:
+
+        template<typename T>
+        static bool write_value(FILE* f, const T& v) {
+            return fwrite(&v, sizeof(T), 1, f) == 1;
+        }
+
+        template<typename T>
+        static bool read_value(FILE* f, T& v) {
+            return fread(&v, sizeof(T), 1, f) == 1;
+        }
+
+        static std::string_view view(const host::row& r) {
+            return std::string_view(r.data.data(), r.data.size());
+        }
+
+        const host::row* find_row(name table_name, uint64_t scope, uint64_t primary_key) {
+            auto* t = state.find_table(self, scope, table_name);
+            if (!t) {
+                return nullptr;
+            }
+            auto itr = t->rows.find(primary_key);
+            return itr == t->rows.end() ? nullptr : &itr->second;
+        }
+
+        //owner is the second field of both nft row versions
+        static name nft_owner(const host::row& r) {
+            uint64_t owner;
+            check(r.data.size() >= 16, "nft row is too short");
+            memcpy(&owner, r.data.data() + 8, sizeof(owner));
+            return name(owner);
+        }
+
+        void index_nft(name schema_name, const host::row* old_row, const host::row* new_row) {
+            name old_owner = old_row ? nft_owner(*old_row) : name();
+            name new_owner = new_row ? nft_owner(*new_row) : name();
+            if (old_row && new_row && old_owner == new_owner) {
+                return;
+            }
+
+            const host::row* any_row = new_row ? new_row : old_row;
+            uint64_t serial;
+            memcpy(&serial, any_row->data.data(), sizeof(serial));
+            nft_key key{schema_name, serial};
+
+            if (old_row) {
+                auto& held = owners[old_owner.value];
+                held.erase(key);
+                if (held.empty()) {
+                    owners.erase(old_owner.value);
+                }
+                auto& counts = schema_holders[schema_name.value];
+                if (--counts[old_owner.value] == 0) {
+                    counts.erase(old_owner.value);
+                }
+            }
+            if (new_row) {
+                owners[new_owner.value].insert(key);
+                schema_holders[schema_name.value][new_owner.value] += 1;
+            }
+        }
+
+        name self;
+        host::chain state;
+        uint64_t last_sequence = 0;
+
+        std::mutex index_mutex;
+        std::map<uint64_t, std::set<nft_key>> owners; //owner => nfts
+        std::map<uint64_t, std::map<uint64_t, uint64_t>> schema_holders; //schema => owner => count
+    };
+
+}
@@ -0,0 +1,758 @@
+// Rows and table scopes each drealms action may read or write.
+//
+// Derived from the action's arguments, following the table accesses in
+// drealms.cpp. Modifying an existing row is a row access. Adding or removing
+// a row is a row access too where it cannot change who pays for the table
+// scope: nfts rows are paid by the schema issuer, recipe rows by the issuer
+// of their schema, and schema and currency rows are never erased, so once
+// their scope holds a row a new one only touches itself. Crafted nfts are
+// paid by the crafter, so while a schema holds any, adding or removing its
+// nfts claims the whole nfts scope. Anything else that may add or remove
+// rows claims the whole table scope.
+//
+// The supply counters of a schema row are tracked as their own "supply"
+// row, so actions reading only the schema's configuration do not wait for
+// every mint. Every write of a schema row also writes its supply.
+//
+// An nft owner change writes the holdings row of the old and the new owner,
+// and adding or removing a holdings row touches only that row. Holdings
+// rows commute, but the scope is billed to the payer of whichever row
+// creates it, so the map tracks the payer each scope has in trace order and
+// replay restores it before anything claims the scope, at barriers and at
+// the end of a batch. Holdings are predicted from the nft owners of schemas
+// counting every nft; for other schemas, and owners holding any of them,
+// adding or removing a holdings row claims the scope.
+//
+// A relative newuri may add the license owner's uri prefix dictionary, paid
+// by the owner. Dictionaries are never erased, so only a newuri that may add
+// the first one of a schema claims its uriprefixes scope.
+//
+// retirerange and consumerange claim the nfts and cleanups scopes of the
+// schema, and replay the walk of the contract over the known nfts from the
+// saved cursor, so the owners and holdings they remove stay known. A batch
+// has the accesses of each of its operations, in order.
+//
+// The state needed is learned from the actions creating, moving and
+// removing it and from the tables: currency issuers, which schemas exist,
+// which count holdings and how many nfts each has issued, since a new nft
+// takes serial issued_supply + 1, who owns each nft and which were crafted,
+// schema issuers, saved cleanup cursors and which accounts have a
+// notification subscription.
+// The materials of recipes are only learned from newrecipe; crafting with
+// a recipe set before the trace claims the currencies scope.
+// Actions not listed here, or needing state not yet seen, must run alone.
+//
+// Keep in step with drealms.cpp: an access missing here lets replay run two
+// conflicting actions at the same time. bench_replay records the accesses
+// the native host makes for every action and fails on any not listed here.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <eosio/eosio.hpp>
+#include <eosio/asset.hpp>
+
+#include "../client/rows.hpp"
+
+namespace drealms_replay {
+
+    using namespace eosio;
+
+    constexpr size_t uri_prefix_min_length = 16; //drealms::uriprefix::min_length
+
+    struct access {
+        name table_name;
+        uint64_t scope;
+        uint64_t primary_key; //ignored for whole scope accesses
+        bool whole_scope;
+        bool write;
+    };
+
+    //the payer a table scope is billed to
+    struct scope_payer {
+        name table_name;
+        uint64_t scope;
+        name payer;
+    };
+
+    //true if an access recorded by the native host is one of the predicted ones, seeks need the whole scope
+    //and a write of a schema row may be a write of its supply counters only
+    inline bool covers(const std::vector<access>& predicted, const host::table_access& actual) {
+        for (auto& a : predicted) {
+            if (a.scope != actual.scope) {
+                continue;
+            }
+            bool supply = a.table_name == name("supply") && actual.table_name == name("schemas");
+            if (a.table_name != actual.table_name && !supply) {
+                continue;
+            }
+            if (a.whole_scope) {
+                return true;
+            }
+            if (!actual.seek && a.primary_key == actual.primary_key && (a.write || !actual.write)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    class access_map {
+
+    public:
+
+        explicit access_map(name contract) : self(contract) {}
+
+        //reads currency issuers and schema supplies from existing state, e.g. a loaded checkpoint
+        void learn(host::chain& c) {
+            if (auto* t = c.find_table(self, self.value, name("currencies"))) {
+                for (auto& r : t->rows) {
+                    auto curr = drealms_client::currency_row::decode(std::string_view(r.second.data.data(), r.second.data.size()));
+                    currency_issuers[r.first] = name(curr.issuer.value);
+                }
+            }
+            if (auto* t = c.find_table(self, self.value, name("schemas"))) {
+                for (auto& r : t->rows) {
+                    auto sch = drealms_client::schema_row::decode(std::string_view(r.second.data.data(), r.second.data.size()));
+                    issued_supplies[r.first] = sch.issued_supply;
+                    schema_issuers[r.first] = name(sch.issuer.value);
+                    if (sch.settings.find(drealms_client::name(name("holdings").value)).value_or(false)) {
+                        counted_schemas.insert(r.first);
+                    }
+                }
+            }
+            if (auto* t = c.find_table(self, self.value, name("subscribers"))) {
+                for (auto& r : t->rows) {
+                    subscribers.insert(r.first);
+                }
+            }
+            c.for_each_scope(self, name("uriprefixes"), [&](uint64_t scope, host::table& t) {
+                if (!t.rows.empty()) {
+                    prefix_scopes.insert(scope);
+                }
+            });
+            c.for_each_scope(self, name("cleanups"), [&](uint64_t scope, host::table& t) {
+                for (auto& r : t.rows) {
+                    auto cln = drealms_client::cleanup_row::decode(std::string_view(r.second.data.data(), r.second.data.size()));
+                    cleanup_cursors[{scope, r.first}] = cleanup_cursor{name(cln.kind.value), cln.first_serial, cln.last_serial, cln.cursor};
+                }
+            });
+            c.for_each_scope(self, name("nfts"), [&](uint64_t scope, host::table& t) {
+                bool counted = counted_schemas.count(scope) > 0;
+                for (auto& r : t.rows) {
+                    auto nft = drealms_client::nonfungible_row::decode(std::string_view(r.second.data.data(), r.second.data.size()));
+                    nft_owners[{scope, r.first}] = name(nft.owner.value);
+                    if (r.second.payer != schema_issuers[scope]) {
+                        crafted_serials.insert({scope, r.first});
+                        crafted_counts[scope] += 1;
+                    }
+                    if (counted) {
+                        holding_counts[{nft.owner.value, scope}] += 1;
+                    }
+                }
+            });
+            c.for_each_scope(self, name("holdings"), [&](uint64_t scope, host::table& t) {
+                if (!t.rows.empty()) {
+                    holding_scopes[scope] = holding_scope{t.rows.size(), t.payer};
+                }
+            });
+        }
+
+        //fills out with every access of act, returns false if the action must run alone
+        bool accesses(const host::action_data& act, std::vector<access>& out) {
+            out.clear();
+            restores.clear();
+            if (!add_accesses(act, out)) {
+                settle(restores);
+                return false;
+            }
+            return true;
+        }
+
+        //payers of the holdings scopes to restore before the action last passed to accesses runs
+        const std::vector<scope_payer>& payers_before() const {
+            return restores;
+        }
+
+        //appends the payers of holdings scopes rows were added to or removed from without claiming them
+        void settle(std::vector<scope_payer>& out) {
+            for (auto owner : unsettled) {
+                auto scope = holding_scopes.find(owner);
+                if (scope != holding_scopes.end()) {
+                    out.push_back(scope_payer{name("holdings"), owner, scope->second.payer});
+                }
+            }
+            unsettled.clear();
+        }
+
+    private:
+
+        //batch operations, packed as the arguments of the action of the same name
+        using batch_op = std::variant<
+            std::tuple<name, name, name, name, std::string, std::optional<uint64_t>>, //newuri
+            std::tuple<name, name, uint64_t, std::string>, //newchecksum
+            std::tuple<name, name, name, std::vector<uint64_t>, std::string>, //transfernft
+            std::tuple<name, uint64_t, name>>; //spendpoint
+
+        //appends the accesses of act to out
+        bool add_accesses(const host::action_data& act, std::vector<access>& out) {
+            const char* data = act.data.data();
+            size_t size = act.data.size();
+
+            switch (act.name.value) {
+                //======================== realm ========================
+                case name("setrealmdata").value :
+                case name("setnotify").value :
+                    write_scope(out, name("realmdata"), self.value);
+                    return true;
+
+                //======================== notifications ========================
+                case name("subscribe").value : {
+                    auto [account, schemas, currencies] =
+                        unpack<std::tuple<name, std::vector<name>, std::vector<symbol_code>>>(data, size);
+                    for (auto schema_name : schemas) {
+                        read_row(out, name("schemas"), self.value, schema_name.value);
+                    }
+                    for (auto code : currencies) {
+                        read_row(out, name("currencies"), self.value, code.raw());
+                    }
+                    if (subscribers.count(account.value)) {
+                        write_row(out, name("subscribers"), self.value, account.value);
+                    } else {
+                        write_scope(out, name("subscribers"), self.value);
+                        subscribers.insert(account.value);
+                    }
+                    return true;
+                }
+                case name("unsubscribe").value : {
+                    auto [account] = unpack<std::tuple<name>>(data, size);
+                    write_scope(out, name("subscribers"), self.value);
+                    subscribers.erase(account.value);
+                    return true;
+                }
+
+                //======================== schemas ========================
+                case name("newnftschema").value : {
+                    auto [new_schema_name, issuer] = unpack<std::tuple<name, name>>(data, size);
+                    if (issued_supplies.empty()) {
+                        write_scope(out, name("schemas"), self.value);
+                    } else {
+                        write_schema(out, new_schema_name);
+                    }
+                    write_scope(out, name("licenses"), new_schema_name.value);
+                    issued_supplies[new_schema_name.value] = 0;
+                    schema_issuers[new_schema_name.value] = issuer;
+                    counted_schemas.insert(new_schema_name.value);
+                    return true;
+                }
+                case name("toggle").value :
+                case name("addstat").value :
+                case name("setlicmodel").value :
+                case name("setlicminmax").value : {
+                    auto [schema_name] = unpack<std::tuple<name>>(data, size);
+                    write_schema(out, schema_name);
+                    return true;
+                }
+                case name("syncstats").value : {
+                    auto [schema_name, serial] = unpack<std::tuple<name, uint64_t>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    read_row(out, name("nfts"), schema_name.value, serial);
+                    return true;
+                }
+                case name("awardexp").value : {
+                    auto [schema_name, license_owner, serial] = unpack<std::tuple<name, name, uint64_t>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    read_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    read_row(out, name("nfts"), schema_name.value, serial);
+                    return true;
+                }
+                case name("newchecksum").value : {
+                    auto [schema_name, license_owner, serial] = unpack<std::tuple<name, name, uint64_t>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    read_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    write_row(out, name("nfts"), schema_name.value, serial);
+                    return true;
+                }
+
+                //======================== licenses ========================
+                case name("newlicense").value :
+                case name("eraselicense").value : {
+                    auto [schema_name] = unpack<std::tuple<name>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    write_scope(out, name("licenses"), schema_name.value);
+                    return true;
+                }
+                case name("setalgo").value : {
+                    auto [schema_name, license_owner] = unpack<std::tuple<name, name>>(data, size);
+                    write_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    return true;
+                }
+                case name("setati").value : {
+                    auto [schema_name, license_owner] = unpack<std::tuple<name, name>>(data, size);
+                    write_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    read_row(out, name("uriprefixes"), schema_name.value, license_owner.value);
+                    return true;
+                }
+                case name("newuri").value : {
+                    auto [schema_name, license_owner, uri_group, uri_name, new_uri, serial] =
+                        unpack<std::tuple<name, name, name, name, std::string, std::optional<uint64_t>>>(data, size);
+                    write_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    if (uri_group != name("relative")) {
+                        read_row(out, name("uriprefixes"), schema_name.value, license_owner.value);
+                    } else if (prefix_scopes.count(schema_name.value) == 0) {
+                        write_scope(out, name("uriprefixes"), schema_name.value);
+                    } else {
+                        write_row(out, name("uriprefixes"), schema_name.value, license_owner.value);
+                    }
+                    if (uri_group == name("relative") && new_uri.rfind('/') + 1 >= uri_prefix_min_length) {
+                        prefix_scopes.insert(schema_name.value);
+                    }
+                    if (serial) {
+                        write_row(out, name("nfts"), schema_name.value, *serial);
+                    }
+                    return true;
+                }
+                case name("deleteuri").value : {
+                    auto [schema_name, license_owner, uri_group, uri_name, serial] =
+                        unpack<std::tuple<name, name, name, name, std::optional<uint64_t>>>(data, size);
+                    write_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    if (serial) {
+                        write_row(out, name("nfts"), schema_name.value, *serial);
+                    }
+                    return true;
+                }
+
+                //======================== nonfungibles ========================
+                case name("issuenft").value : {
+                    auto [to, schema_name] = unpack<std::tuple<name, name>>(data, size);
+                    auto issued = issued_supplies.find(schema_name.value);
+                    if (issued == issued_supplies.end()) {
+                        return false;
+                    }
+                    issued->second += 1;
+                    write_supply(out, schema_name);
+                    write_nft_change(out, schema_name, issued->second);
+                    write_holding(out, to, schema_name, 1, schema_issuers[schema_name.value]);
+                    nft_owners[{schema_name.value, issued->second}] = to;
+                    read_notify(out, to);
+                    return true;
+                }
+                case name("retirenft").value : {
+                    auto [schema_name, serials] = unpack<std::tuple<name, std::vector<uint64_t>>>(data, size);
+                    write_supply(out, schema_name);
+                    for (auto serial : serials) {
+                        if (!remove_nft(out, schema_name, serial)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                case name("consumenft").value : {
+                    auto [schema_name, serial] = unpack<std::tuple<name, uint64_t>>(data, size);
+                    write_supply(out, schema_name);
+                    return remove_nft(out, schema_name, serial);
+                }
+                case name("retirerange").value : {
+                    auto [schema_name, first_serial, last_serial, max_rows] =
+                        unpack<std::tuple<name, uint64_t, uint64_t, uint32_t>>(data, size);
+                    auto issuer = schema_issuers.find(schema_name.value);
+                    if (issuer == schema_issuers.end()) {
+                        return false;
+                    }
+                    remove_range(out, name("retire"), issuer->second, schema_name, first_serial, last_serial, max_rows);
+                    return true;
+                }
+                case name("consumerange").value : {
+                    auto [owner, schema_name, first_serial, last_serial, max_rows] =
+                        unpack<std::tuple<name, name, uint64_t, uint64_t, uint32_t>>(data, size);
+                    remove_range(out, name("consume"), owner, schema_name, first_serial, last_serial, max_rows);
+                    return true;
+                }
+                case name("transfernft").value : {
+                    auto [from, to, schema_name, serials] = unpack<std::tuple<name, name, name, std::vector<uint64_t>>>(data, size);
+                    move_nfts(out, from, to, schema_name, serials, has_auth(act, to) ? to : from);
+                    read_notify(out, from);
+                    read_notify(out, to);
+                    return true;
+                }
+                case name("swapnft").value : {
+                    auto [seller, buyer, schema_name, serials, price] =
+                        unpack<std::tuple<name, name, name, std::vector<uint64_t>, asset>>(data, size);
+                    move_nfts(out, seller, buyer, schema_name, serials, buyer);
+                    read_row(out, name("currencies"), self.value, price.symbol.code().raw());
+                    write_row(out, name("accounts"), buyer.value, price.symbol.code().raw());
+                    write_scope(out, name("accounts"), seller.value);
+                    read_notify(out, seller);
+                    read_notify(out, buyer);
+                    return true;
+                }
+                case name("activatenft").value :
+                case name("levelup").value :
+                case name("spendpoint").value : {
+                    auto [schema_name, serial] = unpack<std::tuple<name, uint64_t>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    write_row(out, name("nfts"), schema_name.value, serial);
+                    return true;
+                }
+
+                case name("viewnfts").value : {
+                    auto [schema_name, license_owner, serials] = unpack<std::tuple<name, name, std::vector<uint64_t>>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    read_row(out, name("licenses"), schema_name.value, license_owner.value);
+                    for (auto serial : serials) {
+                        read_row(out, name("nfts"), schema_name.value, serial);
+                    }
+                    return true;
+                }
+
+                //======================== crafting ========================
+                case name("newrecipe").value : {
+                    auto [schema_name, recipe_name, inputs, materials] =
+                        unpack<std::tuple<name, name, std::map<name, uint64_t>, std::vector<asset>>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    for (auto& in : inputs) {
+                        read_row(out, name("schemas"), self.value, in.first.value);
+                    }
+                    auto& codes = recipe_materials[{schema_name.value, recipe_name.value}];
+                    codes.clear();
+                    for (auto& quantity : materials) {
+                        read_row(out, name("currencies"), self.value, quantity.symbol.code().raw());
+                        codes.push_back(quantity.symbol.code().raw());
+                    }
+                    write_row(out, name("recipes"), schema_name.value, recipe_name.value);
+                    return true;
+                }
+                case name("eraserecipe").value : {
+                    auto [schema_name, recipe_name] = unpack<std::tuple<name, name>>(data, size);
+                    read_row(out, name("schemas"), self.value, schema_name.value);
+                    write_row(out, name("recipes"), schema_name.value, recipe_name.value);
+                    recipe_materials.erase({schema_name.value, recipe_name.value});
+                    return true;
+                }
+                case name("craft").value : {
+                    auto [crafter, schema_name, recipe_name, inputs] =
+                        unpack<std::tuple<name, name, name, std::map<name, std::vector<uint64_t>>>>(data, size);
+                    auto issued = issued_supplies.find(schema_name.value);
+                    if (issued == issued_supplies.end()) {
+                        return false;
+                    }
+                    read_row(out, name("recipes"), schema_name.value, recipe_name.value);
+                    for (auto& in : inputs) {
+                        write_supply(out, in.first);
+                        for (auto serial : in.second) {
+                            if (!remove_nft(out, in.first, serial)) {
+                                return false;
+                            }
+                        }
+                    }
+                    auto materials = recipe_materials.find({schema_name.value, recipe_name.value});
+                    if (materials == recipe_materials.end()) {
+                        write_scope(out, name("currencies"), self.value);
+                        write_scope(out, name("accounts"), crafter.value);
+                    } else {
+                        for (auto code : materials->second) {
+                            write_row(out, name("currencies"), self.value, code);
+                            write_row(out, name("accounts"), crafter.value, code);
+                        }
+                    }
+                    issued->second += 1;
+                    write_supply(out, schema_name);
+                    crafted_serials.insert({schema_name.value, issued->second});
+                    crafted_counts[schema_name.value] += 1;
+                    write_nft_change(out, schema_name, issued->second);
+                    write_holding(out, crafter, schema_name, 1, crafter);
+                    nft_owners[{schema_name.value, issued->second}] = crafter;
+                    read_notify(out, crafter);
+                    return true;
+                }
+
+                //======================== batch ========================
+                case name("batch").value : {
+                    static const name op_names[] = {name("newuri"), name("newchecksum"), name("transfernft"), name("spendpoint")};
+                    auto [ops] = unpack<std::tuple<std::vector<batch_op>>>(data, size);
+                    for (auto& op : ops) {
+                        host::action_data sub{act.account, op_names[op.index()], act.authorization, {}};
+                        sub.data = std::visit([](auto& args) { return pack(args); }, op);
+                        if (!add_accesses(sub, out)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                //======================== fungibles ========================
+                case name("create").value : {
+                    auto [issuer, retirable, transferable, consumable, max_supply] =
+                        unpack<std::tuple<name, bool, bool, bool, asset>>(data, size);
+                    if (currency_issuers.empty()) {
+                        write_scope(out, name("currencies"), self.value);
+                    } else {
+                        write_row(out, name("currencies"), self.value, max_supply.symbol.code().raw());
+                    }
+                    currency_issuers.emplace(max_supply.symbol.code().raw(), issuer);
+                    return true;
+                }
+                case name("issue").value : {
+                    auto [to, quantity] = unpack<std::tuple<name, asset>>(data, size);
+                    write_row(out, name("currencies"), self.value, quantity.symbol.code().raw());
+                    write_scope(out, name("accounts"), to.value);
+                    read_notify(out, to);
+                    return true;
+                }
+                case name("retire").value : {
+                    auto [quantity] = unpack<std::tuple<asset>>(data, size);
+                    auto issuer = currency_issuers.find(quantity.symbol.code().raw());
+                    if (issuer == currency_issuers.end()) {
+                        return false;
+                    }
+                    write_row(out, name("currencies"), self.value, quantity.symbol.code().raw());
+                    write_row(out, name("accounts"), issuer->second.value, quantity.symbol.code().raw());
+                    return true;
+                }
+                case name("transfer").value : {
+                    auto [from, to, quantity] = unpack<std::tuple<name, name, asset>>(data, size);
+                    read_row(out, name("currencies"), self.value, quantity.symbol.code().raw());
+                    write_row(out, name("accounts"), from.value, quantity.symbol.code().raw());
+                    write_scope(out, name("accounts"), to.value);
+                    read_notify(out, from);
+                    read_notify(out, to);
+                    return true;
+                }
+                case name("consume").value : {
+                    auto [owner, quantity] = unpack<std::tuple<name, asset>>(data, size);
+                    write_row(out, name("currencies"), self.value, quantity.symbol.code().raw());
+                    write_row(out, name("accounts"), owner.value, quantity.symbol.code().raw());
+                    return true;
+                }
+                case name("open").value : {
+                    auto [owner, currency_symbol] = unpack<std::tuple<name, symbol>>(data, size);
+                    read_row(out, name("currencies"), self.value, currency_symbol.code().raw());
+                    write_scope(out, name("accounts"), owner.value);
+                    return true;
+                }
+                case name("close").value : {
+                    auto [owner] = unpack<std::tuple<name>>(data, size);
+                    write_scope(out, name("accounts"), owner.value);
+                    return true;
+                }
+
+                //======================== migrations ========================
+                case name("migrate").value : {
+                    auto [table_name, scope] = unpack<std::tuple<name, name>>(data, size);
+                    if (table_name == name("holdings")) {
+                        holdings_known = false;
+                        return false; //counts into the holdings of any owner
+                    }
+                    write_scope(out, name("migrations"), table_name.value);
+                    read_row(out, name("schemas"), self.value, scope.value);
+                    write_scope(out, table_name, scope.value);
+                    return true;
+                }
+
+                //======================== event log ========================
+                case name("logevents").value :
+                    return true;
+
+                default:
+                    return false;
+            }
+        }
+
+        static void read_row(std::vector<access>& out, name table_name, uint64_t scope, uint64_t primary_key) {
+            out.push_back(access{table_name, scope, primary_key, false, false});
+        }
+
+        static void write_row(std::vector<access>& out, name table_name, uint64_t scope, uint64_t primary_key) {
+            out.push_back(access{table_name, scope, primary_key, false, true});
+        }
+
+        static void write_scope(std::vector<access>& out, name table_name, uint64_t scope) {
+            out.push_back(access{table_name, scope, 0, true, true});
+        }
+
+        //reads the schema's configuration and writes its supply counters
+        void write_supply(std::vector<access>& out, name schema_name) const {
+            read_row(out, name("schemas"), self.value, schema_name.value);
+            write_row(out, name("supply"), self.value, schema_name.value);
+        }
+
+        //writes the whole schema row
+        void write_schema(std::vector<access>& out, name schema_name) const {
+            write_row(out, name("schemas"), self.value, schema_name.value);
+            write_row(out, name("supply"), self.value, schema_name.value);
+        }
+
+        //reads the realm notify mode and the account's subscription
+        void read_notify(std::vector<access>& out, name account) const {
+            read_row(out, name("realmdata"), self.value, name("realmdata").value);
+            read_row(out, name("subscribers"), self.value, account.value);
+        }
+
+        //true if account authorized act, as has_auth in the contract
+        static bool has_auth(const host::action_data& act, name account) {
+            return std::any_of(act.authorization.begin(), act.authorization.end(), [&](auto& auth) { return auth.actor == account; });
+        }
+
+        //writes the nfts moved and the holdings of both owners
+        void move_nfts(std::vector<access>& out, name from, name to, name schema_name, const std::vector<uint64_t>& serials, name ram_payer) {
+            read_row(out, name("schemas"), self.value, schema_name.value);
+            for (auto serial : serials) {
+                write_row(out, name("nfts"), schema_name.value, serial);
+                nft_owners[{schema_name.value, serial}] = to;
+            }
+            write_holding(out, from, schema_name, -int64_t(serials.size()), name());
+            write_holding(out, to, schema_name, int64_t(serials.size()), ram_payer);
+        }
+
+        //writes the holding of owner, or its whole holdings scope where a row is added or removed while its other rows are not known
+        void write_holding(std::vector<access>& out, name owner, name schema_name, int64_t change, name ram_payer) {
+            if (!holdings_known || !counted_schemas.count(schema_name.value)) {
+                forget_holdings(owner);
+                write_scope(out, name("holdings"), owner.value);
+                return;
+            }
+
+            auto& held = holding_counts[{owner.value, schema_name.value}];
+            int64_t left = int64_t(held) + change;
+            bool added = held == 0 && left > 0;
+            bool removed = held > 0 && left <= 0;
+            if ((added || removed) && uncounted_holders.count(owner.value)) {
+                write_scope(out, name("holdings"), owner.value);
+            } else {
+                write_row(out, name("holdings"), owner.value, schema_name.value);
+            }
+
+            //the scope is created by its first row and dropped with its last
+            if ((added || removed) && !uncounted_holders.count(owner.value)) {
+                auto& scope = holding_scopes[owner.value];
+                if (added && scope.rows++ == 0) {
+                    scope.payer = ram_payer;
+                }
+                if (removed && --scope.rows == 0) {
+                    holding_scopes.erase(owner.value);
+                }
+                unsettled.insert(owner.value);
+            }
+
+            held = uint64_t(std::max<int64_t>(left, 0));
+            if (held == 0) {
+                holding_counts.erase({owner.value, schema_name.value});
+            }
+        }
+
+        //stops tracking the holdings rows of owner, restoring its scope payer before the action runs
+        void forget_holdings(name owner) {
+            auto scope = holding_scopes.find(owner.value);
+            if (unsettled.erase(owner.value) && scope != holding_scopes.end()) {
+                restores.push_back(scope_payer{name("holdings"), owner.value, scope->second.payer});
+            }
+            if (scope != holding_scopes.end()) {
+                holding_scopes.erase(scope);
+            }
+            uncounted_holders.insert(owner.value);
+        }
+
+        //writes an nft row being added or removed, or the whole scope while the schema holds crafted nfts
+        void write_nft_change(std::vector<access>& out, name schema_name, uint64_t serial) const {
+            if (crafted_counts.count(schema_name.value)) {
+                write_scope(out, name("nfts"), schema_name.value);
+            } else {
+                write_row(out, name("nfts"), schema_name.value, serial);
+            }
+        }
+
+        //writes the removal of an nft and its owner's holding and forgets the nft, false if the nft is unknown
+        bool remove_nft(std::vector<access>& out, name schema_name, uint64_t serial) {
+            auto owner = nft_owners.find({schema_name.value, serial});
+            if (owner == nft_owners.end()) {
+                return false;
+            }
+            write_nft_change(out, schema_name, serial);
+            write_holding(out, owner->second, schema_name, -1, name());
+            if (crafted_serials.erase({schema_name.value, serial}) && --crafted_counts[schema_name.value] == 0) {
+                crafted_counts.erase(schema_name.value);
+            }
+            nft_owners.erase(owner);
+            return true;
+        }
+
+        //writes a bounded range removal and replays its walk from the saved cursor over the known nfts
+        void remove_range(std::vector<access>& out, name kind, name owner, name schema_name,
+            uint64_t first_serial, uint64_t last_serial, uint32_t max_rows) {
+            write_supply(out, schema_name);
+            write_scope(out, name("nfts"), schema_name.value);
+            write_scope(out, name("cleanups"), schema_name.value);
+
+            auto saved = cleanup_cursors.find({schema_name.value, owner.value});
+            bool resume = saved != cleanup_cursors.end() && saved->second.kind == kind
+                && saved->second.first_serial == first_serial && saved->second.last_serial == last_serial;
+            uint64_t cursor = resume ? saved->second.cursor : first_serial;
+
+            auto nft = nft_owners.lower_bound({schema_name.value, cursor});
+            auto in_range = [&]() {
+                return nft != nft_owners.end() && nft->first.first == schema_name.value && nft->first.second <= last_serial;
+            };
+            int64_t removed = 0;
+            for (uint32_t visited = 0; in_range() && visited < max_rows; ++visited) {
+                if (nft->second != owner) {
+                    ++nft;
+                    continue;
+                }
+                if (crafted_serials.erase(nft->first) && --crafted_counts[schema_name.value] == 0) {
+                    crafted_counts.erase(schema_name.value);
+                }
+                removed += 1;
+                nft = nft_owners.erase(nft);
+            }
+
+            if (!in_range()) {
+                cleanup_cursors.erase({schema_name.value, owner.value});
+            } else {
+                cleanup_cursors[{schema_name.value, owner.value}] = cleanup_cursor{kind, first_serial, last_serial, nft->first.second};
+            }
+            if (removed > 0) {
+                write_holding(out, owner, schema_name, -removed, name());
+            }
+        }
+
+        //rows of an owner's holdings scope and the payer of the row that created it, in trace order
+        struct holding_scope {
+            uint64_t rows = 0;
+            name payer;
+        };
+
+        struct cleanup_cursor {
+            name kind;
+            uint64_t first_serial;
+            uint64_t last_serial;
+            uint64_t cursor;
+        };
+
+        name self;
+        std::map<uint64_t, name> currency_issuers; //symbol code => issuer
+        std::map<uint64_t, uint64_t> issued_supplies; //schema => issued supply
+        std::set<uint64_t> counted_schemas; //schemas counting every nft in holdings
+        std::map<std::pair<uint64_t, uint64_t>, name> nft_owners; //schema, serial => owner
+        std::map<std::pair<uint64_t, uint64_t>, uint64_t> holding_counts; //owner, schema => nfts held in counted schemas
+        std::map<uint64_t, holding_scope> holding_scopes; //owner => holdings scope, for owners whose rows are all known
+        std::set<uint64_t> uncounted_holders; //owners who may hold rows of uncounted schemas
+        bool holdings_known = true; //false once a holdings migration may have added rows to any owner
+        std::set<uint64_t> unsettled; //owners whose holdings scope payer may differ from trace order once replayed
+        std::vector<scope_payer> restores; //holdings scope payers to restore before the last action
+        std::set<std::pair<uint64_t, uint64_t>> crafted_serials; //schema, serial of live nfts paid by their crafter
+        std::map<uint64_t, uint64_t> crafted_counts; //schema => live crafted nfts
+        std::map<std::pair<uint64_t, uint64_t>, std::vector<uint64_t>> recipe_materials; //schema, recipe => material symbol codes
+        std::set<uint64_t> subscribers; //accounts with a subscription
+        std::map<uint64_t, name> schema_issuers; //schema => issuer
+        std::map<std::pair<uint64_t, uint64_t>, cleanup_cursor> cleanup_cursors; //schema, owner => saved cleanup
+        std::set<uint64_t> prefix_scopes; //schemas holding a uri prefix dictionary
+    };
+
+}
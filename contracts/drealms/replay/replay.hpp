@@ -0,0 +1,288 @@
+// Parallel replay of recorded drealms actions into a state mirror.
+//
+// Builds a dependency graph over the actions from the rows and scopes each
+// one touches (access.hpp): an action waits for the last earlier write to
+// anything it reads, and for every earlier read and write of anything it
+// writes. Actions whose accesses are unknown become barriers that wait for
+// everything before them and block everything after. Table scopes whose
+// rows may be added in another order than traced get their payer restored
+// before the next action claiming them and once the batch ends (see the
+// holdings in access.hpp). The graph then runs
+// on a pool of workers that each pop their own newest ready action and
+// steal the oldest from the others when idle, so actions on independent
+// schemas, licenses, nfts and holders execute side by side while the final
+// state matches a serial replay.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+#include "../mirror/mirror.hpp"
+#include "access.hpp"
+
+namespace drealms_replay {
+
+    using drealms_mirror::trace_record;
+
+    struct replay_error : std::runtime_error {
+        uint64_t sequence; //first action that failed
+
+        replay_error(uint64_t seq, const std::string& what) : std::runtime_error(what), sequence(seq) {}
+    };
+
+    //dependency graph of a batch of actions, indexes into the batch
+    struct schedule {
+        std::vector<std::vector<uint32_t>> successors;
+        std::vector<uint32_t> dependencies; //count per action
+        uint64_t edges = 0;
+        uint64_t barriers = 0;
+        uint32_t critical_path = 0; //longest chain of dependent actions
+        std::unordered_map<uint32_t, std::vector<scope_payer>> payers; //restored before an action runs, at size() once all ran
+
+        size_t size() const { return dependencies.size(); }
+    };
+
+    inline schedule build_schedule(const std::vector<trace_record>& records, access_map& accesses) {
+        struct row_state {
+            int64_t last_write = -1;
+            std::vector<uint32_t> readers; //since last_write
+        };
+
+        struct scope_state {
+            int64_t last_write = -1; //whole scope
+            std::vector<uint32_t> since_write; //row accesses since last_write
+            std::unordered_map<uint64_t, row_state> rows;
+        };
+
+        schedule s;
+        s.successors.resize(records.size());
+        s.dependencies.resize(records.size());
+        std::vector<uint32_t> depth(records.size());
+
+        std::map<std::pair<uint64_t, uint64_t>, scope_state> scopes; //(table, scope)
+        int64_t last_barrier = -1;
+        std::vector<uint32_t> since_barrier;
+
+        std::vector<access> touched;
+        std::vector<uint32_t> deps;
+        for (uint32_t i = 0; i < records.size(); ++i) {
+            deps.clear();
+            auto add = [&](int64_t d) {
+                if (d >= 0) {
+                    deps.push_back(uint32_t(d));
+                }
+            };
+
+            bool known = accesses.accesses(records[i].act, touched);
+            if (!accesses.payers_before().empty()) {
+                s.payers[i] = accesses.payers_before();
+            }
+
+            if (!known) {
+                //barrier
+                for (auto d : since_barrier) {
+                    add(d);
+                }
+                add(last_barrier);
+                last_barrier = i;
+                since_barrier.clear();
+                scopes.clear();
+                s.barriers += 1;
+            } else {
+                add(last_barrier);
+                since_barrier.push_back(i);
+
+                for (auto& a : touched) {
+                    auto& scope = scopes[{a.table_name.value, a.scope}];
+                    add(scope.last_write);
+
+                    if (a.whole_scope) {
+                        for (auto d : scope.since_write) {
+                            add(d);
+                        }
+                        scope.last_write = i;
+                        scope.since_write.clear();
+                        scope.rows.clear();
+                        continue;
+                    }
+
+                    auto& row = scope.rows[a.primary_key];
+                    add(row.last_write);
+                    if (a.write) {
+                        for (auto d : row.readers) {
+                            add(d);
+                        }
+                        row.last_write = i;
+                        row.readers.clear();
+                    } else {
+                        row.readers.push_back(i);
+                    }
+                    scope.since_write.push_back(i);
+                }
+            }
+
+            std::sort(deps.begin(), deps.end());
+            deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+            if (!deps.empty() && deps.back() == i) {
+                deps.pop_back();
+            }
+
+            for (auto d : deps) {
+                s.successors[d].push_back(i);
+                depth[i] = std::max(depth[i], depth[d]);
+            }
+            depth[i] += 1;
+            s.dependencies[i] = uint32_t(deps.size());
+            s.edges += deps.size();
+            s.critical_path = std::max(s.critical_path, depth[i]);
+        }
+
+        std::vector<scope_payer> last;
+        accesses.settle(last);
+        if (!last.empty()) {
+            s.payers[uint32_t(records.size())] = std::move(last);
+        }
+        return s;
+    }
+
+    class replay_engine {
+
+    public:
+
+        explicit replay_engine(unsigned threads) : worker_count(std::max(1u, threads)) {}
+
+        //executes every record past the mirror's position and advances it, throws replay_error on the first failure
+        schedule run(drealms_mirror::mirror& m, name contract, const std::vector<trace_record>& records) {
+            std::vector<trace_record> pending;
+            for (auto& rec : records) {
+                if (rec.sequence == 0 || rec.sequence > m.position()) {
+                    pending.push_back(rec);
+                }
+            }
+
+            access_map accesses(contract);
+            accesses.learn(m.chain());
+            auto s = build_schedule(pending, accesses);
+            execute(m, contract, pending, s);
+
+            for (auto& rec : pending) {
+                m.advance_to(rec.sequence);
+            }
+            return s;
+        }
+
+    private:
+
+        struct work_queue {
+            std::mutex mutex;
+            std::deque<uint32_t> ready;
+        };
+
+        void execute(drealms_mirror::mirror& m, name contract, const std::vector<trace_record>& records, const schedule& s) {
+            size_t n = records.size();
+            std::unique_ptr<std::atomic<uint32_t>[]> waiting(new std::atomic<uint32_t>[n]);
+            std::vector<work_queue> queues(worker_count);
+
+            //actions with no dependencies are dealt out round robin
+            uint32_t next_queue = 0;
+            for (uint32_t i = 0; i < n; ++i) {
+                waiting[i].store(s.dependencies[i], std::memory_order_relaxed);
+                if (s.dependencies[i] == 0) {
+                    queues[next_queue++ % worker_count].ready.push_back(i);
+                }
+            }
+
+            std::atomic<size_t> completed{0};
+            std::atomic<bool> failed{false};
+            std::mutex error_mutex;
+            std::optional<replay_error> error;
+
+            auto worker = [&](unsigned self_index) {
+                auto& own = queues[self_index];
+                while (completed.load(std::memory_order_acquire) < n && !failed.load(std::memory_order_relaxed)) {
+                    std::optional<uint32_t> next;
+
+                    //newest own work first, it is most likely to touch rows still in cache
+                    {
+                        std::lock_guard<std::mutex> lock(own.mutex);
+                        if (!own.ready.empty()) {
+                            next = own.ready.back();
+                            own.ready.pop_back();
+                        }
+                    }
+
+                    //then the oldest work of the others
+                    for (unsigned k = 1; !next && k < worker_count; ++k) {
+                        auto& victim = queues[(self_index + k) % worker_count];
+                        std::lock_guard<std::mutex> lock(victim.mutex);
+                        if (!victim.ready.empty()) {
+                            next = victim.ready.front();
+                            victim.ready.pop_front();
+                        }
+                    }
+
+                    if (!next) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    try {
+                        restore_payers(m, contract, s, *next);
+                        m.execute(records[*next]);
+                    } catch (const std::exception& e) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error || records[*next].sequence < error->sequence) {
+                            error.emplace(records[*next].sequence, "replay failed at " + std::to_string(records[*next].sequence) + ": " + e.what());
+                        }
+                        failed.store(true);
+                        return;
+                    }
+
+                    for (auto succ : s.successors[*next]) {
+                        if (waiting[succ].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                            std::lock_guard<std::mutex> lock(own.mutex);
+                            own.ready.push_back(succ);
+                        }
+                    }
+                    completed.fetch_add(1, std::memory_order_release);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < worker_count; ++t) {
+                threads.emplace_back(worker, t);
+            }
+            worker(0);
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            if (error) {
+                throw *error;
+            }
+            restore_payers(m, contract, s, uint32_t(n));
+        }
+
+        //bills the scopes the action claims to their payer in trace order
+        void restore_payers(drealms_mirror::mirror& m, name contract, const schedule& s, uint32_t index) {
+            auto payers = s.payers.find(index);
+            if (payers == s.payers.end()) {
+                return;
+            }
+            for (auto& p : payers->second) {
+                auto* t = m.chain().find_table(contract, p.scope, p.table_name);
+                if (t != nullptr && t->payer != p.payer) {
+                    m.chain().set_table_payer(contract, p.scope, p.table_name, p.payer);
+                }
+            }
+        }
+
+        unsigned worker_count;
+    };
+
+}
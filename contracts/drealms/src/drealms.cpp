@@ -1,8 +1,24 @@
 #include <drealms.hpp>
 
-drealms::drealms(name self, name code, datastream<const char*> ds) : contract(self, code, ds) {}
+#ifdef DREALMS_PROFILE
+//count every heap allocation made while an action runs
+void* operator new(size_t size) {
+    drealms_profile::count_allocation(size);
+    return malloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+#endif
+
+drealms::drealms(name self, name code, datastream<const char*> ds) : contract(self, code, ds), tables(self) {
+    drealms_profile::begin();
+}
 
-drealms::~drealms() {}
+drealms::~drealms() {
+    drealms_profile::end();
+}
 
 //======================== realm actions ========================
 
@@ -17,16 +33,96 @@ ACTION drealms::setrealmdata(string drealms_version, name realm_name) {
     vector<name> nfts = {};
     vector<symbol> fts = {};
 
-    //build new realmdata
+    //build new realmdata, keeping the notify mode
     auto new_realmdata = realmdata{
         drealms_version, //drealms_version
         realm_name, //realm_name
         nfts, //nonfungibles
-        fts //fungibles
+        fts, //fungibles
+        realmd.exists() ? realmd.get().notify_mode : binary_extension<name>() //notify_mode
     };
 
     //set new config
     realmd.set(new_realmdata, get_self());
+
+    finish_action();
+}
+
+ACTION drealms::setnotify(name notify_mode) {
+    //authenticate
+    require_auth(get_self());
+
+    //validate
+    check(notify_mode == name("all") || notify_mode == name("subscribed"), "invalid notify mode");
+
+    //open realmdata singleton, get realmdata
+    realmdata_singleton realmd(get_self(), get_self().value);
+    check(realmd.exists(), "realmdata not set");
+    auto rd = realmd.get();
+
+    //set notify mode
+    rd.notify_mode = notify_mode;
+    realmd.set(rd, get_self());
+
+    finish_action();
+}
+
+//======================== notification actions ========================
+
+ACTION drealms::subscribe(name account, vector<name> schemas, vector<symbol_code> currencies) {
+    //authenticate
+    require_auth(account);
+
+    //validate
+    auto& schemas_tbl = tables.open<schemas_table>(get_self().value);
+    for (size_t i = 0; i < schemas.size(); ++i) {
+        schemas_tbl.get(schemas[i].value, "schema not found");
+        for (size_t k = 0; k < i; ++k) {
+            check(schemas[k] != schemas[i], "schema listed twice");
+        }
+    }
+
+    auto& currencies_tbl = tables.open<currencies_table>(get_self().value);
+    for (size_t i = 0; i < currencies.size(); ++i) {
+        currencies_tbl.get(currencies[i].raw(), "currency not found");
+        for (size_t k = 0; k < i; ++k) {
+            check(currencies[k] != currencies[i], "currency listed twice");
+        }
+    }
+
+    //open subscribers table, find subscriber
+    auto& subscribers = tables.open<subscribers_table>(get_self().value);
+    auto sub = subscribers.find(account.value);
+
+    //emplace subscriber if new, replace filters if not
+    if (sub == subscribers.end()) {
+        subscribers.emplace(account, [&](auto& col) {
+            col.account = account;
+            col.schemas = schemas;
+            col.currencies = currencies;
+        });
+    } else {
+        tables.update(subscribers, sub, [&](auto& col) {
+            col.schemas = schemas;
+            col.currencies = currencies;
+        });
+    }
+
+    finish_action();
+}
+
+ACTION drealms::unsubscribe(name account) {
+    //authenticate
+    require_auth(account);
+
+    //open subscribers table, get subscriber
+    auto& subscribers = tables.open<subscribers_table>(get_self().value);
+    auto& sub = subscribers.get(account.value, "subscriber not found");
+
+    //erase subscriber
+    tables.erase(subscribers, sub);
+
+    finish_action();
 }
 
 //======================== schema actions ========================
@@ -37,7 +133,7 @@ ACTION drealms::newnftschema(name new_schema_name, name issuer, uint64_t max_sup
     require_auth(issuer);
 
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto sch = schemas.find(new_schema_name.value);
 
     //validate
@@ -52,6 +148,8 @@ ACTION drealms::newnftschema(name new_schema_name, name issuer, uint64_t max_sup
     initial_settings[name("transferable")] = transferable;
     initial_settings[name("consumable")] = consumable;
     initial_settings[name("activatable")] = activatable;
+    initial_settings[name("logevents")] = false;
+    initial_settings[name("holdings")] = true; //counted from the first mint, older schemas use migrate
 
     //build initial default stats
     map<name, uint32_t> initial_default_stats;
@@ -72,7 +170,7 @@ ACTION drealms::newnftschema(name new_schema_name, name issuer, uint64_t max_sup
     });
 
     //open licenses table, find license
-    licenses_table licenses(get_self(), new_schema_name.value);
+    auto& licenses = tables.open<licenses_table>(new_schema_name.value);
     auto lic = licenses.find(issuer.value);
 
     //build initial uri maps
@@ -90,11 +188,12 @@ ACTION drealms::newnftschema(name new_schema_name, name issuer, uint64_t max_sup
 
     //TODO: add schema_name to realmdata.nonfungibles[]
 
+    finish_action();
 }
 
 ACTION drealms::toggle(name schema_name, name setting_name) {
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -102,20 +201,23 @@ ACTION drealms::toggle(name schema_name, name setting_name) {
 
     //validate
     auto set_itr = sch.settings.find(setting_name);
-    check(set_itr != sch.settings.end(), "setting not found");
+    check(set_itr != sch.settings.end() || setting_name == name("logevents"), "setting not found");
+    check(setting_name != name("holdings"), "holdings setting is managed by migrate");
 
     map<name, bool> new_settings = sch.settings;
     bool toggled_setting = !new_settings[setting_name];
 
     //toggle settings
-    schemas.modify(sch, same_payer, [&](auto& col) {
+    tables.update(schemas, sch, [&](auto& col) {
         col.settings[setting_name] = toggled_setting;
     });
+
+    finish_action();
 }
 
 ACTION drealms::addstat(name schema_name, name stat_name, uint32_t default_value) {
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -126,63 +228,69 @@ ACTION drealms::addstat(name schema_name, name stat_name, uint32_t default_value
     check(stat_itr == sch.default_stats.end(), "stat already exists in schema");
 
     //add stat
-    schemas.modify(sch, same_payer, [&](auto& col) {
+    tables.update(schemas, sch, [&](auto& col) {
         col.default_stats[stat_name] = default_value;
     });
+
+    finish_action();
 }
 
 ACTION drealms::syncstats(name schema_name, uint64_t serial) {
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //TODO: map stats to nft stats (new stats start at default value, existing stats are untouched)
+
+    finish_action();
 }
 
 ACTION drealms::awardexp(name schema_name, name license_owner, uint64_t serial, asset experience) {
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
-    //open license table, search for license
-    licenses_table licenses(get_self(), schema_name.value);
-    auto lic = licenses.find(license_owner.value);
+    //open license table, get license
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
+    auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
-    require_auth(lic->owner);
+    require_auth(lic.owner);
 
     //TODO: award experience points
+
+    //log award event
+    if (get_setting(name("logevents"), sch.settings)) {
+        auto& nfts = tables.open<nfts_table>(schema_name.value);
+        auto nft = nfts.find(serial);
+        log_event(name("award"), schema_name, serial, license_owner, nft == nfts.end() ? name() : nft->owner, experience.amount);
+    }
+
+    finish_action();
 }
 
 ACTION drealms::spendpoint(name schema_name, uint64_t serial, name stat_name) {
     //open schemas table, search for schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open nfts table, get nft
-    nfts_table nfts(get_self(), schema_name.value);
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
     auto& nft = nfts.get(serial, "nft not found");
 
     //authenticate
     require_auth(nft.owner);
 
-    //validate
-    auto stat_itr = nft.stats.find(stat_name);
-    check(stat_itr != nft.stats.end(), "stat name not found");
-    check(nft.unspent >= 1, "nft has no points to spend");
+    spend_point(nfts, nft, stat_name);
 
-    //spend stat point
-    nfts.modify(nft, same_payer, [&](auto& col) {
-        col.stats[stat_name] += uint32_t(1);
-        col.unspent -= 1;
-    });
+    finish_action();
 }
 
 //======================== licensing actions ========================
 
 ACTION drealms::setlicmodel(name schema_name, name new_license_model) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -192,14 +300,16 @@ ACTION drealms::setlicmodel(name schema_name, name new_license_model) {
     check(validate_license_model(new_license_model), "invalid license model");
 
     //modify licensing
-    schemas.modify(sch, same_payer, [&](auto& col) {
+    tables.update(schemas, sch, [&](auto& col) {
         col.license_model = new_license_model;
     });
+
+    finish_action();
 }
 
 ACTION drealms::newlicense(name schema_name, name owner, time_point_sec expiration) {
     //open schemas table, get schmea
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schemas not found");
 
     //intialize defaults
@@ -229,7 +339,7 @@ ACTION drealms::newlicense(name schema_name, name owner, time_point_sec expirati
     }
 
     //open license table, search for license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto lic = licenses.find(owner.value);
 
     if (lic == licenses.end()) {
@@ -247,19 +357,21 @@ ACTION drealms::newlicense(name schema_name, name owner, time_point_sec expirati
         });
     } else {
         //renew existing license
-        licenses.modify(*lic, same_payer, [&](auto& col) {
+        tables.update(licenses, *lic, [&](auto& col) {
             col.expiration = new_expiration;
         });
     }
+
+    finish_action();
 }
 
 ACTION drealms::eraselicense(name schema_name, name license_owner) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open licenses table, get license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //determine if expired
@@ -276,12 +388,14 @@ ACTION drealms::eraselicense(name schema_name, name license_owner) {
     check(expired, "license has not expired");
 
     //erase license slot
-    licenses.erase(lic);
+    tables.erase(licenses, lic);
+
+    finish_action();
 }
 
 ACTION drealms::setlicminmax(name schema_name, uint32_t min_license_length, uint32_t max_license_length) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -292,87 +406,70 @@ ACTION drealms::setlicminmax(name schema_name, uint32_t min_license_length, uint
     check(max_license_length < 31449600, "max liensce length must be less than 1 year");
 
     //modify licensing
-    schemas.modify(sch, same_payer, [&](auto& col) {
+    tables.update(schemas, sch, [&](auto& col) {
         col.min_license_length = min_license_length;
         col.max_license_length = max_license_length;
     });
+
+    finish_action();
 }
 
 ACTION drealms::setalgo(name schema_name, name license_owner, string new_checksum_algo) {
     //open license table, search for license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
     require_auth(lic.owner);
 
     //set new checksum algorithm
-    licenses.modify(lic, same_payer, [&](auto& col) {
+    tables.update(licenses, lic, [&](auto& col) {
         col.checksum_algo = new_checksum_algo;
     });
+
+    finish_action();
 }
 
-ACTION drealms::setati(name schema_name, name license_owner, string new_ati_uri) {
+ACTION drealms::setati(name schema_name, name license_owner, string new_ati_uri, binary_extension<checksum256> ati_hash) {
     //open license table, search for license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
     require_auth(lic.owner);
 
-    //set new ati uri
-    licenses.modify(lic, same_payer, [&](auto& col) {
-        col.full_uris[name("ati")] = new_ati_uri;
+    //set new ati uri, a new uri without a hash unpins the old document
+    tables.update(licenses, lic, [&](auto& col) {
+        col.full_uris[name("ati")] = compress_uri(schema_name, lic.owner, new_ati_uri, false);
+        if (ati_hash.has_value()) {
+            col.ati_hash.emplace(ati_hash.value());
+        } else {
+            col.ati_hash.reset();
+        }
     });
+
+    finish_action();
 }
 
 ACTION drealms::newuri(name schema_name, name license_owner, name uri_group, name uri_name, string new_uri, optional<uint64_t> serial) {
     //open licenses table, get license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
     require_auth(lic.owner);
 
-    //TODO: change to switch statement
-    if (uri_group == name("full")) { //update full uri
-        
-        //update full uri
-        licenses.modify(lic, same_payer, [&](auto& col) {
-            col.full_uris[uri_name] = new_uri;
-        });
-
-    } else if (uri_group == name("base")) { //update base uri
-
-        //update base uri
-        licenses.modify(lic, same_payer, [&](auto& col) {
-            col.base_uris[uri_name] = new_uri;
-        });
-
-    } else if (uri_group == name("relative")) { //update relative uri
-
-        //check for serial
-        if (!serial) {
-            check(false, "must provide serial to update relative uri");
-        }
-
-        //open nfts table, get nft
-        nfts_table nfts(get_self(), schema_name.value);
-        auto& nft = nfts.get(*serial, "nft not found");
+    //open nfts table, relative uris are set on the nft
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
 
-        //update relative uri
-        nfts.modify(nft, same_payer, [&](auto& col) {
-            col.relative_uris[license_owner] = new_uri;
-        });
+    set_uri(licenses, lic, nfts, uri_group, uri_name, new_uri, serial);
 
-    } else { //invalid uri group
-        check(false, "invalid uri group");
-    }
+    finish_action();
 }
 
 ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group, name uri_name, optional<uint64_t> serial) {
     //open licenses table, get license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
@@ -388,7 +485,7 @@ ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group,
         check(full_itr != lic.full_uris.end(), "uri name not found in full uris");
         
         //delete full uri
-        licenses.modify(lic, same_payer, [&](auto& col) {
+        tables.update(licenses, lic, [&](auto& col) {
             col.full_uris.erase(full_itr);
         });
 
@@ -401,7 +498,7 @@ ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group,
         check(base_itr != lic.base_uris.end(), "uri name not found in base uris");
         
         //delete base uri
-        licenses.modify(lic, same_payer, [&](auto& col) {
+        tables.update(licenses, lic, [&](auto& col) {
             col.base_uris.erase(base_itr);
         });
 
@@ -413,7 +510,7 @@ ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group,
         }
 
         //open nfts table, get nft
-        nfts_table nfts(get_self(), schema_name.value);
+        auto& nfts = tables.open<nfts_table>(schema_name.value);
         auto& nft = nfts.get(*serial, "nft not found");
 
         //find uri in uris list
@@ -423,7 +520,7 @@ ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group,
         check(rel_itr != nft.relative_uris.end(), "uri name not found in relative uris");
 
         //update relative uri
-        nfts.modify(nft, same_payer, [&](auto& col) {
+        tables.update(nfts, nft, [&](auto& col) {
             col.relative_uris.erase(rel_itr);
         });
 
@@ -431,13 +528,15 @@ ACTION drealms::deleteuri(name schema_name, name license_owner, name uri_group,
         check(false, "invalid uri group");
     }
 
+
+    finish_action();
 }
 
 //======================== nonfungible actions ========================
 
 ACTION drealms::issuenft(name to, name schema_name, string memo, bool log) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -445,57 +544,19 @@ ACTION drealms::issuenft(name to, name schema_name, string memo, bool log) {
 
     //validate
     check(is_account(to), "to account does not exist");
-    check(sch.supply + 1 <= sch.max_supply, "issuing would breach max supply");
-
-    //open nfts table, get new serial
-    nfts_table nfts(get_self(), schema_name.value);
-    uint64_t new_serial = sch.issued_supply + 1;
-
-    //increment nft supply and issued supply
-    schemas.modify(sch, same_payer, [&](auto& col) {
-        col.issued_supply += uint64_t(1);
-        col.supply += uint64_t(1);
-    });
-
-    //build initial uri and checksum maps
-    map<name, string> new_relative_uris;
-    map<name, string> new_checksums;
-
-    //TODO: calculate next_level formula
-    
-    //build default stats
-    map<name, uint32_t> intitial_stats = sch.default_stats;
-
-    //emplace new NFT
-    nfts.emplace(sch.issuer, [&](auto& col) {
-        col.serial = new_serial;
-        col.owner = to;
-        col.level = uint16_t(1);
-        col.experience = asset(0, sch.exp_symbol);
-        col.next_level = asset(1000, sch.exp_symbol);
-        col.unspent = uint8_t(0);
-        col.stats = intitial_stats;
-        col.relative_uris = new_relative_uris;
-        col.checksums = new_checksums;
-    });
 
-    //inline to lognft if true
-    if (log) {
-        //requires drealms@eosio.code on active perm
-        action(permission_level{get_self(), name("active")}, get_self(), name("lognft"), make_tuple(
-            to, //to
-            schema_name, //schema_name
-            new_serial //serial
-        )).send();
-    }
+    //issuer pays for issued nfts
+    mint_nft(schemas, sch, to, sch.default_stats, sch.issuer, log);
 
     //notify recipient account
-    require_recipient(to);
+    notify(to, schema_name, symbol_code());
+
+    finish_action();
 }
 
 ACTION drealms::retirenft(name schema_name, vector<uint64_t> serials, string memo) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
@@ -506,63 +567,97 @@ ACTION drealms::retirenft(name schema_name, vector<uint64_t> serials, string mem
     check(sch.supply >= serials.size(), "cannot retire supply below 0");
 
     //reduce nft supply
-    schemas.modify(sch, same_payer, [&](auto& col) {
+    tables.update(schemas, sch, [&](auto& col) {
         col.supply -= serials.size();
     });
 
+    //determine if logging
+    bool log = get_setting(name("logevents"), sch.settings);
+
+    //serials below bound are counted in holdings
+    uint64_t bound = holdings_bound(schema_name, sch.settings);
+    uint64_t counted = 0;
+
     //loop over each serial and erase nft
     for (uint64_t serial : serials) {
         //open nfts table, get nft
-        nfts_table nfts(get_self(), schema_name.value);
+        auto& nfts = tables.open<nfts_table>(schema_name.value);
         auto& nft = nfts.get(serial, "nft not found");
 
         //check that issuer owns each nft before retiring
         check(nft.owner == sch.issuer, "only issuer may retire tokens");
 
         //retire nft
-        nfts.erase(nft);
+        tables.erase(nfts, nft);
+        counted += serial < bound ? 1 : 0;
+
+        //log retire event
+        if (log) {
+            log_event(name("retire"), schema_name, serial, sch.issuer, name(0), 0);
+        }
+    }
+
+    //remove retired nfts from issuer's holdings
+    if (counted > 0) {
+        sub_holding(sch.issuer, schema_name, counted);
     }
+
+    finish_action();
 }
 
 ACTION drealms::transfernft(name from, name to, name schema_name, vector<uint64_t> serials, string memo) {
     //authenticate
     require_auth(from);
 
-    //opens schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
-    auto& sch = schemas.get(schema_name.value, "schema not found");
+    //recipient pays for a new holdings row if authorized
+    move_nfts(from, to, schema_name, serials, has_auth(to) ? to : from);
+
+    //notify accounts
+    notify(from, schema_name, symbol_code());
+    notify(to, schema_name, symbol_code());
 
+    finish_action();
+}
+
+ACTION drealms::swapnft(name seller, name buyer, name schema_name, vector<uint64_t> serials, asset price, string memo) {
     //validate
-    check(sch.settings.at(name("transferable")), "nft is not transferable");
-    check(is_account(to), "recipient account does not exist");
+    check(seller != buyer, "cannot swap with self");
+    check(serials.size() > 0, "must swap at least one nft");
+    check(price.is_valid(), "invalid price");
+    check(price.amount > 0, "price must be positive");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
 
-    //loop over each serial and change ownership
-    for (uint64_t serial : serials) {
-        //open nfts table, get nft
-        nfts_table nfts(get_self(), schema_name.value);
-        auto& nft = nfts.get(serial, "nft not found");
+    //authenticate
+    require_auth(seller);
+    require_auth(buyer);
 
-        //validate
-        check(from == nft.owner, "only nft owner is allowed to transfer");
+    //open currencies table, get currency
+    auto& currencies = tables.open<currencies_table>(get_self().value);
+    auto& curr = currencies.get(price.symbol.code().raw(), "currency not found");
 
-        //modify nft ownership to recipient
-        nfts.modify(nft, same_payer, [&](auto& col) {
-            col.owner = to;
-        });
-    }
+    //validate
+    check(curr.transferable, "currency is not transferable");
+    check(price.symbol == curr.supply.symbol, "symbol precision mismatch");
+
+    //settle both legs, each party pays for its own new rows
+    move_nfts(seller, buyer, schema_name, serials, buyer);
+    sub_balance(buyer, price);
+    add_balance(seller, price, seller);
 
     //notify accounts
-    require_recipient(from);
-    require_recipient(to);
+    notify(seller, schema_name, price.symbol.code());
+    notify(buyer, schema_name, price.symbol.code());
+
+    finish_action();
 }
 
 ACTION drealms::consumenft(name schema_name, uint64_t serial, string memo) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open nfts table, get nft
-    nfts_table nfts(get_self(), schema_name.value);
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
     auto& nft = nfts.get(serial, "nft not found");
 
     //authenticate
@@ -571,22 +666,54 @@ ACTION drealms::consumenft(name schema_name, uint64_t serial, string memo) {
     //validate
     check(sch.settings.at(name("consumable")), "nft is not consumable");
 
-    //decrement nft supply
-    schemas.modify(sch, same_payer, [&](auto& col) {
-        col.supply -= uint64_t(1);
-    });
+    consume_nft(schemas, sch, nfts, nft);
 
-    //consume nft
-    nfts.erase(nft);
+    finish_action();
+}
+
+drealms::cleanupview drealms::retirerange(name schema_name, uint64_t first_serial, uint64_t last_serial, uint32_t max_rows, string memo) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+
+    //authenticate
+    require_auth(sch.issuer);
+
+    //validate
+    check(sch.settings.at(name("retirable")), "nft is not retirable");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    auto progress = remove_range(schemas, sch, name("retire"), sch.issuer, first_serial, last_serial, max_rows);
+
+    finish_action();
+    return progress;
+}
+
+drealms::cleanupview drealms::consumerange(name owner, name schema_name, uint64_t first_serial, uint64_t last_serial, uint32_t max_rows, string memo) {
+    //authenticate
+    require_auth(owner);
+
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+
+    //validate
+    check(sch.settings.at(name("consumable")), "nft is not consumable");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    auto progress = remove_range(schemas, sch, name("consume"), owner, first_serial, last_serial, max_rows);
+
+    finish_action();
+    return progress;
 }
 
 ACTION drealms::activatenft(name schema_name, uint64_t serial, string memo) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open nfts table, get nft
-    nfts_table nfts(get_self(), schema_name.value);
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
     auto& nft = nfts.get(serial, "nft not found");
 
     //authenticate
@@ -594,42 +721,41 @@ ACTION drealms::activatenft(name schema_name, uint64_t serial, string memo) {
 
     //validate
     check(sch.settings.at(name("activatable")), "nft is not activatable");
+
+    finish_action();
 }
 
 ACTION drealms::newchecksum(name schema_name, name license_owner, uint64_t serial, string new_checksum) {
     //open schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open licenses table, get license
-    licenses_table licenses(get_self(), schema_name.value);
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
     auto& lic = licenses.get(license_owner.value, "license not found");
 
     //authenticate
     require_auth(lic.owner);
 
     //open nft table, get nft
-    nfts_table nfts(get_self(), schema_name.value);
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
     auto& nft = nfts.get(serial, "nft not found");
 
     //modify nft relative uri
-    nfts.modify(nft, same_payer, [&](auto& col) {
+    tables.update(nfts, nft, [&](auto& col) {
         col.checksums[license_owner] = new_checksum;
     });
-}
 
-ACTION drealms::lognft(name to, name schema_name, uint64_t serial) {
-    //authenticate
-    require_recipient(get_self());
+    finish_action();
 }
 
 ACTION drealms::levelup(name schema_name, uint64_t serial) {
     //opens schemas table, get schema
-    schemas_table schemas(get_self(), get_self().value);
+    auto& schemas = tables.open<schemas_table>(get_self().value);
     auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //open nfts table, get nft
-    nfts_table nfts(get_self(), schema_name.value);
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
     auto& nft = nfts.get(serial, "nft not found");
 
     //authenticate
@@ -642,73 +768,302 @@ ACTION drealms::levelup(name schema_name, uint64_t serial) {
     // check(); //check nft has enought points to level up
 
     //level up nft
-    nfts.modify(nft, same_payer, [&](auto& col) {
+    tables.update(nfts, nft, [&](auto& col) {
         col.level += 1;
         // col.experience -= level_up_cost;
         col.unspent += 1;
     });
+
+    //log level event
+    if (get_setting(name("logevents"), sch.settings)) {
+        log_event(name("level"), schema_name, serial, nft.owner, nft.owner, nft.level);
+    }
+
+    finish_action();
 }
 
-//======================== fungible actions ========================
+vector<drealms::nftview> drealms::viewnfts(name schema_name, name license_owner, vector<uint64_t> serials) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
 
-ACTION drealms::create(name issuer, bool retirable, bool transferable, bool consumable, asset max_supply) {
-    //authenticate
-    require_auth(issuer);
+    //open licenses table, get license
+    auto& licenses = tables.open<licenses_table>(schema_name.value);
+    auto& lic = licenses.get(license_owner.value, "license not found");
 
-    //validate
-    check(max_supply.symbol.is_valid(), "invalid symbol name");
-    check(max_supply.is_valid(), "invalid supply");
-    check(max_supply.amount > 0, "max supply must be positive");
+    //license uris may be stored compressed, expand them once for every nft
+    map<name, string> full_uris;
+    for (auto& full : lic.full_uris) {
+        full_uris[full.first] = expand_uri(schema_name, license_owner, full.second);
+    }
+    map<name, string> base_uris;
+    for (auto& base : lic.base_uris) {
+        base_uris[base.first] = expand_uri(schema_name, license_owner, base.second);
+    }
 
-    //open currencies table, search for currency
-    currencies_table currencies(get_self(), get_self().value);
-    auto existing = currencies.find(max_supply.symbol.code().raw());
+    //open nfts table
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
 
-    //validate
-    check(existing == currencies.end(), "token with symbol already exists" );
+    vector<nftview> views;
+    views.reserve(serials.size());
+    for (auto serial : serials) {
+        auto& nft = nfts.get(serial, "nft not found");
 
-    //TODO: add symbol to realmdata.fungibles[]
+        nftview view{nft.serial, nft.owner, nft.level, nft.experience, nft.next_level, nft.unspent, nft.stats, {}, string()};
 
-    //emplace new currency
-    currencies.emplace(get_self(), [&]( auto& col) {
-       col.issuer = issuer;
-       col.retirable = retirable;
-       col.transferable = transferable;
-       col.consumable = consumable;
-       col.supply = asset(0, max_supply.symbol);
-       col.max_supply = max_supply;
-    });
+        //stats added to the schema since minting start at their default
+        for (auto& s : sch.default_stats) {
+            view.stats.emplace(s.first, s.second);
+        }
+
+        //full uris are complete, base uris are completed by the relative uri the license owner set on the nft
+        view.uris = full_uris;
+        auto rel_itr = nft.relative_uris.find(license_owner);
+        if (rel_itr != nft.relative_uris.end()) {
+            string relative = expand_uri(schema_name, license_owner, rel_itr->second);
+            for (auto& base : base_uris) {
+                view.uris[base.first] = base.second + relative;
+            }
+        }
+
+        auto checksum_itr = nft.checksums.find(license_owner);
+        if (checksum_itr != nft.checksums.end()) {
+            view.checksum = checksum_itr->second;
+        }
+
+        views.push_back(std::move(view));
+    }
+
+    return views;
 }
 
-ACTION drealms::issue(name to, asset quantity, string memo) {
+uint64_t drealms::countnfts(name owner, name schema_name) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+
     //validate
-    check(is_account(to), "to account doesn't exist");
-    check(quantity.symbol.is_valid(), "invalid symbol name");
-    check(memo.size() <= 256, "memo has more than 256 bytes");
-    check(quantity.is_valid(), "invalid quantity");
-    check(quantity.amount > 0, "must issue positive quantity");
+    check(get_setting(name("holdings"), sch.settings), "holdings of schema are not counted yet, run migrate");
 
-    //open currencies table, get currency
-    currencies_table currencies(get_self(), get_self().value);
-    auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
+    //open holdings table, find holding
+    auto& holdings = tables.open<holdings_table>(owner.value);
+    auto hold = holdings.find(schema_name.value);
+
+    return hold == holdings.end() ? 0 : hold->count;
+}
+
+//======================== crafting actions ========================
+
+ACTION drealms::newrecipe(name schema_name, name recipe_name, map<name, uint64_t> inputs, vector<asset> materials,
+    map<name, uint32_t> stats) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
 
     //authenticate
-    require_auth(curr.issuer);
+    require_auth(sch.issuer);
 
     //validate
-    check(quantity.symbol == curr.supply.symbol, "symbol precision mismatch");
-    check(quantity.amount <= curr.max_supply.amount - curr.supply.amount, "issuing quantity would exceed max supply");
+    check(inputs.size() > 0 || materials.size() > 0, "recipe needs at least one input or material");
 
-    //update currency supply
-    currencies.modify(curr, same_payer, [&](auto& col) {
-       col.supply += quantity;
-    });
+    for (auto& in : inputs) {
+        auto& in_sch = schemas.get(in.first.value, "input schema not found");
+        check(in.second > 0, "input count must be positive");
+        check(in_sch.settings.at(name("consumable")), "input nft is not consumable");
+    }
 
-    //update recipient balance
-    add_balance(to, quantity, curr.issuer);
+    auto& currencies = tables.open<currencies_table>(get_self().value);
+    for (size_t i = 0; i < materials.size(); ++i) {
+        auto& curr = currencies.get(materials[i].symbol.code().raw(), "material currency not found");
+        check(curr.consumable, "material currency is not consumable");
+        check(materials[i].symbol == curr.supply.symbol, "material symbol precision mismatch");
+        check(materials[i].amount > 0, "material quantity must be positive");
+        for (size_t k = 0; k < i; ++k) {
+            check(materials[k].symbol != materials[i].symbol, "material listed twice");
+        }
+    }
+
+    for (auto& s : stats) {
+        check(sch.default_stats.find(s.first) != sch.default_stats.end(), "stat not found");
+    }
+
+    //open recipes table, find recipe
+    auto& recipes = tables.open<recipes_table>(schema_name.value);
+    auto rec = recipes.find(recipe_name.value);
+
+    //emplace recipe if new, replace if not
+    if (rec == recipes.end()) {
+        recipes.emplace(sch.issuer, [&](auto& col) {
+            col.recipe_name = recipe_name;
+            col.inputs = inputs;
+            col.materials = materials;
+            col.stats = stats;
+        });
+    } else {
+        tables.update(recipes, rec, [&](auto& col) {
+            col.inputs = inputs;
+            col.materials = materials;
+            col.stats = stats;
+        });
+    }
+
+    finish_action();
+}
+
+ACTION drealms::eraserecipe(name schema_name, name recipe_name) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+
+    //authenticate
+    require_auth(sch.issuer);
+
+    //open recipes table, get recipe
+    auto& recipes = tables.open<recipes_table>(schema_name.value);
+    auto& rec = recipes.get(recipe_name.value, "recipe not found");
+
+    //erase recipe
+    tables.erase(recipes, rec);
+
+    finish_action();
+}
+
+ACTION drealms::craft(name crafter, name schema_name, name recipe_name, map<name, vector<uint64_t>> inputs, string memo) {
+    //authenticate
+    require_auth(crafter);
+
+    //validate
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+
+    //open recipes table, get recipe
+    auto& recipes = tables.open<recipes_table>(schema_name.value);
+    auto& rec = recipes.get(recipe_name.value, "recipe not found");
+
+    //validate
+    check(inputs.size() == rec.inputs.size(), "inputs do not match recipe");
+
+    //open schemas table, shared by the inputs and the crafted nft
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+
+    //consume input nfts
+    for (auto& in : rec.inputs) {
+        auto given = inputs.find(in.first);
+        check(given != inputs.end() && given->second.size() == in.second, "inputs do not match recipe");
+
+        auto& in_sch = schemas.get(in.first.value, "input schema not found");
+        check(in_sch.settings.at(name("consumable")), "input nft is not consumable");
+
+        auto& nfts = tables.open<nfts_table>(in.first.value);
+        for (uint64_t serial : given->second) {
+            auto& nft = nfts.get(serial, "input nft not found");
+            check(nft.owner == crafter, "only nft owner may craft with it");
+            consume_nft(schemas, in_sch, nfts, nft);
+        }
+    }
+
+    //consume materials
+    if (rec.materials.size() > 0) {
+        auto& currencies = tables.open<currencies_table>(get_self().value);
+        for (auto& quantity : rec.materials) {
+            auto& curr = currencies.get(quantity.symbol.code().raw(), "material currency not found");
+            consume_tokens(currencies, curr, crafter, quantity);
+        }
+    }
+
+    //build stats, recipe stats replace defaults
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+    map<name, uint32_t> crafted_stats = sch.default_stats;
+    for (auto& s : rec.stats) {
+        crafted_stats[s.first] = s.second;
+    }
+
+    //crafter pays for the crafted nft
+    mint_nft(schemas, sch, crafter, crafted_stats, crafter, false);
+
+    //notify crafter
+    notify(crafter, schema_name, symbol_code());
+
+    finish_action();
+}
+
+//======================== batch actions ========================
+
+ACTION drealms::batch(vector<batch_op> ops) {
+    //validate
+    check(ops.size() > 0, "batch has no operations");
+
+    //operations share the action's tables, a failed operation reverts the whole batch
+    for (auto& op : ops) {
+        std::visit([&](auto& o) { run_op(o); }, op);
+    }
+
+    finish_action();
+}
+
+//======================== fungible actions ========================
+
+ACTION drealms::create(name issuer, bool retirable, bool transferable, bool consumable, asset max_supply) {
+    //authenticate
+    require_auth(issuer);
+
+    //validate
+    check(max_supply.symbol.is_valid(), "invalid symbol name");
+    check(max_supply.is_valid(), "invalid supply");
+    check(max_supply.amount > 0, "max supply must be positive");
+
+    //open currencies table, search for currency
+    auto& currencies = tables.open<currencies_table>(get_self().value);
+    auto existing = currencies.find(max_supply.symbol.code().raw());
+
+    //validate
+    check(existing == currencies.end(), "token with symbol already exists" );
+
+    //TODO: add symbol to realmdata.fungibles[]
+
+    //emplace new currency
+    currencies.emplace(get_self(), [&]( auto& col) {
+       col.issuer = issuer;
+       col.retirable = retirable;
+       col.transferable = transferable;
+       col.consumable = consumable;
+       col.supply = asset(0, max_supply.symbol);
+       col.max_supply = max_supply;
+    });
+
+    finish_action();
+}
+
+ACTION drealms::issue(name to, asset quantity, string memo) {
+    //validate
+    check(is_account(to), "to account doesn't exist");
+    check(quantity.symbol.is_valid(), "invalid symbol name");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must issue positive quantity");
+
+    //open currencies table, get currency
+    auto& currencies = tables.open<currencies_table>(get_self().value);
+    auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
+
+    //authenticate
+    require_auth(curr.issuer);
+
+    //validate
+    check(quantity.symbol == curr.supply.symbol, "symbol precision mismatch");
+    check(quantity.amount <= curr.max_supply.amount - curr.supply.amount, "issuing quantity would exceed max supply");
+
+    //update currency supply
+    tables.update(currencies, curr, [&](auto& col) {
+       col.supply += quantity;
+    });
+
+    //update recipient balance
+    add_balance(to, quantity, curr.issuer);
 
     //notify recipient account
-    require_recipient(to);
+    notify(to, name(), quantity.symbol.code());
+
+    finish_action();
 }
 
 ACTION drealms::retire(asset quantity, string memo) {
@@ -719,7 +1074,7 @@ ACTION drealms::retire(asset quantity, string memo) {
     check(memo.size() <= 256, "memo has more than 256 bytes");
 
     //open currencies table, 
-    currencies_table currencies(get_self(), get_self().value);
+    auto& currencies = tables.open<currencies_table>(get_self().value);
     auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
 
     //authenticate
@@ -731,12 +1086,14 @@ ACTION drealms::retire(asset quantity, string memo) {
     check(quantity <= curr.supply, "cannot retire supply below zero");
 
     //update currencies table
-    currencies.modify(curr, same_payer, [&](auto& col) {
+    tables.update(currencies, curr, [&](auto& col) {
        col.supply -= quantity;
     });
 
     //remove quantity from issuer
     sub_balance(curr.issuer, quantity);
+
+    finish_action();
 }
 
 ACTION drealms::transfer(name from, name to, asset quantity, string memo) {
@@ -751,7 +1108,7 @@ ACTION drealms::transfer(name from, name to, asset quantity, string memo) {
     require_auth(from);
 
     //open currencies table
-    currencies_table currencies(get_self(), get_self().value);
+    auto& currencies = tables.open<currencies_table>(get_self().value);
     auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
 
     //validate
@@ -765,34 +1122,26 @@ ACTION drealms::transfer(name from, name to, asset quantity, string memo) {
     add_balance(to, quantity, payer);
 
     //notify from and to accounts
-    require_recipient(from);
-    require_recipient(to);
+    notify(from, name(), quantity.symbol.code());
+    notify(to, name(), quantity.symbol.code());
+
+    finish_action();
 }
 
 ACTION drealms::consume(name owner, asset quantity, string memo) {
     //authenticate
     require_auth(owner);
 
-    //open currencies table, get currency
-    currencies_table currencies(get_self(), get_self().value);
-    auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
-
     //validate
-    check(curr.consumable, "currency is not consumable");
-    check(quantity.symbol == curr.supply.symbol, "symbol precision mismatch");
-    check(quantity <= curr.supply, "cannot consume supply below zero");
-    check(quantity.symbol.is_valid(), "invalid symbol name");
-    check(quantity.is_valid(), "invalid quantity");
-    check(quantity.amount > 0, "must consume positive quantity");
     check(memo.size() <= 256, "memo has more than 256 bytes");
 
-    //update currencies table
-    currencies.modify(curr, same_payer, [&](auto& col) {
-       col.supply -= quantity;
-    });
+    //open currencies table, get currency
+    auto& currencies = tables.open<currencies_table>(get_self().value);
+    auto& curr = currencies.get(quantity.symbol.code().raw(), "currency not found");
 
-    //remove quantity from owner
-    sub_balance(owner, quantity);
+    consume_tokens(currencies, curr, owner, quantity);
+
+    finish_action();
 }
 
 ACTION drealms::open(name owner, symbol currency_symbol, name ram_payer) {
@@ -803,11 +1152,11 @@ ACTION drealms::open(name owner, symbol currency_symbol, name ram_payer) {
     check(is_account(owner), "owner account does not exist");
 
     //open currencies table, get currency
-    currencies_table currencies(get_self(), get_self().value);
+    auto& currencies = tables.open<currencies_table>(get_self().value);
     auto& curr = currencies.get(currency_symbol.code().raw(), "open: currency not found");
 
     //open accounts table, search for account
-    accounts_table accounts(get_self(), owner.value);
+    auto& accounts = tables.open<accounts_table>(owner.value);
     auto acct = accounts.find(currency_symbol.code().raw());
 
     //validate
@@ -818,6 +1167,8 @@ ACTION drealms::open(name owner, symbol currency_symbol, name ram_payer) {
     accounts.emplace(ram_payer, [&](auto& col){
         col.balance = asset(0, currency_symbol);
     });
+
+    finish_action();
 }
 
 ACTION drealms::close(name owner, symbol currency_symbol) {
@@ -825,14 +1176,107 @@ ACTION drealms::close(name owner, symbol currency_symbol) {
     require_auth(owner);
 
     //open accounts table, get account
-    accounts_table accounts(get_self(), owner.value);
+    auto& accounts = tables.open<accounts_table>(owner.value);
     auto& acct = accounts.get(currency_symbol.code().raw(), "close: account not found");
 
     //validate
     check(acct.balance.amount == 0, "cannot close account unless balance is zero" );
 
     //close account
-    accounts.erase(acct);
+    tables.erase(accounts, acct);
+
+    finish_action();
+}
+
+//======================== migration actions ========================
+
+ACTION drealms::migrate(name table_name, name scope, uint32_t max_rows) {
+    //validate
+    check(max_rows > 0, "max rows must be a positive number");
+
+    //open migrations table, search for migration
+    auto& migrations = tables.open<migrations_table>(table_name.value);
+    auto mig = migrations.find(scope.value);
+
+    //initialize cursor, a migration to an older version starts over
+    uint8_t target_version = table_name == name("nfts") ? nonfungible::current_version : 1;
+    bool restart = mig != migrations.end() && mig->target() < target_version;
+    uint64_t cursor = 0;
+    uint64_t next_cursor = 0;
+    uint32_t converted = 0;
+    name ram_payer = get_self();
+
+    if (mig != migrations.end() && !restart) {
+        check(!mig->complete, "migration already complete");
+        cursor = mig->cursor;
+    }
+
+    switch (table_name.value)
+    {
+        case name("nfts").value : {
+            //open schemas table, get schema
+            auto& schemas = tables.open<schemas_table>(get_self().value);
+            auto& sch = schemas.get(scope.value, "schema not found");
+
+            //authenticate
+            require_auth(sch.issuer);
+            ram_payer = sch.issuer;
+
+            converted = migrate_nfts(scope, cursor, max_rows, next_cursor);
+            break;
+        }
+        case name("holdings").value : {
+            //open schemas table, get schema
+            auto& schemas = tables.open<schemas_table>(get_self().value);
+            auto& sch = schemas.get(scope.value, "schema not found");
+
+            //authenticate
+            require_auth(sch.issuer);
+            ram_payer = sch.issuer;
+
+            //validate
+            check(!get_setting(name("holdings"), sch.settings), "holdings of schema are already counted");
+
+            converted = count_holdings(scope, sch.issuer, cursor, max_rows, next_cursor);
+
+            //every nft is counted, later writes keep holdings current
+            if (next_cursor == 0) {
+                tables.update(schemas, sch, [&](auto& col) {
+                    col.settings[name("holdings")] = true;
+                });
+            }
+            break;
+        }
+        default:
+            check(false, "no migration for table");
+    }
+
+    //save cursor, next_cursor of 0 marks the end of the table
+    if (mig == migrations.end()) {
+        migrations.emplace(ram_payer, [&](auto& col) {
+            col.scope = scope;
+            col.cursor = next_cursor;
+            col.migrated = converted;
+            col.complete = next_cursor == 0;
+            col.target_version = target_version;
+        });
+    } else {
+        tables.update(migrations, *mig, [&](auto& col) {
+            col.cursor = next_cursor;
+            col.migrated = restart ? converted : col.migrated + converted;
+            col.complete = next_cursor == 0;
+            col.target_version = target_version;
+        });
+    }
+
+    finish_action();
+}
+
+//======================== event log ========================
+
+ACTION drealms::logevents(vector<nftevent> events) {
+    //authenticate
+    require_auth(get_self());
 }
 
 //========== helper functions ==========
@@ -871,9 +1315,257 @@ bool drealms::validate_uri_group(name uri_group) {
     return true;
 }
 
+bool drealms::get_setting(name setting_name, const map<name, bool>& settings) {
+    //missing settings are treated as disabled
+    auto set_itr = settings.find(setting_name);
+    return set_itr != settings.end() && set_itr->second;
+}
+
+void drealms::log_event(name event_name, name schema_name, uint64_t serial, name from, name to, int64_t value) {
+    //collect event, emitted in a single logevents action by finish_action
+    pending_events.push_back(nftevent{
+        event_name, //event_name
+        schema_name, //schema_name
+        serial, //serial
+        from, //from
+        to, //to
+        value //value
+    });
+}
+
+uint32_t drealms::migrate_nfts(name schema_name, uint64_t cursor, uint32_t max_rows, uint64_t& next_cursor) {
+    //open nfts table, seek to cursor
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
+    auto nft_itr = nfts.lower_bound(cursor);
+
+    uint32_t scanned = 0;
+    uint32_t converted = 0;
+
+    //rewrite old rows in place, modify always serializes the current layout
+    while (nft_itr != nfts.end() && scanned < max_rows) {
+        if (nft_itr->row_version() < nonfungible::current_version) {
+            nfts.modify(nft_itr, same_payer, [&](auto& col) {});
+            converted += 1;
+        }
+
+        scanned += 1;
+        nft_itr++;
+    }
+
+    //save next serial to visit, or 0 if finished
+    next_cursor = nft_itr == nfts.end() ? 0 : nft_itr->serial;
+
+    return converted;
+}
+
+void drealms::move_nfts(name from, name to, name schema_name, const vector<uint64_t>& serials, name ram_payer) {
+    //opens schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    auto& sch = schemas.get(schema_name.value, "schema not found");
+
+    //open nfts table
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
+
+    move_nfts(sch, nfts, from, to, serials, ram_payer);
+}
+
+uint32_t drealms::count_holdings(name schema_name, name ram_payer, uint64_t cursor, uint32_t max_rows, uint64_t& next_cursor) {
+    //open nfts table, seek to cursor
+    auto& nfts = tables.open<nfts_table>(schema_name.value);
+    auto nft_itr = nfts.lower_bound(cursor);
+
+    //tally owners of the next rows
+    map<name, uint64_t> counts;
+    uint32_t scanned = 0;
+    while (nft_itr != nfts.end() && scanned < max_rows) {
+        counts[nft_itr->owner] += 1;
+        scanned += 1;
+        nft_itr++;
+    }
+
+    for (auto& c : counts) {
+        add_holding(c.first, schema_name, c.second, ram_payer);
+    }
+
+    //save next serial to visit, or 0 if finished
+    next_cursor = nft_itr == nfts.end() ? 0 : nft_itr->serial;
+
+    return scanned;
+}
+
+uint64_t drealms::holdings_bound(name schema_name, const map<name, bool>& settings) {
+    //every serial is counted
+    if (get_setting(name("holdings"), settings)) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    //serials below the cursor of a running holdings migration are counted, none before it starts
+    auto& migrations = tables.open<migrations_table>(name("holdings").value);
+    auto mig = migrations.find(schema_name.value);
+    return mig == migrations.end() ? 0 : mig->cursor;
+}
+
+void drealms::add_holding(name owner, name schema_name, uint64_t count, name ram_payer) {
+    //open holdings table, search for holding
+    auto& holdings = tables.open<holdings_table>(owner.value);
+    auto hold = holdings.find(schema_name.value);
+
+    //if new holding pay ram, update count if not
+    if (hold == holdings.end()) {
+        holdings.emplace(ram_payer, [&](auto& col) {
+            col.schema_name = schema_name;
+            col.count = count;
+        });
+    } else {
+        tables.update(holdings, hold, [&](auto& col) {
+            col.count += count;
+        });
+    }
+}
+
+void drealms::sub_holding(name owner, name schema_name, uint64_t count) {
+    //open holdings table, get holding
+    auto& holdings = tables.open<holdings_table>(owner.value);
+    auto& hold = holdings.get(schema_name.value, "sub_holding: holding not found");
+
+    //validate
+    check(hold.count >= count, "sub_holding: holding below zero");
+
+    //erase emptied holding to refund ram, update count if not
+    if (hold.count == count) {
+        tables.erase(holdings, hold);
+    } else {
+        tables.update(holdings, hold, [&](auto& col) {
+            col.count -= count;
+        });
+    }
+}
+
+void drealms::notify(name account, name schema_name, symbol_code currency) {
+    //read realm notify mode once per action
+    if (realm_notify_mode == name()) {
+        realmdata_singleton realmd(get_self(), get_self().value);
+        realm_notify_mode = realmd.exists() ? realmd.get().notify_mode.value_or(name("all")) : name("all");
+    }
+
+    //notify every party
+    if (realm_notify_mode == name("all")) {
+        require_recipient(account);
+        return;
+    }
+
+    //open subscribers table, find subscriber
+    auto& subscribers = tables.open<subscribers_table>(get_self().value);
+    auto sub = subscribers.find(account.value);
+
+    //skip accounts that did not subscribe
+    if (sub == subscribers.end()) {
+        return;
+    }
+
+    //notify if subscribed to everything, the schema or the currency
+    bool everything = sub->schemas.empty() && sub->currencies.empty();
+    bool schema_match = schema_name != name() && std::find(sub->schemas.begin(), sub->schemas.end(), schema_name) != sub->schemas.end();
+    bool currency_match = currency != symbol_code() && std::find(sub->currencies.begin(), sub->currencies.end(), currency) != sub->currencies.end();
+    if (everything || schema_match || currency_match) {
+        require_recipient(account);
+    }
+}
+
+void drealms::require_auth_once(name account) {
+    //skip accounts already authorized by the current action
+    if (authorized_accounts.insert(account).second) {
+        require_auth(account);
+    }
+}
+
+void drealms::finish_action() {
+    //write rows updated during the action once, called from the action body
+    //so a failed write aborts the action instead of throwing from the destructor
+    tables.flush();
+
+    //emit all events collected during the action as one inline action
+    if (!pending_events.empty()) {
+        //requires drealms@eosio.code on active perm
+        action(permission_level{get_self(), name("active")}, get_self(), name("logevents"), make_tuple(
+            pending_events //events
+        )).send();
+        pending_events.clear();
+    }
+}
+
+string drealms::compress_uri(name schema_name, name owner, const string& uri, bool add_prefix) {
+    //validate
+    check(uri.empty() || uri[0] != uriprefix::open, "uri cannot start with {");
+
+    //the prefix is everything up to the last slash
+    size_t length = uri.rfind('/') + 1;
+    if (length < uriprefix::min_length) {
+        return uri;
+    }
+
+    //open uriprefixes table, search for the license owner's prefixes
+    auto& dictionaries = tables.open<uriprefixes_table>(schema_name.value);
+    auto dict = dictionaries.find(owner.value);
+
+    //find prefix
+    size_t index = 0;
+    if (dict != dictionaries.end()) {
+        for (; index < dict->prefixes.size(); ++index) {
+            auto& prefix = dict->prefixes[index];
+            if (prefix.size() == length && uri.compare(0, length, prefix) == 0) {
+                break;
+            }
+        }
+    }
+
+    //add prefix if not found, store the whole uri if it cannot be added
+    if (dict == dictionaries.end()) {
+        if (!add_prefix) {
+            return uri;
+        }
+        dictionaries.emplace(owner, [&](auto& col) {
+            col.owner = owner;
+            col.prefixes.push_back(uri.substr(0, length));
+        });
+    } else if (index == dict->prefixes.size()) {
+        if (!add_prefix || index >= uriprefix::max_prefixes) {
+            return uri;
+        }
+        tables.update(dictionaries, dict, [&](auto& col) {
+            col.prefixes.push_back(uri.substr(0, length));
+        });
+    }
+
+    string stored;
+    stored += uriprefix::open;
+    stored += std::to_string(index);
+    stored += uriprefix::close;
+    stored.append(uri, length, string::npos);
+    return stored;
+}
+
+string drealms::expand_uri(name schema_name, name owner, const string& stored) {
+    //uncompressed uris are stored whole
+    size_t index;
+    size_t length = uriprefix::reference(stored, index);
+    if (length == 0) {
+        return stored;
+    }
+
+    //open uriprefixes table, get the license owner's prefixes
+    auto& dictionaries = tables.open<uriprefixes_table>(schema_name.value);
+    auto& dict = dictionaries.get(owner.value, "uri prefixes not found");
+
+    //validate
+    check(index < dict.prefixes.size(), "uri prefix not found");
+
+    return dict.prefixes[index] + stored.substr(length);
+}
+
 void drealms::add_balance(name to, asset quantity, name ram_payer) {
     //open accounts table, search for account
-    accounts_table to_accts(get_self(), to.value);
+    auto& to_accts = tables.open<accounts_table>(to.value);
     auto to_acct = to_accts.find(quantity.symbol.code().raw());
 
     //if new account pay ram, update balance if not
@@ -882,7 +1574,7 @@ void drealms::add_balance(name to, asset quantity, name ram_payer) {
             col.balance = quantity;
         });
     } else {
-        to_accts.modify(to_acct, same_payer, [&](auto& col) {
+        tables.update(to_accts, to_acct, [&](auto& col) {
             col.balance += quantity;
         });
     }
@@ -890,7 +1582,7 @@ void drealms::add_balance(name to, asset quantity, name ram_payer) {
 
 void drealms::sub_balance(name from, asset quantity) {
     //open accounts table, get account
-    accounts_table from_accts(get_self(), from.value);
+    auto& from_accts = tables.open<accounts_table>(from.value);
     auto& from_acct = from_accts.get(quantity.symbol.code().raw(), "sub_balance: account not found");
 
     //validate
@@ -901,4 +1593,328 @@ void drealms::sub_balance(name from, asset quantity) {
         col.balance -= quantity;
     });
 }
-                                                                                                            
\ No newline at end of file
+
+//========== table helpers ==========
+
+uint64_t drealms::mint_nft(schemas_table& schemas, const schema& sch, name to, const map<name, uint32_t>& stats, name ram_payer, bool log) {
+    //validate
+    check(sch.supply + 1 <= sch.max_supply, "issuing would breach max supply");
+
+    //open nfts table, get new serial
+    auto& nfts = tables.open<nfts_table>(sch.schema_name.value);
+    uint64_t new_serial = sch.issued_supply + 1;
+
+    //increment nft supply and issued supply
+    tables.update(schemas, sch, [&](auto& col) {
+        col.issued_supply += uint64_t(1);
+        col.supply += uint64_t(1);
+    });
+
+    //build initial uri and checksum maps
+    map<name, string> new_relative_uris;
+    map<name, string> new_checksums;
+
+    //TODO: calculate next_level formula
+
+    //emplace new NFT
+    nfts.emplace(ram_payer, [&](auto& col) {
+        col.serial = new_serial;
+        col.owner = to;
+        col.level = uint16_t(1);
+        col.experience = asset(0, sch.exp_symbol);
+        col.next_level = asset(1000, sch.exp_symbol);
+        col.unspent = uint8_t(0);
+        col.stats = stats;
+        col.relative_uris = new_relative_uris;
+        col.checksums = new_checksums;
+    });
+
+    //count new nft in recipient's holdings
+    if (new_serial < holdings_bound(sch.schema_name, sch.settings)) {
+        add_holding(to, sch.schema_name, 1, ram_payer);
+    }
+
+    //log mint event if requested or enabled on schema
+    if (log || get_setting(name("logevents"), sch.settings)) {
+        log_event(name("mint"), sch.schema_name, new_serial, sch.issuer, to, 0);
+    }
+
+    return new_serial;
+}
+
+void drealms::consume_nft(schemas_table& schemas, const schema& sch, nfts_table& nfts, const nonfungible& nft) {
+    //decrement nft supply
+    tables.update(schemas, sch, [&](auto& col) {
+        col.supply -= uint64_t(1);
+    });
+
+    //log consume event
+    if (get_setting(name("logevents"), sch.settings)) {
+        log_event(name("consume"), sch.schema_name, nft.serial, nft.owner, name(0), 0);
+    }
+
+    //remove nft from owner's holdings
+    if (nft.serial < holdings_bound(sch.schema_name, sch.settings)) {
+        sub_holding(nft.owner, sch.schema_name, 1);
+    }
+
+    //consume nft
+    tables.erase(nfts, nft);
+}
+
+void drealms::consume_tokens(currencies_table& currencies, const currency& curr, name owner, asset quantity) {
+    //validate
+    check(curr.consumable, "currency is not consumable");
+    check(quantity.symbol == curr.supply.symbol, "symbol precision mismatch");
+    check(quantity <= curr.supply, "cannot consume supply below zero");
+    check(quantity.symbol.is_valid(), "invalid symbol name");
+    check(quantity.is_valid(), "invalid quantity");
+    check(quantity.amount > 0, "must consume positive quantity");
+
+    //update currencies table
+    tables.update(currencies, curr, [&](auto& col) {
+       col.supply -= quantity;
+    });
+
+    //remove quantity from owner
+    sub_balance(owner, quantity);
+}
+
+drealms::cleanupview drealms::remove_range(schemas_table& schemas, const schema& sch, name kind, name owner,
+    uint64_t first_serial, uint64_t last_serial, uint32_t max_rows) {
+    //validate
+    check(max_rows > 0, "max rows must be a positive number");
+    check(first_serial <= last_serial, "first serial is after last serial");
+
+    //open cleanups table, resume the same cleanup or start over
+    auto& cleanups = tables.open<cleanups_table>(sch.schema_name.value);
+    auto cln = cleanups.find(owner.value);
+    bool resume = cln != cleanups.end() && cln->kind == kind && cln->first_serial == first_serial && cln->last_serial == last_serial;
+    uint64_t cursor = resume ? cln->cursor : first_serial;
+    uint64_t removed_before = resume ? cln->removed : 0;
+
+    //determine if logging
+    bool log = get_setting(name("logevents"), sch.settings);
+
+    //serials below bound are counted in holdings
+    uint64_t bound = holdings_bound(sch.schema_name, sch.settings);
+    uint64_t counted = 0;
+
+    //visit up to max_rows nfts, removing those held by owner
+    auto& nfts = tables.open<nfts_table>(sch.schema_name.value);
+    auto nft_itr = nfts.lower_bound(cursor);
+    uint32_t visited = 0;
+    uint64_t removed = 0;
+    while (nft_itr != nfts.end() && nft_itr->serial <= last_serial && visited < max_rows) {
+        visited += 1;
+        if (nft_itr->owner != owner) {
+            nft_itr++;
+            continue;
+        }
+
+        //log retire or consume event
+        if (log) {
+            log_event(kind, sch.schema_name, nft_itr->serial, owner, name(0), 0);
+        }
+
+        counted += nft_itr->serial < bound ? 1 : 0;
+        removed += 1;
+        nft_itr = tables.erase(nfts, nft_itr);
+    }
+
+    bool complete = nft_itr == nfts.end() || nft_itr->serial > last_serial;
+    uint64_t next_serial = complete ? 0 : nft_itr->serial;
+
+    //reduce nft supply and owner's holdings once per call
+    if (removed > 0) {
+        tables.update(schemas, sch, [&](auto& col) {
+            col.supply -= removed;
+        });
+    }
+    if (counted > 0) {
+        sub_holding(owner, sch.schema_name, counted);
+    }
+
+    //save cursor until complete, owner pays for it
+    if (complete) {
+        if (cln != cleanups.end()) {
+            tables.erase(cleanups, cln);
+        }
+    } else if (cln == cleanups.end()) {
+        cleanups.emplace(owner, [&](auto& col) {
+            col.owner = owner;
+            col.kind = kind;
+            col.first_serial = first_serial;
+            col.last_serial = last_serial;
+            col.cursor = next_serial;
+            col.removed = removed;
+        });
+    } else {
+        tables.update(cleanups, cln, [&](auto& col) {
+            col.kind = kind;
+            col.first_serial = first_serial;
+            col.last_serial = last_serial;
+            col.cursor = next_serial;
+            col.removed = removed_before + removed;
+        });
+    }
+
+    return cleanupview{removed, removed_before + removed, next_serial, complete};
+}
+
+void drealms::move_nfts(const schema& sch, nfts_table& nfts, name from, name to, const vector<uint64_t>& serials, name ram_payer) {
+    //validate
+    check(sch.settings.at(name("transferable")), "nft is not transferable");
+    check(is_account(to), "recipient account does not exist");
+
+    //determine if logging
+    bool log = get_setting(name("logevents"), sch.settings);
+
+    //serials below bound are counted in holdings
+    uint64_t bound = holdings_bound(sch.schema_name, sch.settings);
+    uint64_t moved = 0;
+
+    //loop over each serial and change ownership
+    for (uint64_t serial : serials) {
+        //get nft
+        auto& nft = nfts.get(serial, "nft not found");
+
+        //validate
+        check(from == nft.owner, "only nft owner is allowed to transfer");
+
+        //modify nft ownership to recipient
+        tables.update(nfts, nft, [&](auto& col) {
+            col.owner = to;
+        });
+        moved += serial < bound ? 1 : 0;
+
+        //log transfer event
+        if (log) {
+            log_event(name("transfer"), sch.schema_name, serial, from, to, 0);
+        }
+    }
+
+    //move holdings
+    if (moved > 0) {
+        sub_holding(from, sch.schema_name, moved);
+        add_holding(to, sch.schema_name, moved, ram_payer);
+    }
+}
+
+void drealms::set_uri(licenses_table& licenses, const license& lic, nfts_table& nfts, name uri_group, name uri_name,
+    const string& new_uri, optional<uint64_t> serial) {
+    name schema_name(licenses.get_scope());
+
+    //license uris are few per license, so they reuse prefixes their nfts added rather than adding their own
+    if (uri_group == name("full")) { //update full uri
+        
+        //update full uri
+        string stored = compress_uri(schema_name, lic.owner, new_uri, false);
+        tables.update(licenses, lic, [&](auto& col) {
+            col.full_uris[uri_name] = stored;
+        });
+
+    } else if (uri_group == name("base")) { //update base uri
+
+        //update base uri
+        string stored = compress_uri(schema_name, lic.owner, new_uri, false);
+        tables.update(licenses, lic, [&](auto& col) {
+            col.base_uris[uri_name] = stored;
+        });
+
+    } else if (uri_group == name("relative")) { //update relative uri
+
+        //check for serial
+        if (!serial) {
+            check(false, "must provide serial to update relative uri");
+        }
+
+        //get nft
+        auto& nft = nfts.get(*serial, "nft not found");
+
+        //update relative uri
+        string stored = compress_uri(schema_name, lic.owner, new_uri, true);
+        tables.update(nfts, nft, [&](auto& col) {
+            col.relative_uris[lic.owner] = stored;
+        });
+
+    } else { //invalid uri group
+        check(false, "invalid uri group");
+    }
+}
+
+void drealms::spend_point(nfts_table& nfts, const nonfungible& nft, name stat_name) {
+    //validate
+    auto stat_itr = nft.stats.find(stat_name);
+    check(stat_itr != nft.stats.end(), "stat name not found");
+    check(nft.unspent >= 1, "nft has no points to spend");
+
+    //spend stat point
+    tables.update(nfts, nft, [&](auto& col) {
+        col.stats[stat_name] += uint32_t(1);
+        col.unspent -= 1;
+    });
+}
+
+void drealms::run_op(const newuri_op& op) {
+    //open licenses table, get license
+    auto& licenses = tables.open<licenses_table>(op.schema_name.value);
+    auto& lic = licenses.get(op.license_owner.value, "license not found");
+
+    //authenticate
+    require_auth_once(lic.owner);
+
+    //open nfts table, relative uris are set on the nft
+    auto& nfts = tables.open<nfts_table>(op.schema_name.value);
+
+    set_uri(licenses, lic, nfts, op.uri_group, op.uri_name, op.new_uri, op.serial);
+}
+
+void drealms::run_op(const newchecksum_op& op) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    schemas.get(op.schema_name.value, "schema not found");
+
+    //open licenses table, get license
+    auto& licenses = tables.open<licenses_table>(op.schema_name.value);
+    auto& lic = licenses.get(op.license_owner.value, "license not found");
+
+    //authenticate
+    require_auth_once(lic.owner);
+
+    //open nfts table, get nft
+    auto& nfts = tables.open<nfts_table>(op.schema_name.value);
+    auto& nft = nfts.get(op.serial, "nft not found");
+
+    //modify nft checksum
+    tables.update(nfts, nft, [&](auto& col) {
+        col.checksums[op.license_owner] = op.new_checksum;
+    });
+}
+
+void drealms::run_op(const transfernft_op& op) {
+    //authenticate
+    require_auth_once(op.from);
+
+    //recipient pays for a new holdings row if authorized
+    move_nfts(op.from, op.to, op.schema_name, op.serials, has_auth(op.to) ? op.to : op.from);
+
+    //notify accounts
+    notify(op.from, op.schema_name, symbol_code());
+    notify(op.to, op.schema_name, symbol_code());
+}
+
+void drealms::run_op(const spendpoint_op& op) {
+    //open schemas table, get schema
+    auto& schemas = tables.open<schemas_table>(get_self().value);
+    schemas.get(op.schema_name.value, "schema not found");
+
+    //open nfts table, get nft
+    auto& nfts = tables.open<nfts_table>(op.schema_name.value);
+    auto& nft = nfts.get(op.serial, "nft not found");
+
+    //authenticate
+    require_auth_once(nft.owner);
+
+    spend_point(nfts, nft, op.stat_name);
+}
@@ -0,0 +1,405 @@
+#! /bin/bash
+
+# Billed CPU, NET and RAM of every action on a local single producer node.
+#
+# ./localnet.sh drealms run [build_dir] [results.csv]
+#     boots a fresh node, deploys build_dir (default ./build/drealms, the output of build.sh), builds a
+#     realm of NFTS nfts, pushes every action RUNS times and records the receipt of each push
+#
+# ./localnet.sh drealms compare base.csv candidate.csv
+#     median cost per action of two runs side by side
+#
+# NFTS       - nfts issued before measuring (default 1000)
+# RUNS       - pushes per action (default 5)
+# NODEOS     - nodeos binary (default nodeos)
+# CLEOS      - cleos binary (default cleos)
+# KEOSD      - keosd binary (default keosd)
+# BOOT_DIR   - directory holding eosio.boot.wasm and eosio.boot.abi from the reference contracts (default ./build/eosio.boot)
+#
+# The node schedules PREACTIVATE_FEATURE, deploys eosio.boot and activates ACTION_RETURN_VALUE, which the range,
+# view and count actions need, plus the newer features mainnets run (see features below) before drealms is deployed.
+#
+# needs jq and curl. Every push is sent with --force-unique so repeated identical actions are not rejected as duplicates,
+# which adds the same few NET bytes to every row of both builds.
+
+if [[ "$1" == "drealms" ]]; then
+    contract=drealms
+    account=realmaccount
+else
+    echo "need contract"
+    exit 0
+fi
+
+#same node as the local stage of deploy.sh
+url=http://127.0.0.1:8888
+wallet_url=http://127.0.0.1:8899
+
+#default development key of a fresh nodeos genesis
+pub=EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV
+priv=5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3
+
+nfts=${NFTS:-1000}
+runs=${RUNS:-5}
+nodeos=${NODEOS:-nodeos}
+cleos=${CLEOS:-cleos}
+keosd=${KEOSD:-keosd}
+boot_dir=${BOOT_DIR:-./build/eosio.boot}
+
+#activated by boot(), the required ones must be supported by nodeos
+required_features="ACTION_RETURN_VALUE"
+optional_features="WTMSIG_BLOCK_SIGNATURES CONFIGURABLE_WASM_LIMITS2"
+
+work="./build/$contract/localnet"
+
+cl() {
+    $cleos -u $url --wallet-url $wallet_url "$@"
+}
+
+# name made of a prefix and i in base26 letters, like indexed_name() in bench/fixture.hpp
+indexed_name() {
+    local prefix=$1 i=$2 letters=""
+    local alphabet=abcdefghijklmnopqrstuvwxyz
+    while true; do
+        letters="${alphabet:$((i % 26)):1}$letters"
+        i=$((i / 26))
+        [[ $i -eq 0 ]] && break
+    done
+    echo "$prefix.$letters"
+}
+
+# uppercase symbol code for i, like indexed_code() in bench/fixture.hpp
+indexed_code() {
+    indexed_name C $1 | tr -d . | tr a-z A-Z
+}
+
+median() {
+    sort -n | awk '{ v[NR] = $1 } END { if (NR == 0) print "-"; else if (NR % 2) print v[(NR + 1) / 2]; else print (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+# median of one column ($3 cpu, $4 net, $5 ram) for one label of a results file
+column_median() {
+    awk -F, -v label="$2" -v col=$3 'FNR > 1 && $1 == label && $col != "" { print $col }' $1 | median
+}
+
+labels() {
+    awk -F, 'FNR > 1 && !seen[$1]++ { print $1 }' "$@"
+}
+
+#======================== node ========================
+
+# digest of a builtin protocol feature by codename, empty if nodeos does not support it
+feature_digest() {
+    curl -sf -X POST $url/v1/producer/get_supported_protocol_features -d '{}' \
+        | jq -r --arg codename $1 '.[] | select(.specification[]?.value == $codename) | .feature_digest'
+}
+
+activate_feature() {
+    local digest=$(feature_digest $1)
+    [[ -n "$digest" ]] || return 1
+    cl push action eosio activate '["'$digest'"]' -p eosio > /dev/null 2>> $work/errors.log || { echo "could not activate $1"; exit 1; }
+}
+
+stop_node() {
+    [[ -n "$nodeos_pid" ]] && kill $nodeos_pid 2>/dev/null && wait $nodeos_pid 2>/dev/null
+    [[ -n "$keosd_pid" ]] && kill $keosd_pid 2>/dev/null && wait $keosd_pid 2>/dev/null
+}
+
+boot() {
+    rm -rf $work/node $work/wallet
+    mkdir -p $work/node $work/wallet
+
+    $keosd --data-dir $work/wallet --config-dir $work/wallet --wallet-dir $work/wallet \
+        --http-server-address 127.0.0.1:8899 > $work/wallet/keosd.log 2>&1 &
+    keosd_pid=$!
+
+    $nodeos -e -p eosio --data-dir $work/node/data --config-dir $work/node/config \
+        --plugin eosio::producer_plugin --plugin eosio::producer_api_plugin \
+        --plugin eosio::chain_plugin --plugin eosio::chain_api_plugin --plugin eosio::http_plugin \
+        --http-server-address 127.0.0.1:8888 --contracts-console --max-transaction-time 1000 \
+        > $work/node/nodeos.log 2>&1 &
+    nodeos_pid=$!
+    trap stop_node EXIT
+
+    for attempt in $(seq 1 30); do
+        cl get info > /dev/null 2>&1 && break
+        sleep 1
+    done
+    cl get info > /dev/null 2>&1 || { echo "nodeos did not start, see $work/node/nodeos.log"; exit 1; }
+
+    cl wallet create -n localnet --file $work/wallet/password > /dev/null || exit 1
+    cl wallet import -n localnet --private-key $priv > /dev/null || exit 1
+
+    #PREACTIVATE_FEATURE lets eosio.boot activate the rest
+    local preactivate=$(feature_digest PREACTIVATE_FEATURE)
+    [[ -n "$preactivate" ]] || { echo "nodeos does not support PREACTIVATE_FEATURE, see $work/node/nodeos.log"; exit 1; }
+    curl -sf -X POST $url/v1/producer/schedule_protocol_feature_activations \
+        -d '{"protocol_features_to_activate":["'$preactivate'"]}' > /dev/null || { echo "could not schedule PREACTIVATE_FEATURE"; exit 1; }
+
+    #setcode of eosio.boot fails until the feature is active in a produced block
+    local booted=""
+    for attempt in $(seq 1 10); do
+        cl set contract eosio $boot_dir eosio.boot.wasm eosio.boot.abi -p eosio > /dev/null 2>> $work/errors.log && { booted=1; break; }
+        sleep 1
+    done
+    [[ -n "$booted" ]] || { echo "could not deploy eosio.boot, see $work/errors.log"; exit 1; }
+
+    for feature in $required_features; do
+        activate_feature $feature || { echo "nodeos does not support $feature"; exit 1; }
+    done
+    for feature in $optional_features; do
+        activate_feature $feature || echo "nodeos does not support $feature, measuring without it"
+    done
+
+    #activations take effect from the next block
+    sleep 1
+}
+
+new_account() {
+    cl create account eosio $1 $pub $pub > /dev/null 2>> $work/errors.log || { echo "could not create $1"; exit 1; }
+}
+
+deploy() {
+    new_account $account
+    cl set contract $account $1 $contract.wasm $contract.abi -p $account > /dev/null || exit 1
+
+    #requires realmaccount@eosio.code on active perm for logevents
+    cl set account permission $account active \
+        '{"threshold":1,"keys":[{"key":"'$pub'","weight":1}],"accounts":[{"permission":{"actor":"'$account'","permission":"eosio.code"},"weight":1}]}' \
+        owner -p $account@owner > /dev/null || exit 1
+}
+
+#======================== pushes ========================
+
+# untimed push, fails the run if it fails
+setup() {
+    local actor=$1 action=$2 data=$3
+    cl push action $account $action "$data" -p $actor -f > /dev/null 2>> $work/errors.log || { echo "setup $action failed, see $work/errors.log"; exit 1; }
+}
+
+# count copies of one action in one transaction, for building large tables quickly
+setup_batch() {
+    local actor=$1 action=$2 data=$3 count=$4
+    local trx=$(jq -n --arg account $account --arg action $action --arg actor $actor --argjson data "$data" --argjson count $count \
+        '{actions: [range($count) | {account: $account, name: $action, authorization: [{actor: $actor, permission: "active"}], data: $data}]}')
+    cl push transaction "$trx" > /dev/null 2>> $work/errors.log || { echo "setup $action x$count failed, see $work/errors.log"; exit 1; }
+}
+
+# -p flags for a comma separated list of actors, the first one pays
+auths() {
+    local actor
+    for actor in ${1//,/ }; do
+        echo -n "-p $actor "
+    done
+}
+
+# timed push, appends label,run,cpu_us,net_bytes,ram_bytes to the results, with empty costs if it failed
+measure() {
+    local label=$1 run=$2 actor=$3 action=$4 data=$5
+    local out
+    if ! out=$(cl push action $account $action "$data" $(auths $actor) -f -j 2>> $work/errors.log); then
+        echo "$label,$run,,," >> $results
+        echo "  $label failed on run $run"
+        return
+    fi
+
+    #ram deltas of the action and every inline action and notification it caused
+    echo "$out" | jq -r --arg label "$label" --arg run $run \
+        '[$label, $run, .processed.receipt.cpu_usage_us, .processed.receipt.net_usage_words * 8,
+          ([.processed.action_traces[] | .. | objects | select(has("account_ram_deltas")) | .account_ram_deltas[].delta] | add // 0)]
+         | map(tostring) | join(",")' >> $results
+}
+
+next_serial() {
+    echo $(( $(cl get table $account $account schemas -L dragons -l 1 | jq '.rows[0].issued_supply') + 1 ))
+}
+
+#======================== realm ========================
+
+# one schema of $nfts nfts held by bob with six stats, and a currency held by alice and bob
+build_realm() {
+    for acct in alice bob carol; do
+        new_account $acct
+    done
+    for i in $(seq 0 $((runs - 1))); do
+        new_account $(indexed_name acct $i)
+        new_account $(indexed_name old $i)
+    done
+
+    setup $account setrealmdata '{"drealms_version":"v0.2.0","realm_name":"fantasy"}'
+    setup alice newnftschema '{"new_schema_name":"dragons","issuer":"alice","max_supply":"'$((nfts * 100 + runs * 1000))'","exp_symbol":"0,EXP","retirable":true,"transferable":true,"consumable":true,"activatable":true}'
+    for stat in strength dexterity constitution intelligence wisdom charisma; do
+        setup alice addstat '{"schema_name":"dragons","stat_name":"'$stat'","default_value":1}'
+    done
+    setup alice newuri '{"schema_name":"dragons","license_owner":"alice","uri_group":"base","uri_name":"meta","new_uri":"https://cdn.drealms.io/dragons/","serial":null}'
+
+    local left=$nfts
+    while [[ $left -gt 0 ]]; do
+        local batch=$(( left < 100 ? left : 100 ))
+        setup_batch alice issuenft '{"to":"bob","schema_name":"dragons","memo":"","log":false}' $batch
+        left=$((left - batch))
+    done
+
+    setup alice create '{"issuer":"alice","retirable":true,"transferable":true,"consumable":true,"max_supply":"46116860184273879.03 GOLD"}'
+    setup alice issue '{"to":"alice","quantity":"'$nfts'.00 GOLD","memo":""}'
+    setup alice issue '{"to":"bob","quantity":"'$nfts'.00 GOLD","memo":""}'
+
+    #schema scanned by migrate, rows are already v1 so this measures the walk
+    setup alice newnftschema '{"new_schema_name":"legacy","issuer":"alice","max_supply":"'$((runs * 100))'","exp_symbol":"0,EXP","retirable":true,"transferable":true,"consumable":true,"activatable":true}'
+    for i in $(seq 1 $runs); do
+        setup_batch alice issuenft '{"to":"bob","schema_name":"legacy","memo":"","log":false}' 100
+    done
+}
+
+# every action once, same cases as bench/bench_actions.cpp
+run_cases() {
+    local i=$1
+    local serial=$(( i % nfts + 1 ))
+    local acct=$(indexed_name acct $i)
+    local old=$(indexed_name old $i)
+    local expiration=$(date -u -d @$(( $(date +%s) + 86400 )) +%Y-%m-%dT%H:%M:%S)
+    local expired=$(date -u -d @$(( $(date +%s) - 1 )) +%Y-%m-%dT%H:%M:%S)
+
+    #realm
+    measure setrealmdata $i $account setrealmdata '{"drealms_version":"v0.2.0","realm_name":"fantasy"}'
+
+    #schemas
+    measure newnftschema $i carol newnftschema '{"new_schema_name":"'$(indexed_name sch $i)'","issuer":"carol","max_supply":1000,"exp_symbol":"0,EXP","retirable":true,"transferable":true,"consumable":true,"activatable":true}'
+    measure toggle $i alice toggle '{"schema_name":"dragons","setting_name":"activatable"}'
+    setup alice toggle '{"schema_name":"dragons","setting_name":"activatable"}'
+    measure addstat $i carol addstat '{"schema_name":"sch.a","stat_name":"'$(indexed_name stat $i)'","default_value":1}'
+    measure syncstats $i alice syncstats '{"schema_name":"dragons","serial":'$serial'}'
+    measure awardexp $i alice awardexp '{"schema_name":"dragons","license_owner":"alice","serial":'$serial',"experience":"10 EXP"}'
+
+    #licensing
+    measure setlicmodel $i alice setlicmodel '{"schema_name":"dragons","new_license_model":"permissioned"}'
+    measure newlicense $i alice newlicense '{"schema_name":"dragons","owner":"'$acct'","expiration":"'$expiration'"}'
+    setup alice newlicense '{"schema_name":"dragons","owner":"'$old'","expiration":"'$expired'"}'
+    measure eraselicense $i alice eraselicense '{"schema_name":"dragons","license_owner":"'$old'"}'
+    measure setlicminmax $i alice setlicminmax '{"schema_name":"dragons","min_license_length":604801,"max_license_length":31449599}'
+    measure setalgo $i alice setalgo '{"schema_name":"dragons","license_owner":"alice","new_checksum_algo":"sha256"}'
+    measure setati $i alice setati '{"schema_name":"dragons","license_owner":"alice","new_ati_uri":"https://cdn.drealms.io/dragons/ati.json"}'
+    measure "newuri(full)" $i alice newuri '{"schema_name":"dragons","license_owner":"alice","uri_group":"full","uri_name":"'$(indexed_name uri $((i % 8)))'","new_uri":"https://cdn.drealms.io/dragons/full","serial":null}'
+    measure "newuri(relative)" $i alice newuri '{"schema_name":"dragons","license_owner":"alice","uri_group":"relative","uri_name":"meta","new_uri":"dragon/'$serial'","serial":'$serial'}'
+    setup alice newuri '{"schema_name":"dragons","license_owner":"alice","uri_group":"full","uri_name":"temp","new_uri":"https://cdn.drealms.io/temp","serial":null}'
+    measure deleteuri $i alice deleteuri '{"schema_name":"dragons","license_owner":"alice","uri_group":"full","uri_name":"temp","serial":null}'
+
+    #nonfungibles owned by bob
+    measure activatenft $i bob activatenft '{"schema_name":"dragons","serial":'$serial',"memo":""}'
+    measure newchecksum $i alice newchecksum '{"schema_name":"dragons","license_owner":"alice","serial":'$serial',"new_checksum":"9f86d081884c7d65"}'
+    measure levelup $i bob levelup '{"schema_name":"dragons","serial":'$serial'}'
+    measure spendpoint $i bob spendpoint '{"schema_name":"dragons","serial":'$serial',"stat_name":"strength"}'
+    measure issuenft $i alice issuenft '{"to":"bob","schema_name":"dragons","memo":"bench","log":false}'
+    measure "issuenft(log)" $i alice issuenft '{"to":"bob","schema_name":"dragons","memo":"bench","log":true}'
+    measure transfernft $i bob transfernft '{"from":"bob","to":"carol","schema_name":"dragons","serials":['$serial'],"memo":""}'
+    #carol sells back what transfernft gave her
+    measure swapnft $i carol,bob swapnft '{"seller":"carol","buyer":"bob","schema_name":"dragons","serials":['$serial'],"price":"1.00 GOLD","memo":""}'
+    setup alice issuenft '{"to":"alice","schema_name":"dragons","memo":"","log":false}'
+    measure retirenft $i alice retirenft '{"schema_name":"dragons","serials":['$(( $(next_serial) - 1 ))'],"memo":""}'
+    setup alice issuenft '{"to":"bob","schema_name":"dragons","memo":"","log":false}'
+    measure consumenft $i bob consumenft '{"schema_name":"dragons","serial":'$(( $(next_serial) - 1 ))',"memo":""}'
+    setup_batch alice issuenft '{"to":"alice","schema_name":"dragons","memo":"","log":false}' 100
+    measure "retirerange(100)" $i alice retirerange '{"schema_name":"dragons","first_serial":'$(( $(next_serial) - 100 ))',"last_serial":'$(( $(next_serial) - 1 ))',"max_rows":100,"memo":""}'
+    setup_batch alice issuenft '{"to":"bob","schema_name":"dragons","memo":"","log":false}' 100
+    measure "consumerange(100)" $i bob consumerange '{"owner":"bob","schema_name":"dragons","first_serial":'$(( $(next_serial) - 100 ))',"last_serial":'$(( $(next_serial) - 1 ))',"max_rows":100,"memo":""}'
+
+    #crafting, two dragons and 1.00 GOLD into a dragon
+    local recipe=$(indexed_name rcp $i)
+    measure newrecipe $i alice newrecipe '{"schema_name":"dragons","recipe_name":"'$recipe'","inputs":[{"key":"dragons","value":2}],"materials":["1.00 GOLD"],"stats":[{"key":"strength","value":5}]}'
+    setup alice issuenft '{"to":"bob","schema_name":"dragons","memo":"","log":false}'
+    setup alice issuenft '{"to":"bob","schema_name":"dragons","memo":"","log":false}'
+    local last=$(( $(next_serial) - 1 ))
+    measure craft $i bob craft '{"crafter":"bob","schema_name":"dragons","recipe_name":"'$recipe'","inputs":[{"key":"dragons","value":['$((last - 1))','$last']}],"memo":""}'
+    measure eraserecipe $i alice eraserecipe '{"schema_name":"dragons","recipe_name":"'$recipe'"}'
+
+    #batch, one tick of the newuri(relative), newchecksum, transfernft and spendpoint cases above
+    setup bob levelup '{"schema_name":"dragons","serial":'$serial'}'
+    measure "batch(5)" $i alice,bob,carol batch '{"ops":[
+        ["newuri_op",{"schema_name":"dragons","license_owner":"alice","uri_group":"relative","uri_name":"meta","new_uri":"dragon/'$serial'","serial":'$serial'}],
+        ["newchecksum_op",{"schema_name":"dragons","license_owner":"alice","serial":'$serial',"new_checksum":"9f86d081884c7d65"}],
+        ["transfernft_op",{"from":"bob","to":"carol","schema_name":"dragons","serials":['$serial'],"memo":""}],
+        ["transfernft_op",{"from":"carol","to":"bob","schema_name":"dragons","serials":['$serial'],"memo":""}],
+        ["spendpoint_op",{"schema_name":"dragons","serial":'$serial',"stat_name":"strength"}]]}'
+
+    #fungibles
+    measure create $i alice create '{"issuer":"alice","retirable":true,"transferable":true,"consumable":true,"max_supply":"10000.00 '$(indexed_code $i)'"}'
+    measure issue $i alice issue '{"to":"bob","quantity":"1.00 GOLD","memo":""}'
+    measure retire $i alice retire '{"quantity":"1.00 GOLD","memo":""}'
+    measure transfer $i bob transfer '{"from":"bob","to":"carol","quantity":"1.00 GOLD","memo":""}'
+    measure consume $i bob consume '{"owner":"bob","quantity":"1.00 GOLD","memo":""}'
+    measure open $i alice open '{"owner":"'$acct'","currency_symbol":"2,GOLD","ram_payer":"alice"}'
+    measure close $i $acct close '{"owner":"'$acct'","currency_symbol":"2,GOLD"}'
+
+    #opt-in notifications, bob and carol have not subscribed
+    measure subscribe $i $acct subscribe '{"account":"'$acct'","schemas":["dragons"],"currencies":[]}'
+    measure unsubscribe $i $acct unsubscribe '{"account":"'$acct'"}'
+    measure setnotify $i $account setnotify '{"notify_mode":"subscribed"}'
+    measure "issuenft(optin)" $i alice issuenft '{"to":"bob","schema_name":"dragons","memo":"bench","log":false}'
+    measure "transfernft(optin)" $i bob transfernft '{"from":"bob","to":"carol","schema_name":"dragons","serials":['$(( $(next_serial) - 1 ))'],"memo":""}'
+    measure "transfer(optin)" $i bob transfer '{"from":"bob","to":"carol","quantity":"1.00 GOLD","memo":""}'
+    setup $account setnotify '{"notify_mode":"all"}'
+
+    #migration, one call walks the 100 rows issued for this run
+    measure "migrate(100)" $i alice migrate '{"table_name":"nfts","scope":"legacy","max_rows":100}'
+
+    #event log
+    local event='{"event_name":"transfer","schema_name":"dragons","serial":'$serial',"from":"bob","to":"carol","value":0}'
+    measure "logevents(10)" $i $account logevents '{"events":['$(printf "$event,%.0s" $(seq 1 9))$event']}'
+}
+
+summarize() {
+    printf "%-18s %10s %10s %10s\n" "action" "cpu us" "net B" "ram B"
+    for label in $(labels $1); do
+        printf "%-18s %10s %10s %10s\n" "$label" $(column_median $1 "$label" 3) $(column_median $1 "$label" 4) $(column_median $1 "$label" 5)
+    done
+}
+
+#======================== stages ========================
+
+if [[ "$2" == "run" ]]; then
+    build_dir=${3:-./build/$contract}
+    results=${4:-$work/results-$(date +%Y%m%d-%H%M%S).csv}
+    [[ -f $build_dir/$contract.wasm ]] || { echo "no $contract.wasm in $build_dir, run ./build.sh $contract first"; exit 1; }
+    command -v jq > /dev/null || { echo "need jq"; exit 1; }
+    command -v curl > /dev/null || { echo "need curl"; exit 1; }
+    [[ -f $boot_dir/eosio.boot.wasm ]] || { echo "no eosio.boot.wasm in $boot_dir, set BOOT_DIR to the reference contracts build"; exit 1; }
+
+    mkdir -p $work $(dirname $results)
+    : > $work/errors.log
+    echo "label,run,cpu_us,net_bytes,ram_bytes" > $results
+
+    boot
+    deploy $build_dir
+    echo "building realm of $nfts nfts"
+    build_realm
+
+    #the first run of an action may pay for cold wasm instantiation, medians absorb it
+    for i in $(seq 0 $((runs - 1))); do
+        echo "run $((i + 1)) of $runs"
+        run_cases $i
+    done
+
+    echo
+    summarize $results
+    echo
+    echo "results written to $results"
+    exit 0
+fi
+
+if [[ "$2" == "compare" ]]; then
+    base=$3
+    candidate=$4
+    [[ -f "$base" && -f "$candidate" ]] || { echo "need two results files"; exit 1; }
+
+    printf "%-18s %10s %10s %8s %8s %8s %8s %8s\n" "action" "base cpu" "cand cpu" "cpu %" "base net" "cand net" "base ram" "cand ram"
+    for label in $(labels $base $candidate); do
+        b=$(column_median $base "$label" 3)
+        c=$(column_median $candidate "$label" 3)
+        delta=$(awk -v b="$b" -v c="$c" 'BEGIN { if (b == "-" || c == "-" || b == 0) print "-"; else printf "%+.1f", (c - b) * 100 / b }')
+        printf "%-18s %10s %10s %8s %8s %8s %8s %8s\n" "$label" $b $c $delta \
+            $(column_median $base "$label" 4) $(column_median $candidate "$label" 4) \
+            $(column_median $base "$label" 5) $(column_median $candidate "$label" 5)
+    done
+    exit 0
+fi
+
+echo "need stage: run or compare"
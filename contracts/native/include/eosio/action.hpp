@@ -0,0 +1,82 @@
+// Native stand-in for eosio.cdt's action, authorization and notification
+// intrinsics. The intrinsics are implemented against the in-memory chain in
+// host.hpp.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <tuple>
+#include <vector>
+
+#include <eosio/name.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+    struct permission_level {
+
+        permission_level(name a, name p) : actor(a), permission(p) {}
+
+        permission_level() {}
+
+        name actor;
+        name permission;
+
+        friend bool operator==(const permission_level& a, const permission_level& b) {
+            return a.actor == b.actor && a.permission == b.permission;
+        }
+
+        EOSLIB_SERIALIZE(permission_level, (actor)(permission))
+    };
+
+    struct action {
+
+        eosio::name account;
+        eosio::name name;
+        std::vector<permission_level> authorization;
+        std::vector<char> data;
+
+        action() {}
+
+        template<typename T>
+        action(const permission_level& auth, eosio::name a, eosio::name n, T&& value)
+            : account(a), name(n), authorization(1, auth), data(pack(std::forward<T>(value))) {}
+
+        template<typename T>
+        action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T&& value)
+            : account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value))) {}
+
+        template<typename T>
+        T data_as() const {
+            return unpack<T>(data);
+        }
+
+        //queues an inline action on the current action context
+        void send() const;
+
+        EOSLIB_SERIALIZE(action, (account)(name)(authorization)(data))
+    };
+
+    void require_auth(name n);
+
+    void require_auth(const permission_level& level);
+
+    bool has_auth(name n);
+
+    bool is_account(name n);
+
+    void require_recipient(name notify_account);
+
+    template<typename... accounts>
+    void require_recipient(name notify_account, accounts... remaining) {
+        require_recipient(notify_account);
+        require_recipient(remaining...);
+    }
+
+    name current_receiver();
+
+}
+
+#include <eosio/host.hpp>
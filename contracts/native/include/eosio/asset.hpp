@@ -0,0 +1,110 @@
+// Native stand-in for eosio.cdt's asset type.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <eosio/check.hpp>
+#include <eosio/symbol.hpp>
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+    struct asset {
+
+        static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+        int64_t amount = 0;
+        eosio::symbol symbol;
+
+        asset() {}
+
+        asset(int64_t a, class symbol s) : amount(a), symbol{s} {
+            check(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+            check(symbol.is_valid(), "invalid symbol name");
+        }
+
+        bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+
+        bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+        asset operator-() const {
+            asset r = *this;
+            r.amount = -r.amount;
+            return r;
+        }
+
+        asset& operator-=(const asset& a) {
+            check(a.symbol == symbol, "attempt to subtract asset with different symbol");
+            amount -= a.amount;
+            check(-max_amount <= amount, "subtraction underflow");
+            check(amount <= max_amount, "subtraction overflow");
+            return *this;
+        }
+
+        asset& operator+=(const asset& a) {
+            check(a.symbol == symbol, "attempt to add asset with different symbol");
+            amount += a.amount;
+            check(-max_amount <= amount, "addition underflow");
+            check(amount <= max_amount, "addition overflow");
+            return *this;
+        }
+
+        friend asset operator+(const asset& a, const asset& b) {
+            asset result = a;
+            result += b;
+            return result;
+        }
+
+        friend asset operator-(const asset& a, const asset& b) {
+            asset result = a;
+            result -= b;
+            return result;
+        }
+
+        friend bool operator==(const asset& a, const asset& b) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount == b.amount;
+        }
+
+        friend bool operator!=(const asset& a, const asset& b) { return !(a == b); }
+
+        friend bool operator<(const asset& a, const asset& b) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount < b.amount;
+        }
+
+        friend bool operator<=(const asset& a, const asset& b) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount <= b.amount;
+        }
+
+        friend bool operator>(const asset& a, const asset& b) { return b < a; }
+
+        friend bool operator>=(const asset& a, const asset& b) { return b <= a; }
+
+        std::string to_string() const {
+            int64_t p = symbol.precision();
+            int64_t scale = 1;
+            for (int64_t i = 0; i < p; ++i) {
+                scale *= 10;
+            }
+
+            bool negative = amount < 0;
+            uint64_t abs_amount = negative ? -amount : amount;
+            std::string result = std::to_string(abs_amount / scale);
+            if (p > 0) {
+                std::string fraction = std::to_string(abs_amount % scale);
+                result += "." + std::string(p - fraction.size(), '0') + fraction;
+            }
+
+            return (negative ? "-" : "") + result + " " + symbol.code().to_string();
+        }
+
+        EOSLIB_SERIALIZE(asset, (amount)(symbol))
+    };
+
+}
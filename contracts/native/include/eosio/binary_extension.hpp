@@ -0,0 +1,79 @@
+// Native stand-in for eosio.cdt's binary_extension.
+//
+// A trailing field that may be missing from older serialized data.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <optional>
+
+#include <eosio/check.hpp>
+
+namespace eosio {
+
+    template<typename T>
+    class binary_extension {
+
+    public:
+
+        using value_type = T;
+
+        constexpr binary_extension() {}
+
+        constexpr binary_extension(const T& ext) : _value(ext) {}
+
+        constexpr binary_extension(T&& ext) : _value(std::move(ext)) {}
+
+        constexpr bool has_value() const { return _value.has_value(); }
+
+        constexpr explicit operator bool() const { return has_value(); }
+
+        constexpr T& value() {
+            check(has_value(), "cannot get value of empty binary_extension");
+            return *_value;
+        }
+
+        constexpr const T& value() const {
+            check(has_value(), "cannot get value of empty binary_extension");
+            return *_value;
+        }
+
+        constexpr T value_or(const T& def = T{}) const { return has_value() ? *_value : def; }
+
+        template<typename... Args>
+        binary_extension& emplace(Args&&... args) {
+            _value.emplace(std::forward<Args>(args)...);
+            return *this;
+        }
+
+        void reset() { _value.reset(); }
+
+        //only present values are written
+        template<typename DataStream>
+        friend DataStream& operator<<(DataStream& ds, const binary_extension& be) {
+            if (be.has_value()) {
+                ds << *be._value;
+            }
+            return ds;
+        }
+
+        //only read if data remains in the stream
+        template<typename DataStream>
+        friend DataStream& operator>>(DataStream& ds, binary_extension& be) {
+            if (ds.remaining()) {
+                T val;
+                ds >> val;
+                be._value = std::move(val);
+            } else {
+                be._value.reset();
+            }
+            return ds;
+        }
+
+    private:
+
+        std::optional<T> _value;
+    };
+
+}
@@ -0,0 +1,38 @@
+// Native stand-in for eosio.cdt's check().
+//
+// A failed check throws instead of aborting, so the host can roll back the
+// transaction and report the message.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace eosio {
+
+    struct check_failure : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    constexpr void check(bool pred, const char* msg) {
+        if (!pred) {
+            throw check_failure(msg);
+        }
+    }
+
+    inline void check(bool pred, const std::string& msg) {
+        if (!pred) {
+            throw check_failure(msg);
+        }
+    }
+
+    inline void check(bool pred, uint64_t code) {
+        if (!pred) {
+            throw check_failure("assertion failure with error code: " + std::to_string(code));
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+// Native stand-in for eosio.cdt's fixed_bytes and checksum types.
+//
+// Only storage, comparison and serialization; the hash intrinsics are not
+// provided.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+    //fixed size byte array, serialized as its raw bytes
+    template<size_t Size>
+    class fixed_bytes {
+
+    public:
+
+        constexpr fixed_bytes() : _data{} {}
+
+        constexpr fixed_bytes(const std::array<uint8_t, Size>& arr) : _data(arr) {}
+
+        std::array<uint8_t, Size> extract_as_byte_array() const { return _data; }
+
+        const uint8_t* data() const { return _data.data(); }
+
+        static constexpr size_t size() { return Size; }
+
+        friend bool operator==(const fixed_bytes& a, const fixed_bytes& b) { return a._data == b._data; }
+        friend bool operator!=(const fixed_bytes& a, const fixed_bytes& b) { return a._data != b._data; }
+        friend bool operator<(const fixed_bytes& a, const fixed_bytes& b) { return a._data < b._data; }
+
+        template<typename DataStream>
+        friend DataStream& operator<<(DataStream& ds, const fixed_bytes& fb) {
+            for (auto b : fb._data) {
+                ds << b;
+            }
+            return ds;
+        }
+
+        template<typename DataStream>
+        friend DataStream& operator>>(DataStream& ds, fixed_bytes& fb) {
+            for (auto& b : fb._data) {
+                ds >> b;
+            }
+            return ds;
+        }
+
+    private:
+
+        std::array<uint8_t, Size> _data;
+    };
+
+    using checksum160 = fixed_bytes<20>;
+    using checksum256 = fixed_bytes<32>;
+    using checksum512 = fixed_bytes<64>;
+
+}
@@ -0,0 +1,381 @@
+// Native stand-in for eosio.cdt's datastream and pack/unpack helpers.
+//
+// Follows the same wire format as the chain: little endian integers,
+// varuint32 length prefixes, and no padding.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <eosio/check.hpp>
+#include <eosio/varint.hpp>
+
+namespace eosio {
+
+    template<typename T>
+    class datastream {
+
+    public:
+
+        datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+        void skip(size_t s) { _pos += s; }
+
+        bool read(char* d, size_t s) {
+            check(size_t(_end - _pos) >= s, "datastream attempted to read past the end");
+            memcpy(d, _pos, s);
+            _pos += s;
+            return true;
+        }
+
+        bool write(const char* d, size_t s) {
+            check(size_t(_end - _pos) >= s, "datastream attempted to write past the end");
+            memcpy((void*)_pos, d, s);
+            _pos += s;
+            return true;
+        }
+
+        bool get(char& c) { return read(&c, 1); }
+
+        bool put(char c) { return write(&c, 1); }
+
+        T pos() const { return _pos; }
+
+        bool valid() const { return _pos <= _end && _pos >= _start; }
+
+        bool seekp(size_t p) { _pos = _start + p; return _pos <= _end; }
+
+        size_t tellp() const { return size_t(_pos - _start); }
+
+        size_t remaining() const { return size_t(_end - _pos); }
+
+    private:
+
+        T _start;
+        T _pos;
+        T _end;
+    };
+
+    //counts the bytes a value would pack to
+    template<>
+    class datastream<size_t> {
+
+    public:
+
+        datastream(size_t init_size = 0) : _size(init_size) {}
+
+        bool skip(size_t s) { _size += s; return true; }
+
+        bool write(const char*, size_t s) { _size += s; return true; }
+
+        bool put(char) { ++_size; return true; }
+
+        bool valid() const { return true; }
+
+        bool seekp(size_t p) { _size = p; return true; }
+
+        size_t tellp() const { return _size; }
+
+        size_t remaining() const { return 0; }
+
+    private:
+
+        size_t _size;
+    };
+
+    //======================== declarations ========================
+
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>>* = nullptr>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v);
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>>* = nullptr>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, T& v);
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::string& v);
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::string& v);
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::vector<T>& v);
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::vector<T>& v);
+
+    template<typename Stream, typename T, size_t N>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::array<T, N>& v);
+    template<typename Stream, typename T, size_t N>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::array<T, N>& v);
+
+    template<typename Stream, typename K, typename V>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::map<K, V>& m);
+    template<typename Stream, typename K, typename V>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::map<K, V>& m);
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::set<T>& s);
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::set<T>& s);
+
+    template<typename Stream, typename A, typename B>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::pair<A, B>& p);
+    template<typename Stream, typename A, typename B>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::pair<A, B>& p);
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::optional<T>& o);
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::optional<T>& o);
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::tuple<Ts...>& t);
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::tuple<Ts...>& t);
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::variant<Ts...>& v);
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::variant<Ts...>& v);
+
+    //======================== definitions ========================
+
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>>*>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v) {
+        ds.write((const char*)&v, sizeof(T));
+        return ds;
+    }
+
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>>*>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, T& v) {
+        ds.read((char*)&v, sizeof(T));
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::string& v) {
+        ds << unsigned_int(v.size());
+        if (v.size()) {
+            ds.write(v.data(), v.size());
+        }
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::string& v) {
+        unsigned_int s;
+        ds >> s;
+        v.resize(s.value);
+        if (s.value) {
+            ds.read(v.data(), s.value);
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::vector<T>& v) {
+        ds << unsigned_int(v.size());
+        if constexpr (std::is_same_v<T, char>) {
+            ds.write(v.data(), v.size());
+        } else {
+            for (const auto& i : v) {
+                ds << i;
+            }
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::vector<T>& v) {
+        unsigned_int s;
+        ds >> s;
+        v.resize(s.value);
+        if constexpr (std::is_same_v<T, char>) {
+            ds.read(v.data(), v.size());
+        } else {
+            for (auto& i : v) {
+                ds >> i;
+            }
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T, size_t N>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::array<T, N>& v) {
+        for (const auto& i : v) {
+            ds << i;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T, size_t N>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::array<T, N>& v) {
+        for (auto& i : v) {
+            ds >> i;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename K, typename V>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::map<K, V>& m) {
+        ds << unsigned_int(m.size());
+        for (const auto& i : m) {
+            ds << i.first << i.second;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename K, typename V>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::map<K, V>& m) {
+        m.clear();
+        unsigned_int s;
+        ds >> s;
+        for (uint32_t i = 0; i < s.value; ++i) {
+            K k;
+            V v;
+            ds >> k >> v;
+            m.emplace(std::move(k), std::move(v));
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::set<T>& s) {
+        ds << unsigned_int(s.size());
+        for (const auto& i : s) {
+            ds << i;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::set<T>& s) {
+        s.clear();
+        unsigned_int size;
+        ds >> size;
+        for (uint32_t i = 0; i < size.value; ++i) {
+            T v;
+            ds >> v;
+            s.emplace(std::move(v));
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename A, typename B>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::pair<A, B>& p) {
+        return ds << p.first << p.second;
+    }
+
+    template<typename Stream, typename A, typename B>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::pair<A, B>& p) {
+        return ds >> p.first >> p.second;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::optional<T>& o) {
+        char valid = o.has_value();
+        ds << valid;
+        if (valid) {
+            ds << *o;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::optional<T>& o) {
+        char valid = 0;
+        ds >> valid;
+        if (valid) {
+            T val;
+            ds >> val;
+            o = std::move(val);
+        } else {
+            o.reset();
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::tuple<Ts...>& t) {
+        std::apply([&](const auto&... args) { ((ds << args), ...); }, t);
+        return ds;
+    }
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::tuple<Ts...>& t) {
+        std::apply([&](auto&... args) { ((ds >> args), ...); }, t);
+        return ds;
+    }
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::variant<Ts...>& v) {
+        ds << unsigned_int(v.index());
+        std::visit([&](const auto& val) { ds << val; }, v);
+        return ds;
+    }
+
+    namespace detail {
+        template<size_t I, typename Stream, typename... Ts>
+        void unpack_variant(datastream<Stream>& ds, std::variant<Ts...>& v, uint32_t index) {
+            if constexpr (I < sizeof...(Ts)) {
+                if (index == I) {
+                    std::variant_alternative_t<I, std::variant<Ts...>> val;
+                    ds >> val;
+                    v = std::move(val);
+                } else {
+                    unpack_variant<I + 1>(ds, v, index);
+                }
+            } else {
+                check(false, "invalid variant index");
+            }
+        }
+    }
+
+    template<typename Stream, typename... Ts>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::variant<Ts...>& v) {
+        unsigned_int index;
+        ds >> index;
+        detail::unpack_variant<0>(ds, v, index.value);
+        return ds;
+    }
+
+    //======================== helpers ========================
+
+    template<typename T>
+    size_t pack_size(const T& value) {
+        datastream<size_t> ps;
+        ps << value;
+        return ps.tellp();
+    }
+
+    template<typename T>
+    std::vector<char> pack(const T& value) {
+        std::vector<char> result(pack_size(value));
+        datastream<char*> ds(result.data(), result.size());
+        ds << value;
+        return result;
+    }
+
+    template<typename T>
+    T unpack(const char* buffer, size_t len) {
+        T result;
+        datastream<const char*> ds(buffer, len);
+        ds >> result;
+        return result;
+    }
+
+    template<typename T>
+    T unpack(const std::vector<char>& bytes) {
+        return unpack<T>(bytes.data(), bytes.size());
+    }
+
+}
@@ -0,0 +1,69 @@
+// Native stand-in for eosio.cdt's action dispatcher.
+//
+// EOSIO_DISPATCH defines apply() just like the wasm entry point, so a host
+// program registers it with chain::set_contract().
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+
+#include <eosio/datastream.hpp>
+#include <eosio/host.hpp>
+#include <eosio/name.hpp>
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+    //unpacks the current action's data and calls the member function on a new contract instance
+    template<typename T, typename R, typename... Args>
+    bool execute_action(name self, name code, R (T::*func)(Args...)) {
+        auto& ctx = host::context();
+        auto& data = ctx.act->data;
+        host::stats.bytes_unpacked += data.size();
+
+        datastream<const char*> ds(data.data(), data.size());
+        std::tuple<std::decay_t<Args>...> args;
+        ds >> args;
+
+        T inst(self, code, ds);
+
+        auto f = [&](auto&&... a) {
+            return ((&inst)->*func)(std::forward<decltype(a)>(a)...);
+        };
+
+        if constexpr (std::is_void_v<R>) {
+            std::apply(f, args);
+        } else {
+            ctx.return_value = pack(std::apply(f, args));
+        }
+
+        return true;
+    }
+
+}
+
+#define EOSIO_NATIVE_DISPATCH_A(member) \
+    case eosio::name(#member).value: \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &dispatch_type::member); \
+        break; \
+    EOSIO_NATIVE_DISPATCH_B
+#define EOSIO_NATIVE_DISPATCH_B(member) \
+    case eosio::name(#member).value: \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &dispatch_type::member); \
+        break; \
+    EOSIO_NATIVE_DISPATCH_A
+#define EOSIO_NATIVE_DISPATCH_A_END
+#define EOSIO_NATIVE_DISPATCH_B_END
+
+#define EOSIO_DISPATCH(TYPE, MEMBERS) \
+    extern "C" void apply(uint64_t receiver, uint64_t code, uint64_t action) { \
+        using dispatch_type = TYPE; \
+        if (code == receiver) { \
+            switch (action) { \
+                EOSIO_NATIVE_CAT(EOSIO_NATIVE_DISPATCH_A MEMBERS, _END) \
+            } \
+        } \
+    }
@@ -0,0 +1,22 @@
+// Native stand-in for eosio.cdt's eosio.hpp.
+//
+// Lets contracts compile with a host compiler against the in-memory chain
+// in host.hpp. Build with contracts/native/include ahead of any other eosio
+// include path.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+#include <eosio/serialize.hpp>
+#include <eosio/varint.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/time.hpp>
+#include <eosio/action.hpp>
+#include <eosio/host.hpp>
+#include <eosio/print.hpp>
+#include <eosio/multi_index.hpp>
+#include <eosio/contract.hpp>
+#include <eosio/dispatcher.hpp>
@@ -0,0 +1,454 @@
+// In-memory chain for native builds of eosio contracts.
+//
+// Holds serialized table rows, accounts, authorizations and the action
+// context, and counts every database intrinsic so actions can be measured
+// off chain. The table accesses of actions can be recorded as well. Rows are kept packed exactly as nodeos stores them, so
+// deserialization cost and billed RAM match a real node.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <eosio/action.hpp>
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+
+namespace eosio::host {
+
+    //billable bytes per row and per table scope, from nodeos config.hpp
+    constexpr int64_t overhead_per_row_per_index_ram_bytes = 32;
+    constexpr int64_t billable_row_overhead = 44 + overhead_per_row_per_index_ram_bytes * 2; //key_value_object
+    constexpr int64_t billable_table_overhead = 44 + overhead_per_row_per_index_ram_bytes * 2; //table_id_object
+
+    constexpr uint32_t max_inline_action_depth = 4;
+
+    //database intrinsic and serialization counts
+    struct counters {
+        uint64_t db_find = 0;
+        uint64_t db_get = 0;
+        uint64_t db_store = 0;
+        uint64_t db_update = 0;
+        uint64_t db_remove = 0;
+        uint64_t db_next = 0;
+        uint64_t db_previous = 0;
+        uint64_t db_lowerbound = 0;
+        uint64_t db_upperbound = 0;
+        uint64_t db_end = 0;
+        uint64_t bytes_packed = 0;
+        uint64_t bytes_unpacked = 0;
+        uint64_t auth_checks = 0;
+        uint64_t notifications = 0;
+        uint64_t inline_actions = 0;
+
+        uint64_t db_ops() const {
+            return db_find + db_get + db_store + db_update + db_remove
+                + db_next + db_previous + db_lowerbound + db_upperbound + db_end;
+        }
+
+        void reset() { *this = counters(); }
+    };
+
+    inline thread_local counters stats;
+
+    struct row {
+        name payer;
+        std::vector<char> data;
+    };
+
+    struct table {
+        name payer; //billed for the table scope while it holds rows
+        std::map<uint64_t, row> rows;
+        mutable std::shared_mutex mutex; //held by multi_index reads and set_row, for actions executed side by side
+    };
+
+    struct action_data {
+        eosio::name account;
+        eosio::name name;
+        std::vector<permission_level> authorization;
+        std::vector<char> data;
+
+        EOSLIB_SERIALIZE(action_data, (account)(name)(authorization)(data))
+    };
+
+    //receiver is the account executing, code is the account the action was sent to
+    using apply_handler = void (*)(uint64_t receiver, uint64_t code, uint64_t action);
+
+    struct action_context {
+        name receiver;
+        const action_data* act = nullptr;
+        std::vector<name> notified;
+        std::vector<action_data> inline_actions;
+        std::vector<char> return_value;
+    };
+
+    //a database access of the executing actions, seeks depend on every row key of the scope
+    struct table_access {
+        name code;
+        uint64_t scope;
+        name table_name;
+        uint64_t primary_key; //ignored for seeks
+        bool seek;
+        bool write;
+    };
+
+    struct undo_entry {
+        name code;
+        uint64_t scope;
+        name table_name;
+        uint64_t primary_key;
+        std::optional<row> old_row;
+    };
+
+    class chain {
+
+    public:
+
+        time_point now = time_point(seconds(1577836800)); //2020-01-01
+
+        bool echo_console = false;
+        std::string console; //output of the last transaction, when transactions run one at a time
+
+        void append_console(const std::string& s) {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            console += s;
+        }
+
+        //treat every name as an account, for replaying actions whose accounts were never created here
+        bool any_account = false;
+
+        //called for every row written or removed, including rollbacks, old_row or new_row is nullptr if absent
+        std::function<void(name code, uint64_t scope, name table_name, uint64_t primary_key, const row* old_row, const row* new_row)> row_observer;
+
+        void create_account(name account) {
+            accounts.insert(account.value);
+        }
+
+        bool is_account(name account) const {
+            return any_account || accounts.count(account.value) > 0;
+        }
+
+        void set_contract(name account, apply_handler handler) {
+            create_account(account);
+            contracts[account.value] = handler;
+        }
+
+        //returns nullptr if the table scope has never held a row
+        table* find_table(name code, uint64_t scope, name table_name) {
+            std::shared_lock<std::shared_mutex> lock(tables_mutex);
+            auto itr = tables.find(std::make_tuple(code.value, scope, table_name.value));
+            return itr == tables.end() ? nullptr : &itr->second;
+        }
+
+        table& get_table(name code, uint64_t scope, name table_name) {
+            if (auto* t = find_table(code, scope, table_name)) {
+                return *t;
+            }
+            std::unique_lock<std::shared_mutex> lock(tables_mutex);
+            return tables[std::make_tuple(code.value, scope, table_name.value)];
+        }
+
+        //visits every table scope of a contract table
+        template<typename F>
+        void for_each_scope(name code, name table_name, F&& f) {
+            std::shared_lock<std::shared_mutex> lock(tables_mutex);
+            for (auto& t : tables) {
+                if (std::get<0>(t.first) == code.value && std::get<2>(t.first) == table_name.value) {
+                    f(std::get<1>(t.first), t.second);
+                }
+            }
+        }
+
+        //visits every table scope of a contract
+        template<typename F>
+        void for_each_table(name code, F&& f) {
+            std::shared_lock<std::shared_mutex> lock(tables_mutex);
+            for (auto& t : tables) {
+                if (std::get<0>(t.first) == code.value) {
+                    f(std::get<1>(t.first), name(std::get<2>(t.first)), t.second);
+                }
+            }
+        }
+
+        //inserts, replaces (r != nullptr) or removes (r == nullptr) a row and bills RAM
+        void set_row(name code, uint64_t scope, name table_name, uint64_t primary_key, const row* r);
+
+        //bills a table scope holding rows to payer rather than the payer of its first row, for state loaded from a snapshot
+        void set_table_payer(name code, uint64_t scope, name table_name, name payer) {
+            auto* t = find_table(code, scope, table_name);
+            check(t != nullptr && !t->rows.empty(), "table scope holds no rows");
+            std::unique_lock<std::shared_mutex> lock(t->mutex);
+            bill(t->payer, -billable_table_overhead);
+            t->payer = payer;
+            bill(payer, billable_table_overhead);
+        }
+
+        int64_t ram_usage(name account) const {
+            std::lock_guard<std::mutex> lock(ram_mutex);
+            auto itr = ram.find(account.value);
+            return itr == ram.end() ? 0 : itr->second;
+        }
+
+        int64_t total_ram_usage() const {
+            std::lock_guard<std::mutex> lock(ram_mutex);
+            int64_t total = 0;
+            for (auto& r : ram) {
+                total += r.second;
+            }
+            return total;
+        }
+
+        //executes actions atomically, rolling back every write if one fails, block_time overrides now
+        std::vector<char> push_transaction(const std::vector<action_data>& actions, std::optional<time_point> block_time = {});
+
+        std::vector<char> push_action(const action_data& act, std::optional<time_point> block_time = {}) {
+            return push_transaction({act}, block_time);
+        }
+
+        template<typename... Args>
+        std::vector<char> push_action(name account, name action_name, std::vector<permission_level> auths, const Args&... args) {
+            return push_action(action_data{account, action_name, std::move(auths), pack(std::make_tuple(args...))});
+        }
+
+    private:
+
+        void apply(const action_data& act, name receiver, uint32_t depth);
+
+        void bill(name payer, int64_t delta) {
+            std::lock_guard<std::mutex> lock(ram_mutex);
+            ram[payer.value] += delta;
+        }
+
+        std::set<uint64_t> accounts;
+        std::map<uint64_t, apply_handler> contracts;
+
+        std::mutex console_mutex;
+
+        mutable std::shared_mutex tables_mutex;
+        std::map<std::tuple<uint64_t, uint64_t, uint64_t>, table> tables;
+
+        mutable std::mutex ram_mutex;
+        std::map<uint64_t, int64_t> ram;
+    };
+
+    inline chain default_chain;
+
+    inline thread_local chain* current_chain = &default_chain;
+    inline thread_local action_context* current_context = nullptr;
+    inline thread_local std::vector<undo_entry>* current_undo = nullptr;
+    inline thread_local std::optional<time_point> current_block_time;
+    inline thread_local std::vector<table_access>* current_accesses = nullptr; //recorded by multi_index when set
+
+    inline void record_access(name code, uint64_t scope, name table_name, uint64_t primary_key, bool seek, bool write) {
+        if (current_accesses) {
+            current_accesses->push_back(table_access{code, scope, table_name, primary_key, seek, write});
+        }
+    }
+
+    inline chain& get_chain() {
+        return *current_chain;
+    }
+
+    inline action_context& context() {
+        check(current_context != nullptr, "no action is executing");
+        return *current_context;
+    }
+
+    //return value of the last top level action
+    inline std::vector<char>& last_return_value() {
+        static thread_local std::vector<char> value;
+        return value;
+    }
+
+    inline void chain::set_row(name code, uint64_t scope, name table_name, uint64_t primary_key, const row* r) {
+        auto& t = get_table(code, scope, table_name);
+        std::unique_lock<std::shared_mutex> lock(t.mutex);
+        auto itr = t.rows.find(primary_key);
+        bool was_empty = t.rows.empty();
+
+        //save old row for rollback
+        if (current_undo) {
+            std::optional<row> old_row;
+            if (itr != t.rows.end()) {
+                old_row = itr->second;
+            }
+            current_undo->push_back(undo_entry{code, scope, table_name, primary_key, std::move(old_row)});
+        }
+
+        //refund old row
+        if (itr != t.rows.end()) {
+            bill(itr->second.payer, -(int64_t(itr->second.data.size()) + billable_row_overhead));
+        }
+
+        if (row_observer) {
+            row_observer(code, scope, table_name, primary_key, itr != t.rows.end() ? &itr->second : nullptr, r);
+        }
+
+        //write or remove row
+        if (r) {
+            bill(r->payer, int64_t(r->data.size()) + billable_row_overhead);
+            t.rows[primary_key] = *r;
+        } else if (itr != t.rows.end()) {
+            t.rows.erase(itr);
+        }
+
+        //bill table scope to the payer of its first row
+        if (was_empty && !t.rows.empty()) {
+            t.payer = r->payer;
+            bill(t.payer, billable_table_overhead);
+        } else if (!was_empty && t.rows.empty()) {
+            bill(t.payer, -billable_table_overhead);
+        }
+    }
+
+    inline std::vector<char> chain::push_transaction(const std::vector<action_data>& actions, std::optional<time_point> block_time) {
+        std::vector<undo_entry> undo;
+        auto* prev_chain = current_chain;
+        auto* prev_undo = current_undo;
+        auto prev_block_time = current_block_time;
+        current_chain = this;
+        current_undo = &undo;
+        current_block_time = block_time;
+
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            console.clear();
+        }
+
+        std::vector<char> result;
+        try {
+            for (auto& act : actions) {
+                result = {};
+                apply(act, act.account, 0);
+                result.swap(last_return_value());
+            }
+        } catch (...) {
+            //roll back in reverse order without recording
+            current_undo = nullptr;
+            for (auto itr = undo.rbegin(); itr != undo.rend(); ++itr) {
+                set_row(itr->code, itr->scope, itr->table_name, itr->primary_key, itr->old_row ? &*itr->old_row : nullptr);
+            }
+            current_undo = prev_undo;
+            current_chain = prev_chain;
+            current_block_time = prev_block_time;
+            throw;
+        }
+
+        current_undo = prev_undo;
+        current_chain = prev_chain;
+        current_block_time = prev_block_time;
+        return result;
+    }
+
+    inline void chain::apply(const action_data& act, name receiver, uint32_t depth) {
+        check(depth <= max_inline_action_depth, "max inline action depth exceeded");
+
+        action_context ctx;
+        ctx.receiver = receiver;
+        ctx.act = &act;
+
+        auto* prev_context = current_context;
+        current_context = &ctx;
+        try {
+            auto handler = contracts.find(receiver.value);
+            if (handler != contracts.end()) {
+                handler->second(receiver.value, act.account.value, act.name.value);
+            }
+        } catch (...) {
+            current_context = prev_context;
+            throw;
+        }
+        current_context = prev_context;
+
+        //only the original receiver's return value is reported
+        if (depth == 0 && receiver == act.account) {
+            last_return_value() = ctx.return_value;
+        }
+
+        //notifications run before inline actions
+        for (auto notify : ctx.notified) {
+            stats.notifications += 1;
+            apply(act, notify, depth);
+        }
+
+        //inline actions may only use the sending contract's permissions
+        for (auto& inline_act : ctx.inline_actions) {
+            stats.inline_actions += 1;
+            for (auto& auth : inline_act.authorization) {
+                check(auth.actor == receiver, "inline action authorized by " + auth.actor.to_string() + " from " + receiver.to_string());
+            }
+            apply(inline_act, inline_act.account, depth + 1);
+        }
+    }
+
+}
+
+namespace eosio {
+
+    //======================== intrinsics ========================
+
+    inline time_point current_time_point() {
+        return host::current_block_time ? *host::current_block_time : host::get_chain().now;
+    }
+
+    inline void action::send() const {
+        host::context().inline_actions.push_back(host::action_data{account, name, authorization, data});
+    }
+
+    inline bool has_auth(name n) {
+        host::stats.auth_checks += 1;
+        for (auto& auth : host::context().act->authorization) {
+            if (auth.actor == n) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void require_auth(name n) {
+        check(has_auth(n), "missing authority of " + n.to_string());
+    }
+
+    inline void require_auth(const permission_level& level) {
+        host::stats.auth_checks += 1;
+        for (auto& auth : host::context().act->authorization) {
+            if (auth == level) {
+                return;
+            }
+        }
+        check(false, "missing authority of " + level.actor.to_string() + "@" + level.permission.to_string());
+    }
+
+    inline bool is_account(name n) {
+        return host::get_chain().is_account(n);
+    }
+
+    inline void require_recipient(name notify_account) {
+        auto& ctx = host::context();
+        if (notify_account == ctx.receiver) {
+            return;
+        }
+        for (auto& n : ctx.notified) {
+            if (n == notify_account) {
+                return;
+            }
+        }
+        ctx.notified.push_back(notify_account);
+    }
+
+    inline name current_receiver() {
+        return host::context().receiver;
+    }
+
+}
@@ -0,0 +1,13 @@
+// Native stand-in for eosio.cdt's ignore wrapper.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+namespace eosio {
+
+    //marks an action parameter the dispatcher should not deserialize
+    template<typename T>
+    struct ignore {};
+
+}
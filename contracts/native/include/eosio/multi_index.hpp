@@ -0,0 +1,304 @@
+// Native stand-in for eosio.cdt's multi_index.
+//
+// Keeps the same object cache semantics as the chain version: a row is
+// deserialized once per table instance, references stay valid until the row
+// is erased, and cache hits cost no database intrinsics.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+
+#include <eosio/check.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/host.hpp>
+#include <eosio/name.hpp>
+
+namespace eosio {
+
+    constexpr name same_payer{};
+
+    template<name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+
+        static_assert(sizeof...(Indices) == 0, "secondary indices are not supported by the native host");
+
+    public:
+
+        class const_iterator {
+
+        public:
+
+            const_iterator() {}
+
+            const T& operator*() const {
+                check(_item != nullptr, "cannot dereference end iterator");
+                return *_item;
+            }
+
+            const T* operator->() const {
+                check(_item != nullptr, "cannot dereference end iterator");
+                return _item;
+            }
+
+            const_iterator& operator++() {
+                check(_item != nullptr, "cannot increment end iterator");
+                *this = _multidx->next(_item->primary_key());
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator result = *this;
+                ++(*this);
+                return result;
+            }
+
+            const_iterator& operator--() {
+                *this = _item ? _multidx->previous(_item->primary_key()) : _multidx->last();
+                check(_item != nullptr, "cannot decrement iterator at beginning of table");
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator result = *this;
+                --(*this);
+                return result;
+            }
+
+            friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._item == b._item; }
+            friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._item != b._item; }
+
+        private:
+
+            friend class multi_index;
+
+            const_iterator(const multi_index* idx, const T* item = nullptr) : _multidx(idx), _item(item) {}
+
+            const multi_index* _multidx = nullptr;
+            const T* _item = nullptr;
+        };
+
+        multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+        multi_index(const multi_index&) = delete;
+
+        name get_code() const { return _code; }
+
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator begin() const { return lower_bound(std::numeric_limits<uint64_t>::lowest()); }
+
+        const_iterator cbegin() const { return begin(); }
+
+        const_iterator end() const { return const_iterator(this); }
+
+        const_iterator cend() const { return end(); }
+
+        const_iterator find(uint64_t primary) const {
+            //cache hits cost nothing
+            auto cached = _items.find(primary);
+            if (cached != _items.end()) {
+                return const_iterator(this, cached->second.get());
+            }
+
+            host::stats.db_find += 1;
+            host::record_access(_code, _scope, name(TableName), primary, false, false);
+            if (!contains(primary)) {
+                return end();
+            }
+            return const_iterator(this, load(primary));
+        }
+
+        const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+            auto result = find(primary);
+            check(result != end(), error_msg);
+            return *result;
+        }
+
+        const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const {
+            auto result = find(primary);
+            check(result != end(), error_msg);
+            return result;
+        }
+
+        const_iterator lower_bound(uint64_t primary) const {
+            host::stats.db_lowerbound += 1;
+            host::record_access(_code, _scope, name(TableName), primary, true, false);
+            auto key = find_key(primary, [](auto& rows, uint64_t k) { return rows.lower_bound(k); });
+            return key ? const_iterator(this, load(*key)) : end();
+        }
+
+        const_iterator upper_bound(uint64_t primary) const {
+            host::stats.db_upperbound += 1;
+            host::record_access(_code, _scope, name(TableName), primary, true, false);
+            auto key = find_key(primary, [](auto& rows, uint64_t k) { return rows.upper_bound(k); });
+            return key ? const_iterator(this, load(*key)) : end();
+        }
+
+        uint64_t available_primary_key() const {
+            auto itr = last();
+            return itr == end() ? 0 : itr->primary_key() + 1;
+        }
+
+        template<typename Lambda>
+        const_iterator emplace(name payer, Lambda&& constructor) {
+            check(_code == current_receiver(), "cannot create objects in table of another contract");
+
+            auto obj = std::make_unique<T>();
+            constructor(*obj);
+            uint64_t pk = obj->primary_key();
+
+            check(!contains(pk), "could not insert object, most likely a uniqueness constraint was violated");
+
+            host::row r{payer, pack(*obj)};
+            host::stats.db_store += 1;
+            host::record_access(_code, _scope, name(TableName), pk, false, true);
+            host::stats.bytes_packed += r.data.size();
+            host::get_chain().set_row(_code, _scope, name(TableName), pk, &r);
+
+            auto* item = obj.get();
+            _items[pk] = std::move(obj);
+            return const_iterator(this, item);
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda&& updater) {
+            check(itr != end(), "cannot pass end iterator to modify");
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template<typename Lambda>
+        void modify(const T& obj, name payer, Lambda&& updater) {
+            check(_code == current_receiver(), "cannot modify objects in table of another contract");
+
+            auto& mutableobj = const_cast<T&>(obj);
+            uint64_t pk = obj.primary_key();
+            updater(mutableobj);
+            check(pk == obj.primary_key(), "updater cannot change primary key when modifying an object");
+
+            //same_payer keeps the current payer
+            if (payer == same_payer) {
+                auto* t = table();
+                check(t != nullptr, "object passed to modify is not in multi_index");
+                std::shared_lock<std::shared_mutex> lock(t->mutex);
+                auto itr = t->rows.find(pk);
+                check(itr != t->rows.end(), "object passed to modify is not in multi_index");
+                payer = itr->second.payer;
+            } else {
+                check(contains(pk), "object passed to modify is not in multi_index");
+            }
+            host::row r{payer, pack(obj)};
+            host::stats.db_update += 1;
+            host::record_access(_code, _scope, name(TableName), pk, false, true);
+            host::stats.bytes_packed += r.data.size();
+            host::get_chain().set_row(_code, _scope, name(TableName), pk, &r);
+        }
+
+        const_iterator erase(const_iterator itr) {
+            check(itr != end(), "cannot pass end iterator to erase");
+            const T& obj = *itr;
+            ++itr;
+            erase(obj);
+            return itr;
+        }
+
+        void erase(const T& obj) {
+            check(_code == current_receiver(), "cannot erase objects in table of another contract");
+
+            uint64_t pk = obj.primary_key();
+            host::stats.db_remove += 1;
+            host::record_access(_code, _scope, name(TableName), pk, false, true);
+            host::get_chain().set_row(_code, _scope, name(TableName), pk, nullptr);
+            _items.erase(pk);
+        }
+
+    private:
+
+        host::table* table() const {
+            return host::get_chain().find_table(_code, _scope, name(TableName));
+        }
+
+        bool contains(uint64_t primary) const {
+            auto* t = table();
+            if (!t) {
+                return false;
+            }
+            std::shared_lock<std::shared_mutex> lock(t->mutex);
+            return t->rows.count(primary) > 0;
+        }
+
+        //key of the row seek(rows, primary) lands on, read under the table lock
+        template<typename Seek>
+        std::optional<uint64_t> find_key(uint64_t primary, Seek&& seek) const {
+            auto* t = table();
+            if (!t) {
+                return std::nullopt;
+            }
+            std::shared_lock<std::shared_mutex> lock(t->mutex);
+            auto itr = seek(t->rows, primary);
+            return itr == t->rows.end() ? std::nullopt : std::optional<uint64_t>(itr->first);
+        }
+
+        //deserializes a row into the cache on first access
+        const T* load(uint64_t primary) const {
+            auto cached = _items.find(primary);
+            if (cached != _items.end()) {
+                return cached->second.get();
+            }
+
+            auto obj = std::make_unique<T>();
+            {
+                auto* t = table();
+                std::shared_lock<std::shared_mutex> lock(t->mutex);
+                auto& data = t->rows.at(primary).data;
+                host::stats.db_get += 1;
+                host::stats.bytes_unpacked += data.size();
+
+                datastream<const char*> ds(data.data(), data.size());
+                ds >> *obj;
+            }
+
+            auto* item = obj.get();
+            _items[primary] = std::move(obj);
+            return item;
+        }
+
+        const_iterator next(uint64_t primary) const {
+            host::stats.db_next += 1;
+            host::record_access(_code, _scope, name(TableName), primary, true, false);
+            auto key = find_key(primary, [](auto& rows, uint64_t k) { return rows.upper_bound(k); });
+            return key ? const_iterator(this, load(*key)) : end();
+        }
+
+        const_iterator previous(uint64_t primary) const {
+            host::stats.db_previous += 1;
+            host::record_access(_code, _scope, name(TableName), primary, true, false);
+            auto key = find_key(primary, [](auto& rows, uint64_t k) {
+                auto itr = rows.lower_bound(k);
+                return itr == rows.begin() ? rows.end() : --itr;
+            });
+            return key ? const_iterator(this, load(*key)) : end();
+        }
+
+        const_iterator last() const {
+            host::stats.db_end += 1;
+            host::record_access(_code, _scope, name(TableName), 0, true, false);
+            auto key = find_key(0, [](auto& rows, uint64_t) { return rows.empty() ? rows.end() : std::prev(rows.end()); });
+            if (!key) {
+                return end();
+            }
+            host::stats.db_previous += 1;
+            return const_iterator(this, load(*key));
+        }
+
+        name _code;
+        uint64_t _scope;
+        mutable std::map<uint64_t, std::unique_ptr<T>> _items;
+    };
+
+}
@@ -0,0 +1,52 @@
+// Native stand-in for eosio.cdt's print().
+//
+// Output goes to the host chain's console, and to stdout when echo_console
+// is set.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+#include <eosio/host.hpp>
+#include <eosio/name.hpp>
+
+namespace eosio {
+
+    namespace detail {
+
+        inline void print_str(const std::string& s) {
+            auto& c = host::get_chain();
+            c.append_console(s);
+            if (c.echo_console) {
+                fputs(s.c_str(), stdout);
+            }
+        }
+
+        inline void print_one(const char* s) { print_str(s); }
+
+        inline void print_one(const std::string& s) { print_str(s); }
+
+        inline void print_one(name n) { print_str(n.to_string()); }
+
+        inline void print_one(bool b) { print_str(b ? "true" : "false"); }
+
+        inline void print_one(char c) { print_str(std::string(1, c)); }
+
+        template<typename T, std::enable_if_t<std::is_arithmetic_v<T>>* = nullptr>
+        void print_one(T v) { print_str(std::to_string(v)); }
+
+        template<typename T, std::enable_if_t<!std::is_arithmetic_v<T>>* = nullptr, typename = decltype(std::declval<T>().to_string())>
+        void print_one(const T& v) { print_str(v.to_string()); }
+
+    }
+
+    template<typename... Args>
+    void print(Args&&... args) {
+        (detail::print_one(std::forward<Args>(args)), ...);
+    }
+
+}
@@ -0,0 +1,31 @@
+// Native stand-in for eosio.cdt's EOSLIB_SERIALIZE.
+//
+// Walks the member sequence with plain preprocessor recursion instead of
+// Boost.Preprocessor so the host build has no extra dependencies.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#define EOSIO_NATIVE_CAT(a, b) EOSIO_NATIVE_CAT_I(a, b)
+#define EOSIO_NATIVE_CAT_I(a, b) a ## b
+
+#define EOSIO_NATIVE_OUT_A(member) << t.member EOSIO_NATIVE_OUT_B
+#define EOSIO_NATIVE_OUT_B(member) << t.member EOSIO_NATIVE_OUT_A
+#define EOSIO_NATIVE_OUT_A_END
+#define EOSIO_NATIVE_OUT_B_END
+
+#define EOSIO_NATIVE_IN_A(member) >> t.member EOSIO_NATIVE_IN_B
+#define EOSIO_NATIVE_IN_B(member) >> t.member EOSIO_NATIVE_IN_A
+#define EOSIO_NATIVE_IN_A_END
+#define EOSIO_NATIVE_IN_B_END
+
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS) \
+    template<typename DataStream> \
+    friend DataStream& operator<<(DataStream& ds, const TYPE& t) { \
+        return ds EOSIO_NATIVE_CAT(EOSIO_NATIVE_OUT_A MEMBERS, _END); \
+    } \
+    template<typename DataStream> \
+    friend DataStream& operator>>(DataStream& ds, TYPE& t) { \
+        return ds EOSIO_NATIVE_CAT(EOSIO_NATIVE_IN_A MEMBERS, _END); \
+    }
@@ -0,0 +1,87 @@
+// Native stand-in for eosio.cdt's time types.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <cstdint>
+
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+    class microseconds {
+
+    public:
+
+        explicit microseconds(int64_t c = 0) : _count(c) {}
+
+        int64_t count() const { return _count; }
+
+        friend microseconds operator+(const microseconds& l, const microseconds& r) { return microseconds(l._count + r._count); }
+        friend microseconds operator-(const microseconds& l, const microseconds& r) { return microseconds(l._count - r._count); }
+        friend bool operator==(const microseconds& l, const microseconds& r) { return l._count == r._count; }
+        friend bool operator<(const microseconds& l, const microseconds& r) { return l._count < r._count; }
+
+        int64_t _count;
+
+        EOSLIB_SERIALIZE(microseconds, (_count))
+    };
+
+    inline microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+
+    class time_point {
+
+    public:
+
+        explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+
+        const microseconds& time_since_epoch() const { return elapsed; }
+
+        uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+        time_point& operator+=(const microseconds& m) { elapsed = elapsed + m; return *this; }
+
+        friend time_point operator+(const time_point& t, const microseconds& m) { return time_point(t.elapsed + m); }
+        friend bool operator==(const time_point& l, const time_point& r) { return l.elapsed == r.elapsed; }
+        friend bool operator<(const time_point& l, const time_point& r) { return l.elapsed < r.elapsed; }
+
+        microseconds elapsed;
+
+        EOSLIB_SERIALIZE(time_point, (elapsed))
+    };
+
+    class time_point_sec {
+
+    public:
+
+        time_point_sec() : utc_seconds(0) {}
+
+        explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+
+        time_point_sec(const time_point& t) : utc_seconds(t.sec_since_epoch()) {}
+
+        uint32_t sec_since_epoch() const { return utc_seconds; }
+
+        operator time_point() const { return time_point(seconds(utc_seconds)); }
+
+        time_point_sec& operator+=(uint32_t m) { utc_seconds += m; return *this; }
+
+        friend time_point_sec operator+(const time_point_sec& t, uint32_t offset) { return time_point_sec(t.utc_seconds + offset); }
+        friend time_point_sec operator-(const time_point_sec& t, uint32_t offset) { return time_point_sec(t.utc_seconds - offset); }
+        friend bool operator==(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds == b.utc_seconds; }
+        friend bool operator!=(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds != b.utc_seconds; }
+        friend bool operator<(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds < b.utc_seconds; }
+        friend bool operator<=(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds <= b.utc_seconds; }
+        friend bool operator>(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds > b.utc_seconds; }
+        friend bool operator>=(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds >= b.utc_seconds; }
+
+        uint32_t utc_seconds;
+
+        EOSLIB_SERIALIZE(time_point_sec, (utc_seconds))
+    };
+
+    //reads the host's block time
+    time_point current_time_point();
+
+}
@@ -0,0 +1,8 @@
+// Native stand-in for eosio.cdt's transaction.hpp. Deferred transactions are
+// not modelled, only inline actions.
+//
+// @copyright defined in LICENSE.txt
+
+#pragma once
+
+#include <eosio/action.hpp>